@@ -0,0 +1,173 @@
+/*
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file dw1000_bulk.h
+ * @date 2026
+ * @brief bulk transfer
+ *
+ * @details This is the bulk transfer service, it moves a memory blob such as a configuration block or firmware image
+ * to a peer in windows of data chunks. Each window ends with a selective acknowledgement from the receiver and only
+ * the missing chunks are sent again. A window is bounded in time, see dw1000_bulk_window_duration, so it can be
+ * scheduled inside a TDMA slot alongside ranging.
+ *
+ */
+
+#ifndef _DW1000_BULK_H_
+#define _DW1000_BULK_H_
+
+#include <stdlib.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <hal/hal_spi.h>
+#include <dw1000/dw1000_regs.h>
+#include <dw1000/dw1000_dev.h>
+#include <dw1000/dw1000_ftypes.h>
+
+#define DW1000_BULK_WINDOW_MAX  (32)        //!< Chunks tracked by the selective acknowledgement bitmap
+
+//! Bulk transfer frame codes
+typedef enum _dw1000_bulk_codes_t{
+    DWT_BULK_QUERY = 1,             //!< Request the receiver state, starts or resumes a transfer
+    DWT_BULK_DATA,                  //!< Data chunk
+    DWT_BULK_DATA_LAST,             //!< Last data chunk of a window, requests a SACK
+    DWT_BULK_SACK,                  //!< Selective acknowledgement
+}dw1000_bulk_codes_t;
+
+//! Bulk transfer status
+typedef struct _dw1000_bulk_status_t{
+    uint16_t selfmalloc:1;          //!< Internal flag for memory garbage collection
+    uint16_t initialized:1;         //!< Instance allocated
+    uint16_t start_tx_error:1;      //!< Start transmit error
+    uint16_t window_pending:1;      //!< A window is in flight, sem is held until its SACK, timeout or error
+    uint16_t resync:1;              //!< Next window queries the receiver state instead of sending data
+    uint16_t suspended:1;           //!< max_retries windows went unanswered, see dw1000_bulk_resume
+    uint16_t tx_complete:1;         //!< All chunks of the outbound transfer acknowledged
+    uint16_t rx_complete:1;         //!< All chunks of the inbound transfer received
+}dw1000_bulk_status_t;
+
+//! Bulk transfer configuration parameters, both ends must use the same chunk_len
+typedef struct _dw1000_bulk_config_t{
+   uint32_t tx_holdoff_delay;       //!< RMARKER to RMARKER spacing of frames, in UWB usec. Floored at dw1000_phy_turnaround_time, 0 for the PHY minimum.
+   uint16_t rx_timeout_period;      //!< SACK timeout, in UWB usec. Floored at the airtime derived timeout.
+   uint16_t chunk_len;              //!< Payload bytes per data frame. Frames above 127 bytes need DWT_PHRMODE_EXT.
+   uint8_t window;                  //!< Chunks sent per window, 1 to DW1000_BULK_WINDOW_MAX
+   uint8_t max_retries;             //!< Unanswered windows before the transfer is suspended
+   uint16_t postprocess:1;          //!< Postprocess on completion
+}dw1000_bulk_config_t;
+
+//! Bulk transfer counters
+typedef struct _dw1000_bulk_stats_t{
+    uint32_t tx_chunks;             //!< Data frames sent, including retransmissions
+    uint32_t tx_windows;            //!< Windows answered by a SACK
+    uint32_t sack_timeouts;         //!< Windows without SACK
+    uint32_t rx_chunks;             //!< Chunks delivered to the rx callback
+    uint32_t rx_duplicates;         //!< Chunks received again after delivery
+    uint32_t rx_crc_errors;         //!< Chunks dropped on a payload CRC mismatch
+    uint32_t rx_out_of_window;      //!< Chunks dropped outside the current transfer or SACK window
+}dw1000_bulk_stats_t;
+
+//! Bulk data frame, the chunk payload follows the header. The header fits DW1000_MAC_CB_HEADER_LEN.
+typedef union {
+    struct _bulk_data_frame_t{
+        struct _ieee_std_frame_t;
+        uint8_t xfer_id;            //!< Transfer identifier
+        uint16_t chunk;             //!< Chunk index
+        uint16_t crc;               //!< CRC16-CCITT of the chunk payload
+    }__attribute__((__packed__,aligned(1)));
+    uint8_t array[sizeof(struct _bulk_data_frame_t)]; //!< Array of size bulk data frame
+}bulk_data_frame_t;
+
+//! Bulk query and SACK frame
+typedef union {
+    struct _bulk_ctrl_frame_t{
+        struct _ieee_std_frame_t;
+        uint8_t xfer_id;            //!< Transfer identifier
+        uint16_t base;              //!< First chunk not yet received
+        uint16_t nchunks;           //!< Number of chunks in the transfer
+        uint32_t bitmap;            //!< Bit n set when chunk base + n has been received
+    }__attribute__((__packed__,aligned(1)));
+    uint8_t array[sizeof(struct _bulk_ctrl_frame_t)]; //!< Array of size bulk control frame
+}bulk_ctrl_frame_t;
+
+//! Outbound transfer state
+typedef struct _dw1000_bulk_tx_t{
+    const uint8_t * data;           //!< Blob being sent
+    uint32_t len;                   //!< Length of the blob
+    uint16_t dst_address;           //!< Receiver short address
+    uint8_t xfer_id;                //!< Transfer identifier
+    uint16_t nchunks;               //!< Number of chunks in the transfer
+    uint16_t base;                  //!< First chunk not acknowledged
+    uint32_t bitmap;                //!< Acknowledged chunks above base, as last reported
+    uint8_t next;                   //!< Bitmap position to resume the scan for the next chunk of the window
+    uint8_t burst;                  //!< Chunks sent in the current window
+    uint8_t retries;                //!< Consecutive unanswered windows
+    uint16_t frame_len;             //!< Length of the last data frame sent
+}dw1000_bulk_tx_t;
+
+//! Inbound transfer state
+typedef struct _dw1000_bulk_rx_t{
+    uint16_t src_address;           //!< Sender short address
+    uint8_t xfer_id;                //!< Transfer identifier
+    uint8_t valid:1;                //!< A transfer has been announced by a query
+    uint16_t nchunks;               //!< Number of chunks in the transfer
+    uint16_t base;                  //!< First chunk not yet received
+    uint32_t bitmap;                //!< Received chunks above base
+}dw1000_bulk_rx_t;
+
+//! Chunk delivery callback, runs in the interrupt task for every new chunk that passed its CRC
+typedef void dw1000_bulk_rx_cb_t(struct _dw1000_dev_instance_t * inst, uint8_t xfer_id, uint32_t offset, const uint8_t * payload, uint16_t len);
+
+//! Bulk transfer instance
+typedef struct _dw1000_bulk_instance_t{
+    struct _dw1000_dev_instance_t * parent;            //!< Device instance structure
+    struct os_sem sem;                                 //!< Held while a window is in flight
+    dw1000_bulk_status_t status;                       //!< Bulk transfer status
+    dw1000_bulk_config_t config;                       //!< Bulk transfer configuration parameters
+    dw1000_bulk_stats_t stats;                         //!< Bulk transfer counters
+    struct os_callout bulk_callout_postprocess;        //!< Bulk_callout_postprocess
+    dw1000_bulk_rx_cb_t * rx_cb;                       //!< Chunk delivery callback
+    dw1000_bulk_tx_t tx;                               //!< Outbound transfer state
+    dw1000_bulk_rx_t rx;                               //!< Inbound transfer state
+    uint8_t seq_num;                                   //!< Sequence number of the last frame sent
+    bulk_data_frame_t data;                            //!< Data frame header under construction
+    bulk_ctrl_frame_t ctrl;                            //!< Query or SACK frame under construction
+    uint8_t buf[];                                     //!< Received chunk payload, config.chunk_len bytes
+}dw1000_bulk_instance_t;
+
+dw1000_bulk_instance_t * dw1000_bulk_init(dw1000_dev_instance_t * inst, dw1000_bulk_config_t config);
+void dw1000_bulk_free(dw1000_dev_instance_t * inst);
+void dw1000_bulk_set_ext_callbacks(dw1000_dev_instance_t * inst, dw1000_extension_callbacks_t bulk_cbs);
+void dw1000_bulk_set_postprocess(dw1000_dev_instance_t * inst, os_event_fn * bulk_postprocess);
+void dw1000_bulk_set_rx_cb(dw1000_dev_instance_t * inst, dw1000_bulk_rx_cb_t * rx_cb);
+dw1000_bulk_status_t dw1000_bulk_write(dw1000_dev_instance_t * inst, uint16_t dst_address, uint8_t xfer_id, const uint8_t * data, uint32_t len);
+dw1000_bulk_status_t dw1000_bulk_window(dw1000_dev_instance_t * inst, dw1000_dev_modes_t mode);
+void dw1000_bulk_resume(dw1000_dev_instance_t * inst);
+uint32_t dw1000_bulk_window_duration(dw1000_dev_instance_t * inst);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* _DW1000_BULK_H_ */
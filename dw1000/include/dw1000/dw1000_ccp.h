@@ -46,10 +46,17 @@ extern "C" {
 #if MYNEWT_VAL(CLOCK_CALIBRATION_ENABLED)
 #include <clkcal/clkcal.h>    
 #endif
+#if MYNEWT_VAL(DW1000_CCP_EXT_SYNC)
+#include <os/os_cputime.h>
+#endif
 #if MYNEWT_VAL(FS_XTALT_AUTOTUNE_ENABLED)
+#if MYNEWT_VAL(DW1000_DSP_FIXEDPOINT)
+#include <dw1000/dw1000_dsp.h>
+#else
 #include <dsp/sosfilt.h>
 #include <dsp/polyval.h>
 #endif
+#endif
 
 //! Timestamps and blink frame of ccp frame
 typedef union {
@@ -71,6 +78,10 @@ typedef struct _dw1000_ccp_status_t{
     uint16_t valid:1;                 //!< Set for valid parameters 
     uint16_t start_tx_error:1;        //!< Set for start transmit error 
     uint16_t timer_enabled:1;         //!< Indicates timer is enabled 
+#if MYNEWT_VAL(DW1000_CCP_EXT_SYNC)
+    uint16_t ext_sync:1;              //!< Wired sync enabled
+    uint16_t ext_sync_locked:1;       //!< Timebase reset by the sync signal every period, blinks not used
+#endif
 }dw1000_ccp_status_t;
 
 //! ccp config structure of postprocess 
@@ -86,7 +97,15 @@ typedef struct _dw1000_ccp_instance_t{
     struct _clkcal_instance_t * clkcal;         //!< Wireless clock calibration 
 #endif
 #if MYNEWT_VAL(FS_XTALT_AUTOTUNE_ENABLED)
+#if MYNEWT_VAL(DW1000_DSP_FIXEDPOINT)
+    struct _dw1000_sos_q31_instance_t * xtalt_sos;  //!< XTALT offset filter, ppm in Q16
+#else
     struct _sos_instance_t * xtalt_sos;        //!< Sturcture of xtalt_sos 
+#endif
+#endif
+#if MYNEWT_VAL(ADAPTIVE_TIMESCALE_ENABLED)
+    double skew;                                //!< clkcal skew that skew_q40 was derived from
+    int32_t skew_q40;                           //!< clkcal skew less unity, signed Q40, applied by the timestamp readers
 #endif
     struct os_sem sem;                          //!< Structure containing os semaphores
     struct os_callout callout_timer;            //!< Structure of callout_timer
@@ -94,6 +113,15 @@ typedef struct _dw1000_ccp_instance_t{
     dw1000_ccp_status_t status;                 //!< DW1000 ccp status parameters
     dw1000_ccp_config_t config;                 //!< DW1000 ccp config parameters 
     uint32_t period;                            //!< Pulse repetition period
+#if MYNEWT_VAL(DW1000_CCP_EXT_SYNC)
+    struct hal_timer ext_sync_timer;            //!< Wired sync check timer
+    struct os_event ext_sync_ev;                //!< Wired sync check event
+    uint64_t ext_sync_systime;                  //!< System time when the timebase reset was last armed
+    uint32_t ext_sync_cputime;                  //!< CPU time when the timebase reset was last armed
+    uint32_t ext_sync_offset;                   //!< Sync edge to timebase zero, in device time units
+    uint8_t ext_sync_wait;                      //!< Wait counter, 38.4 MHz cycles from sync edge to reset
+    uint8_t ext_sync_misses;                    //!< Consecutive periods without a timebase reset
+#endif
     uint16_t nframes;                           //!< Number of buffers defined to store the data 
     uint16_t idx;                               //!< Indicates number of DW1000 instances 
     ccp_frame_t * frames[];                     //!< Buffers to ccp frames 
@@ -105,6 +133,10 @@ void dw1000_ccp_set_ext_callbacks(dw1000_dev_instance_t * inst, dw1000_extension
 void dw1000_ccp_set_postprocess(dw1000_ccp_instance_t * inst, os_event_fn * ccp_postprocess); 
 void dw1000_ccp_start(dw1000_dev_instance_t * inst);
 void dw1000_ccp_stop(dw1000_dev_instance_t * inst);
+#if MYNEWT_VAL(DW1000_CCP_EXT_SYNC)
+void dw1000_ccp_ext_sync_start(dw1000_dev_instance_t * inst, uint8_t wait, uint32_t delay);
+void dw1000_ccp_ext_sync_stop(dw1000_dev_instance_t * inst);
+#endif
 
 #ifdef __cplusplus
 }
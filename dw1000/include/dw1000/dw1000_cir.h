@@ -0,0 +1,125 @@
+/*
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file dw1000_cir.h
+ * @date 2026
+ * @brief channel impulse response capture
+ *
+ * @details This is the CIR capture service. For frames selected by the capture policy, a window of accumulator taps
+ * around the first path reported in the receive diagnostics is read out of ACC_MEM and handed, together with the frame
+ * timestamp and diagnostics, to an output callback. Two capture buffers alternate between the interrupt task, which
+ * fills one, and the default event queue, which exports the other.
+ *
+ */
+
+#ifndef _DW1000_CIR_H_
+#define _DW1000_CIR_H_
+
+#include <stdlib.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <hal/hal_spi.h>
+#include <dw1000/dw1000_regs.h>
+#include <dw1000/dw1000_dev.h>
+
+#define DW1000_CIR_SYNC         (0xC1A5)    //!< Leading word of every record, lets the host resynchronise on a byte stream
+#define DW1000_CIR_TAP_LEN      (4)         //!< Bytes per accumulator tap, 16-bit real then 16-bit imaginary part
+#define DW1000_CIR_TAPS_PRF16   (992)       //!< Accumulator taps at 16 MHz PRF
+#define DW1000_CIR_TAPS_PRF64   (1016)      //!< Accumulator taps at 64 MHz PRF
+
+//! CIR capture status
+typedef struct _dw1000_cir_status_t{
+    uint16_t selfmalloc:1;          //!< Internal flag for memory garbage collection
+    uint16_t initialized:1;         //!< Instance allocated
+}dw1000_cir_status_t;
+
+//! CIR capture policy, a frame is captured when it passes every enabled test
+typedef struct _dw1000_cir_config_t{
+    uint16_t pre;                   //!< Taps captured ahead of the first path
+    uint16_t post;                  //!< Taps captured from the first path on, pre + post up to DW1000_CIR_MAX_TAPS
+    uint16_t every_nth;             //!< Capture one in every_nth eligible frames, 0 or 1 for all of them
+    uint16_t src_address;           //!< Capture only frames from this 16-bit source address, 0xFFFF for any source
+    uint16_t fp_snr_max;            //!< Capture only frames with fp_amp below fp_snr_max times rx_std, 0 to disable
+}dw1000_cir_config_t;
+
+//! CIR capture counters
+typedef struct _dw1000_cir_stats_t{
+    uint32_t captured;              //!< Records handed to the output callback
+    uint32_t dropped;               //!< Captures skipped because both buffers were busy
+}dw1000_cir_stats_t;
+
+//! Capture record header, ntaps taps of DW1000_CIR_TAP_LEN bytes follow. Multi-byte fields are little endian.
+typedef struct _dw1000_cir_record_t{
+    uint16_t sync;                  //!< DW1000_CIR_SYNC
+    uint16_t ntaps;                 //!< Taps that follow this header
+    uint16_t first_tap;             //!< Accumulator index of the first tap
+    uint16_t fp_idx;                //!< First path index, 10.6 fixed point
+    uint8_t rx_timestamp[5];        //!< 40-bit RX timestamp, in device time units
+    uint8_t seq_num;                //!< Sequence number of the frame, 16-bit address frames only
+    uint16_t src_address;           //!< Source address of the frame, 0xFFFF unless a 16-bit address frame
+    uint16_t fp_amp;                //!< Amplitude at floor(fp_idx) + 1
+    uint16_t fp_amp2;               //!< Amplitude at floor(fp_idx) + 2
+    uint16_t fp_amp3;               //!< Amplitude at floor(fp_idx) + 3
+    uint16_t rx_std;                //!< Standard deviation of noise
+    uint16_t cir_pwr;               //!< Channel impulse response power
+    uint16_t pacc_cnt;              //!< Preamble symbols accumulated
+    uint16_t dropped;               //!< Captures dropped since the previous record
+}__attribute__((__packed__,aligned(1))) dw1000_cir_record_t;
+
+//! One capture buffer
+typedef struct _dw1000_cir_buffer_t{
+    dw1000_cir_record_t record;                                             //!< Record header
+    uint8_t taps[MYNEWT_VAL(DW1000_CIR_MAX_TAPS) * DW1000_CIR_TAP_LEN];     //!< Captured taps
+}__attribute__((__packed__,aligned(1))) dw1000_cir_buffer_t;
+
+//! Record output callback, runs in the default event queue task
+typedef void dw1000_cir_output_cb_t(struct _dw1000_dev_instance_t * inst, const uint8_t * record, uint16_t len);
+
+//! CIR capture instance
+typedef struct _dw1000_cir_instance_t{
+    struct _dw1000_dev_instance_t * parent;         //!< Device instance structure
+    dw1000_cir_status_t status;                     //!< CIR capture status
+    dw1000_cir_config_t config;                     //!< CIR capture policy
+    dw1000_cir_stats_t stats;                       //!< CIR capture counters
+    struct os_callout cir_callout_postprocess;      //!< Exports a filled buffer
+    dw1000_cir_output_cb_t * output_cb;             //!< Record output callback
+    uint16_t eligible;                              //!< Frames passing the source and quality tests, for every_nth
+    uint16_t dropped;                               //!< Captures dropped since the last record
+    volatile uint8_t busy;                          //!< Bit n set while buffer n awaits export
+    uint8_t fill;                                   //!< Buffer the next capture goes to
+    uint8_t drain;                                  //!< Buffer exported next
+    dw1000_cir_buffer_t buffers[2];                 //!< Capture buffers
+}dw1000_cir_instance_t;
+
+dw1000_cir_instance_t * dw1000_cir_init(dw1000_dev_instance_t * inst, dw1000_cir_config_t config, dw1000_cir_output_cb_t * output_cb);
+void dw1000_cir_free(dw1000_dev_instance_t * inst);
+void dw1000_cir_config(dw1000_dev_instance_t * inst, dw1000_cir_config_t config);
+void dw1000_cir_capture(dw1000_dev_instance_t * inst);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* _DW1000_CIR_H_ */
@@ -0,0 +1,109 @@
+/*
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file dw1000_coex.h
+ * @date 2026
+ * @brief multi-PAN channel and preamble code coexistence
+ *
+ * @details Co-located PANs are kept apart by giving each its own channel and preamble code pair. The pan_master plans
+ * a pair from its PAN ID, ordered so that PANs numbered consecutively differ first in channel and only then in
+ * preamble code, and carries it in a small information element appended to every CCP beacon and to the PAN response.
+ * A change is announced with a countdown in beacons, so the clock master and all nodes tracking it retune on the same
+ * beacon period and none is left listening on the old pair. Nodes joining through the PAN response start on the
+ * current pair straight away. A node that misses the whole countdown hears no more beacons; after config.misses beacon
+ * periods it steps through the pairs of the plan, starting from the one planned for its PAN ID, until beacons return.
+ *
+ */
+
+#ifndef _DW1000_COEX_H_
+#define _DW1000_COEX_H_
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <hal/hal_spi.h>
+#include <dw1000/dw1000_regs.h>
+#include <dw1000/dw1000_dev.h>
+
+#define DW1000_COEX_CHANNEL_MASK_ALL    (0xBE)  //!< Channels 1, 2, 3, 4, 5 and 7, bit n for channel n
+
+//! Coexistence information element, appended to CCP beacons and PAN responses
+typedef struct _dw1000_coex_ie_t{
+    uint8_t epoch;                  //!< Assignment sequence number, changes with every new pair
+    uint8_t channel;                //!< Channel
+    uint8_t preamble_code;          //!< Preamble code, TX and RX
+    uint8_t countdown;              //!< Beacons left before the pair takes effect, 0 when in effect
+}__attribute__((__packed__, aligned(1))) dw1000_coex_ie_t;
+
+//! Coexistence status
+typedef struct _dw1000_coex_status_t{
+    uint16_t selfmalloc:1;          //!< Internal flag for memory garbage collection
+    uint16_t initialized:1;         //!< Instance allocated
+    uint16_t pending:1;             //!< A new pair is announced and not yet in effect
+    uint16_t listen:1;              //!< Receiver to be restarted after retuning
+}dw1000_coex_status_t;
+
+//! Coexistence configuration
+typedef struct _dw1000_coex_config_t{
+    uint8_t channel_mask;           //!< Channels the plan may use, bit n for channel n
+    uint8_t countdown;              //!< Beacons announcing a new pair before it takes effect
+    uint8_t misses;                 //!< Beacon periods without a beacon before the planned pairs are searched
+}dw1000_coex_config_t;
+
+//! Coexistence counters
+typedef struct _dw1000_coex_stats_t{
+    uint32_t retunes;               //!< Channel and preamble code changes applied
+    uint32_t beacons;               //!< Information elements received
+    uint32_t ignored;               //!< Information elements not usable at the configured PRF
+    uint32_t searches;              //!< Pairs tried after the beacons were lost
+}dw1000_coex_stats_t;
+
+//! Coexistence instance
+typedef struct _dw1000_coex_instance_t{
+    struct _dw1000_dev_instance_t * parent;         //!< Device instance structure
+    dw1000_coex_status_t status;                    //!< Coexistence status
+    dw1000_coex_config_t config;                    //!< Coexistence configuration
+    dw1000_coex_stats_t stats;                      //!< Coexistence counters
+    struct os_callout coex_callout_retune;          //!< Retune event, timed on the receiving side
+    struct os_callout coex_callout_lost;            //!< Beacon loss event, restarted by every beacon received
+    uint16_t search;                                //!< Pairs tried since the last beacon
+    dw1000_coex_ie_t current;                       //!< Pair in effect
+    dw1000_coex_ie_t pending;                       //!< Pair announced
+}dw1000_coex_instance_t;
+
+dw1000_coex_instance_t * dw1000_coex_init(dw1000_dev_instance_t * inst, dw1000_coex_config_t config);
+void dw1000_coex_free(dw1000_dev_instance_t * inst);
+bool dw1000_coex_plan(dw1000_dev_instance_t * inst, uint16_t pan_id, dw1000_coex_ie_t * ie);
+void dw1000_coex_assign(dw1000_dev_instance_t * inst, dw1000_coex_ie_t ie);
+void dw1000_coex_apply(dw1000_dev_instance_t * inst, dw1000_coex_ie_t ie);
+uint16_t dw1000_coex_beacon_tx(dw1000_dev_instance_t * inst, uint16_t offset);
+void dw1000_coex_beacon_rx(dw1000_dev_instance_t * inst, uint16_t offset);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* _DW1000_COEX_H_ */
@@ -73,7 +73,8 @@ typedef enum _dw1000_extension_id_t{
     DW1000_CCP,                       //!< Clock calibration packet 
     DW1000_PAN,                       //!< Personal area network
     DW1000_PROVISION,                 //!< Provisioning
-    DW1000_RANGE                      //!< Ranging
+    DW1000_RANGE,                     //!< Ranging
+    DW1000_BULK                       //!< Bulk transfer
 }dw1000_extension_id_t;
 
 //! Structure of DW1000 attributes.
@@ -100,6 +101,7 @@ typedef struct _dw1000_dev_status_t{
     uint32_t rx_ranging_frame:1;      //!< Range Request bit set for inbound frame
     uint32_t tx_ranging_frame:1;      //!< Range Request bit set for outbound frame
     uint32_t sleeping:1;              //!< Indicates state of sleeping
+    uint32_t tx_denied:1;             //!< Transmission refused by the regulatory engine
 }dw1000_dev_status_t;
 
 //! Device control status bits.
@@ -121,6 +123,8 @@ typedef struct _dw1000_dev_rx_config_t{
     uint8_t sfdType;                        //!< Boolean should we use non-standard SFD for better performance
     uint8_t phrMode;                        //!< PHR mode {0x0 - standard DWT_PHRMODE_STD, 0x3 - extended frames DWT_PHRMODE_EXT}
     uint16_t sfdTimeout;                    //!< SFD timeout value (in symbols) (preamble length + 1 + SFD length - PAC size). 
+    uint8_t sniffOnTime;                    //!< Sniff mode receiver on time, in units of PAC (1..15), the hardware adds one PAC
+    uint8_t sniffOffTime;                   //!< Sniff mode receiver off time, in usec
 }dw1000_dev_rx_config_t;
 
 //! DW1000 transmitter configuration parameters.
@@ -164,6 +168,9 @@ typedef struct _dw1000_dev_config_t{
     uint32_t rxdiag_enable:1;               //!< Enables receive diagnostics parameters 
     uint32_t rxauto_enable:1;               //!< Enables auto receive parameter
     uint32_t bias_correction_enable:1;      //!< 
+    uint32_t sniff_enable:1;                //!< Enables sniff mode duty cycled preamble search
+    uint32_t rx_rearm_enable:1;             //!< Re-enable the receiver from the interrupt handler after a timeout or error
+    uint32_t promiscuous_enable:1;          //!< Pass every good frame to the callbacks, repeated frames included
 }dw1000_dev_config_t;
 
 //! DW1000 receiver diagnostics parameters.
@@ -177,6 +184,40 @@ typedef struct _dw1000_dev_rxdiag_t{
     uint16_t    pacc_cnt;           //!<  Count of preamble symbols accumulated
 } dw1000_dev_rxdiag_t;
 
+#define DW1000_MAC_CB_HEADER_LEN    (16)        //!< Leading bytes of a received frame captured by the interrupt handler
+#define DW1000_MAC_CB_RX_FLAG_RNG   (1 << 0)    //!< Inbound frame has the ranging bit set
+#define DW1000_MAC_CB_RX_FLAG_PENDING (1 << 1)  //!< Inbound data frame has the frame pending bit set, the bit is cleared from inst->fctrl
+
+//! Per-event callback context, filled once by the interrupt handler before any callback runs, diagnostics excepted
+typedef struct _dw1000_mac_cb_data_t {
+    uint32_t status;      //!< Initial value of register as ISR is entered
+    uint16_t datalength;  //!< Length of frame, excluding the FCS
+    uint8_t  fctrl[2];    //!< Frame control bytes
+    uint8_t  rx_flags;    //!< RX frame flags
+    uint64_t rx_timestamp;                          //!< Receive timestamp, as returned by dw1000_read_rxtime
+    uint8_t  header[DW1000_MAC_CB_HEADER_LEN];      //!< Leading bytes of the received frame, valid up to datalength
+    struct _dw1000_dev_rxdiag_t * rxdiag;           //!< Receive diagnostics for this frame, NULL until read with dw1000_mac_rxdiag
+} dw1000_mac_cb_data_t;
+
+#if MYNEWT_VAL(DW1000_RX_SEQ_CACHE_SIZE) > 0
+//! Last frame seen from one source
+typedef struct _dw1000_rx_seq_entry_t{
+    uint64_t src_address;       //!< Source address, 16-bit addresses are zero extended
+    uint16_t fingerprint;       //!< Hash of the frame length and cached header
+    uint8_t seq_num;            //!< Sequence number
+    uint8_t valid;              //!< Entry in use
+}dw1000_rx_seq_entry_t;
+
+//! Receive duplicate cache, one entry per source, replaced round robin
+typedef struct _dw1000_rx_seq_cache_t{
+    uint32_t duplicates;        //!< Frames dropped as duplicates
+    uint32_t misses;            //!< Frames from a source not in the cache
+    uint32_t evictions;         //!< Sources displaced to make room
+    uint8_t idx;                //!< Next entry to replace
+    dw1000_rx_seq_entry_t entries[MYNEWT_VAL(DW1000_RX_SEQ_CACHE_SIZE)];   //!< Cache entries
+}dw1000_rx_seq_cache_t;
+#endif
+
 struct _dw1000_dev_instance_t;
 
 //! DW1000 extension callbacks
@@ -210,6 +251,8 @@ typedef struct _dw1000_dev_instance_t{
     void (* rng_rx_error_cb) (struct _dw1000_dev_instance_t *);
     void (* rng_tx_final_cb) (struct _dw1000_dev_instance_t *);
     void (* rng_complete_cb) (struct _dw1000_dev_instance_t *);
+    void (* rx_early_cb) (struct _dw1000_dev_instance_t *, const struct _dw1000_mac_cb_data_t *);
+    uint32_t rx_early_events;                  //!< SYS_STATUS_RXPRD, RXSFDD and RXPHD events reported to rx_early_cb
     dw1000_extension_callbacks_t * extension_cb;
 #if MYNEWT_VAL(DW1000_LWIP)
     void (* lwip_tx_complete_cb) (struct _dw1000_dev_instance_t *);
@@ -222,6 +265,13 @@ typedef struct _dw1000_dev_instance_t{
         uint8_t fctrl_array[sizeof(uint16_t)];  //!< Endianness safe interface
     };
     uint16_t frame_len;            //!< Reported frame length
+    dw1000_mac_cb_data_t cb_data;  //!< Context of the event being dispatched to the callbacks
+#if MYNEWT_VAL(DW1000_RX_SEQ_CACHE_SIZE) > 0
+    dw1000_rx_seq_cache_t rx_seq_cache;    //!< Receive duplicate cache
+#endif
+    uint32_t irq_cputime;          //!< os_cputime of the most recent DW1000 interrupt
+    uint32_t rx_rearm_dead_time;   //!< Interrupt to receiver enable time of the last re-arm after a timeout or error, in usec
+    uint32_t rx_rearm_dead_time_max;   //!< Largest rx_rearm_dead_time observed
     uint8_t spi_num;               //!< SPI number
     uint8_t irq_pin;               //!< Interrupt request pin
     uint8_t ss_pin;                //!< Slave select pin
@@ -243,10 +293,16 @@ typedef struct _dw1000_dev_instance_t{
     uint8_t otp_vbat;              //!< OTP parameter for voltage 
     uint8_t otp_temp;              //!< OTP parameter for temperature
     uint16_t sleep_mode;           //!< Device sleep mode
+    uint16_t lposc_cal;            //!< Low power oscillator period in XTAL/2 cycles, 0 until calibrated
     uint8_t xtal_trim;             //!< Crystal trim
     uint32_t sys_cfg_reg;          //!< System config register
+    uint16_t pretoc;               //!< Preamble detection timeout armed in DRX_PRETOC, 0 once the exchange has ended
+    uint16_t framefilter;          //!< Frame types passed by the hardware filter outside any extension window
+    uint8_t framefilter_windows;   //!< Extensions holding blink and reserved frame types open, one bit per dw1000_extension_id_t
     uint32_t sys_ctrl_reg;         //!< System control register 
     uint32_t tx_fctrl;             //!< Transmit frame control register parameter 
+    uint16_t tx_frame_len;         //!< Length of the frame staged for transmission, excluding the FCS
+    uint32_t wait4resp_delay;      //!< Wait-for-response turn-around time last written to ACK_RESP_T, in UWB usec
     uint32_t sys_status;           //!< SYS_STATUS_ID for current event
     uint16_t rx_antenna_delay;     //!< Receive antenna delay
     uint16_t tx_antenna_delay;     //!< Transmit antenna delay  
@@ -273,6 +329,27 @@ typedef struct _dw1000_dev_instance_t{
 #endif
 #if MYNEWT_VAL(DW1000_RANGE)
     struct _dw1000_range_instance_t * range;       //!< DW1000 range instance
+#endif
+#if MYNEWT_VAL(DW1000_BULK)
+    struct _dw1000_bulk_instance_t * bulk;         //!< DW1000 bulk transfer instance
+#endif
+#if MYNEWT_VAL(DW1000_SNIFFER)
+    struct _dw1000_sniffer_instance_t * sniffer;   //!< DW1000 sniffer instance
+#endif
+#if MYNEWT_VAL(DW1000_CIR)
+    struct _dw1000_cir_instance_t * cir;           //!< DW1000 CIR capture instance
+#endif
+#if MYNEWT_VAL(DW1000_DRIFT)
+    struct _dw1000_drift_instance_t * drift;       //!< DW1000 drift compensation instance
+#endif
+#if MYNEWT_VAL(DW1000_REGULATORY)
+    struct _dw1000_regulatory_instance_t * regulatory; //!< DW1000 regulatory engine instance
+#endif
+#if MYNEWT_VAL(DW1000_COEX)
+    struct _dw1000_coex_instance_t * coex;         //!< DW1000 multi-PAN coexistence instance
+#endif
+#if MYNEWT_VAL(DW1000_SURVEY)
+    struct _dw1000_survey_instance_t * survey;     //!< DW1000 channel survey instance
 #endif
     dw1000_dev_rxdiag_t rxdiag;                    //!< DW1000 receive diagnostics
     dw1000_dev_config_t config;                    //!< DW1000 device configurations  
@@ -302,6 +379,9 @@ void dw1000_dev_configure_sleep(dw1000_dev_instance_t * inst, uint16_t mode, uin
 dw1000_dev_status_t dw1000_dev_enter_sleep(dw1000_dev_instance_t * inst);
 dw1000_dev_status_t dw1000_dev_wakeup(dw1000_dev_instance_t * inst);
 void dw1000_dev_enter_sleep_after_tx(dw1000_dev_instance_t * inst, int enable);
+uint16_t dw1000_dev_calibrate_sleep_counter(dw1000_dev_instance_t * inst);
+void dw1000_dev_configure_sleep_counter(dw1000_dev_instance_t * inst, uint16_t count);
+uint32_t dw1000_dev_enter_sleep_until(dw1000_dev_instance_t * inst, uint64_t dx_time, uint32_t guard);
     
 void dw1000_add_extension_callbacks(dw1000_dev_instance_t* inst, dw1000_extension_callbacks_t callbacks);
 void dw1000_remove_extension_callbacks(dw1000_dev_instance_t* inst, dw1000_extension_id_t id);
@@ -0,0 +1,96 @@
+/*
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file dw1000_drift.h
+ * @date 2026
+ * @brief temperature and voltage drift compensation
+ *
+ * @details This is the drift compensation service. A low rate timer on the default event queue samples the on-chip
+ * temperature and voltage sensors whenever the device semaphore is free, and corrects the antenna delays and the TX
+ * power fine gain linearly in the temperature change since dw1000_drift_start. The values configured at start are the
+ * calibration reference, corrections are always computed from them so they never accumulate.
+ *
+ */
+
+#ifndef _DW1000_DRIFT_H_
+#define _DW1000_DRIFT_H_
+
+#include <stdlib.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <hal/hal_spi.h>
+#include <dw1000/dw1000_regs.h>
+#include <dw1000/dw1000_dev.h>
+
+//! Drift compensation status
+typedef struct _dw1000_drift_status_t{
+    uint16_t selfmalloc:1;          //!< Internal flag for memory garbage collection
+    uint16_t initialized:1;         //!< Instance allocated
+    uint16_t started:1;             //!< Sampling and correcting
+}dw1000_drift_status_t;
+
+//! Drift compensation coefficients, from board calibration
+typedef struct _dw1000_drift_config_t{
+    uint32_t period;                //!< Sampling period in usecs
+    int16_t antdly_per_c;           //!< Antenna delay change per degree C, device time units in Q8, applied to TX and RX
+    int16_t txpwr_per_c;            //!< TX power loss per degree C in milli dB, made up in 0.5 dB fine gain steps
+}dw1000_drift_config_t;
+
+//! Drift compensation counters
+typedef struct _dw1000_drift_stats_t{
+    uint32_t samples;               //!< Sensor readings taken
+    uint32_t deferred;              //!< Samples postponed because the device was busy
+    uint32_t updates;               //!< Corrections written to the device
+}dw1000_drift_stats_t;
+
+//! Drift compensation instance
+typedef struct _dw1000_drift_instance_t{
+    struct _dw1000_dev_instance_t * parent;         //!< Device instance structure
+    dw1000_drift_status_t status;                   //!< Drift compensation status
+    dw1000_drift_config_t config;                   //!< Drift compensation coefficients
+    dw1000_drift_stats_t stats;                     //!< Drift compensation counters
+    struct os_callout drift_callout_timer;          //!< Sampling timer
+    uint8_t ref_temp;                               //!< Temperature reading at start
+    uint8_t temp;                                   //!< Latest temperature reading
+    uint8_t vbat;                                   //!< Latest voltage reading
+    uint16_t ref_rx_antenna_delay;                  //!< RX antenna delay at start
+    uint16_t ref_tx_antenna_delay;                  //!< TX antenna delay at start
+    uint32_t ref_power;                             //!< TX power register at start
+    uint32_t power;                                 //!< TX power register as corrected
+    int8_t txpwr_step;                              //!< TX power correction, 0.5 dB fine gain steps
+}dw1000_drift_instance_t;
+
+dw1000_drift_instance_t * dw1000_drift_init(dw1000_dev_instance_t * inst, dw1000_drift_config_t config);
+void dw1000_drift_free(dw1000_dev_instance_t * inst);
+void dw1000_drift_start(dw1000_dev_instance_t * inst);
+void dw1000_drift_stop(dw1000_dev_instance_t * inst);
+int16_t dw1000_drift_temp_q8(dw1000_dev_instance_t * inst);
+uint16_t dw1000_drift_vbat_mv(dw1000_dev_instance_t * inst);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* _DW1000_DRIFT_H_ */
@@ -0,0 +1,68 @@
+/*
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file dw1000_dsp.h
+ * @date 2026
+ * @brief fixed point signal processing
+ *
+ * @details Integer counterparts of the lib/dsp sosfilt and polyval used by the clock and range services, for parts
+ * without an FPU. The filter runs second order sections with Q30 coefficients and 64-bit accumulation, the data may be
+ * in any fixed point format that leaves headroom for the gain of the sections. The polynomial is evaluated in a Q15
+ * argument normalised to [-1, 1), so coefficients are rescaled to that argument once, offline, and no intermediate
+ * term can outgrow the sum of their magnitudes. DW1000_DSP_FIXEDPOINT selects these in place of the float versions.
+ *
+ */
+
+#ifndef _DW1000_DSP_H_
+#define _DW1000_DSP_H_
+
+#include <stdlib.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DW1000_BIQUAD_N     (3)     //!< Coefficients per section, in each of the b and a tables
+
+//! Convert a constant to fixed point with q fractional bits, rounding to nearest; usable in static initializers
+#define DW1000_Q(x, q)      ((int32_t)((x) * (double)(1LL << (q)) + (((x) >= 0) ? 0.5 : -0.5)))
+
+//! Second order sections filter state
+typedef struct _dw1000_sos_q31_instance_t{
+    uint16_t selfmalloc:1;          //!< Internal flag for memory garbage collection
+    uint16_t nsections;             //!< Number of second order sections
+    uint32_t clk;                   //!< Samples filtered since init
+    int32_t output;                 //!< Last output
+    int32_t state[];                //!< x[n-1], x[n-2], y[n-1], y[n-2] of each section
+}dw1000_sos_q31_instance_t;
+
+dw1000_sos_q31_instance_t * dw1000_sosfilt_q31_init(dw1000_sos_q31_instance_t * inst, uint16_t nsections);
+void dw1000_sosfilt_q31_free(dw1000_sos_q31_instance_t * inst);
+int32_t dw1000_sosfilt_q31(dw1000_sos_q31_instance_t * inst, int32_t x, const int32_t * b, const int32_t * a);
+int32_t dw1000_polyval_q15(const int32_t * p, int16_t u, uint16_t n);
+int32_t dw1000_log2_q8(uint64_t x);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* _DW1000_DSP_H_ */
@@ -43,6 +43,7 @@ extern "C" {
 #define FCNTL_IEEE_BLINK_ANC_64 0x57        //!< Anchor blink frame control
 #define FCNTL_IEEE_RANGE_16     0x8841      //!< Range frame control 
 #define FCNTL_IEEE_PROVISION_16 0x8844      //!< Provision frame control
+#define FCNTL_IEEE_BULK_16      0x9841      //!< Bulk transfer frame control, IEEE 802.15.4-2006 data frame using 16-bit addressing
 
 //! IEEE 802.15.4e standard blink. It is a 12-byte frame composed of the following fields
 typedef union{
@@ -135,16 +135,10 @@ typedef enum _dw1000_start_rx_modes_t {
 #define MAC_FTYPE_DATA    0x1         //!<  MAC frame format - DATA parameter selection
 #define MAC_FTYPE_ACK     0x2         //!<  MAC frame format - ACK parameter selection
 #define MAC_FTYPE_COMMAND 0x3         //!<  MAC frame format - COMMAND parameter selection
+#define MAC_FTYPE_MASK    0x7         //!<  MAC frame format - Frame type field of the frame control
+#define MAC_FCTRL_FRAME_PENDING 0x0010 //!< MAC frame format - Frame pending bit of the frame control
 
 
-//! TX/RX callback data
-typedef struct _dw1000_mac_cb_data_t {
-    uint32_t status;      //!< Initial value of register as ISR is entered
-    uint16_t datalength;  //!< Length of frame
-    uint8_t  fctrl[2];    //!< Frame control bytes
-    uint8_t  rx_flags;    //!< RX frame flags
-} dw1000_mac_cb_data_t;
-
 //! Callback type for all events
 typedef void (*dw1000_mac_cb_t)(struct _dw1000_dev_instance_t * inst, const dw1000_mac_cb_data_t *);
 
@@ -164,6 +158,18 @@ typedef struct _dw1000_mac_deviceentcnts_t{
     uint16_t TXW ;                    //!< Power up warn
 } dw1000_mac_deviceentcnts_t ;
 
+//! Radio command descriptor, a complete transmit and optional wait-for-response action committed by dw1000_start_tx_cmd
+typedef struct _dw1000_mac_cmd_t{
+    const uint8_t * payload;          //!< Frame to load at the start of the TX buffer, NULL to send the buffer as is
+    uint16_t frame_len;               //!< Length of the frame excluding the 2 byte FCS
+    bool ranging;                     //!< Set the ranging bit in the PHR
+    uint64_t delay;                   //!< Delayed transmit time, see dw1000_set_delay_start; 0 transmits immediately
+    bool wait4resp;                   //!< Enable the receiver when the transmission completes
+    uint32_t wait4resp_delay;         //!< Turn-around time before the receiver is enabled, in UWB usec
+    uint16_t rx_timeout;              //!< Frame wait timeout from receiver enable, in UWB usec; 0 disables
+    uint16_t preamble_timeout;        //!< Preamble detection timeout from receiver enable, in PACs; 0 disables
+}dw1000_mac_cmd_t;
+
 //! Mac callbacks
 typedef struct _dw1000_mac_callbacks_t{
     void (* tx_complete_cb) (struct _dw1000_dev_instance_t *);  //!< Transmit complete callback
@@ -176,10 +182,20 @@ typedef struct _dw1000_mac_callbacks_t{
 struct _dw1000_dev_status_t dw1000_mac_init(struct _dw1000_dev_instance_t * inst, struct _dw1000_dev_config_t * config);
 void dw1000_tasks_init(struct _dw1000_dev_instance_t * inst);
 struct _dw1000_dev_status_t dw1000_mac_framefilter(struct _dw1000_dev_instance_t * inst, uint16_t enable);
+struct _dw1000_dev_status_t dw1000_mac_framefilter_window(struct _dw1000_dev_instance_t * inst, dw1000_extension_id_t id, bool open);
+struct _dw1000_dev_status_t dw1000_mac_set_address(struct _dw1000_dev_instance_t * inst, uint16_t pan_id, uint16_t short_address);
+struct _dw1000_dev_status_t dw1000_mac_set_channel(struct _dw1000_dev_instance_t * inst, uint8_t channel, uint8_t preamble_code);
+void dw1000_mac_retune(struct _dw1000_dev_instance_t * inst, uint8_t channel, uint8_t preamble_code);
+const uint8_t * dw1000_mac_preamble_codes(struct _dw1000_dev_instance_t * inst, uint8_t channel);
+void dw1000_mac_config_eventcounters(struct _dw1000_dev_instance_t * inst, bool enable);
+void dw1000_mac_read_eventcounters(struct _dw1000_dev_instance_t * inst, dw1000_mac_deviceentcnts_t * cnts);
 struct _dw1000_dev_status_t dw1000_write_tx(struct _dw1000_dev_instance_t * inst,  uint8_t *txFrameBytes, uint16_t txBufferOffset, uint16_t txFrameLength);
 struct _dw1000_dev_status_t dw1000_start_tx(struct _dw1000_dev_instance_t * inst);
+struct _dw1000_dev_status_t dw1000_start_tx_cmd(struct _dw1000_dev_instance_t * inst, const dw1000_mac_cmd_t * cmd);
 struct _dw1000_dev_status_t dw1000_set_delay_start(struct _dw1000_dev_instance_t * inst, uint64_t delay);
+struct _dw1000_dev_status_t dw1000_set_rx_window(struct _dw1000_dev_instance_t * inst, uint64_t rx_time, uint16_t rx_nlen);
 struct _dw1000_dev_status_t dw1000_set_wait4resp(struct _dw1000_dev_instance_t * inst, bool enable);
+struct _dw1000_dev_status_t dw1000_set_wait4resp_delay(struct _dw1000_dev_instance_t * inst, uint32_t delay);
 struct _dw1000_dev_status_t dw1000_start_rx(struct _dw1000_dev_instance_t * inst);
 struct _dw1000_dev_status_t dw1000_restart_rx(struct _dw1000_dev_instance_t * inst, struct _dw1000_dev_control_t control);
 void dw1000_write_tx_fctrl(struct _dw1000_dev_instance_t * inst, uint16_t txFrameLength, uint16_t txBufferOffset, bool ranging);
@@ -188,12 +204,19 @@ struct _dw1000_dev_status_t dw1000_sync_rxbufptrs(struct _dw1000_dev_instance_t
 struct _dw1000_dev_status_t dw1000_read_accdata(struct _dw1000_dev_instance_t * inst, uint8_t *buffer, uint16_t len, uint16_t accOffset);
 struct _dw1000_dev_status_t dw1000_enable_autoack(struct _dw1000_dev_instance_t * inst, uint8_t delay);
 struct _dw1000_dev_status_t dw1000_set_dblrxbuff(struct _dw1000_dev_instance_t * inst, bool flag);
+struct _dw1000_dev_status_t dw1000_set_sniff_mode(struct _dw1000_dev_instance_t * inst, bool enable, uint8_t ontime, uint8_t offtime);
+uint16_t dw1000_sniff_period(struct _dw1000_dev_instance_t * inst);
 void dw1000_set_callbacks(struct _dw1000_dev_instance_t * inst, dw1000_dev_cb_t cb_TxDone, dw1000_dev_cb_t cb_RxOk, dw1000_dev_cb_t cb_RxTo, dw1000_dev_cb_t cb_RxErr);
+void dw1000_set_rx_early_cb(struct _dw1000_dev_instance_t * inst, uint32_t events, dw1000_mac_cb_t rx_early_cb);
 struct _dw1000_dev_status_t dw1000_set_rx_timeout(struct _dw1000_dev_instance_t * inst, uint16_t timeout);
+struct _dw1000_dev_status_t dw1000_set_preamble_timeout(struct _dw1000_dev_instance_t * inst, uint16_t timeout);
 float dw1000_get_rssi(struct _dw1000_dev_instance_t * inst);
+int16_t dw1000_get_rssi_q8(struct _dw1000_dev_instance_t * inst);
+int16_t dw1000_get_fppl_q8(struct _dw1000_dev_instance_t * inst);
     
-#define dw1000_set_preamble_timeout(counts) dw1000_write_reg(inst, DRX_CONF_ID, DRX_PRETOC_OFFSET, counts, sizeof(uint16_t)) //!< Set preamble counts
 #define dw1000_read_rx(inst, buffer, rxBufferOffset, length) dw1000_read(inst, RX_BUFFER_ID,  rxBufferOffset, buffer,  length)//!< Read from RX buffer
+void dw1000_read_rx_frame(struct _dw1000_dev_instance_t * inst, uint8_t * buffer, uint16_t length);
+struct _dw1000_dev_rxdiag_t * dw1000_mac_rxdiag(struct _dw1000_dev_instance_t * inst);
 #define dw1000_set_panid(inst, pan_id) dw1000_write_reg(inst, PANADR_ID, PANADR_PAN_ID_OFFSET, pan_id, sizeof(uint16_t)) //!< Set pan id
 #define dw1000_set_address16(inst, shortAddress) dw1000_write_reg(inst ,PANADR_ID, PANADR_SHORT_ADDR_OFFSET, shortAddress, sizeof(uint16_t)) //!< Set address in frame filtering
 #define dw1000_set_eui(inst, eui64) dw1000_write_reg(inst, EUI_64_ID, EUI_64_OFFSET, eui64, EUI_64_LEN) //!< Set extended unique identifier
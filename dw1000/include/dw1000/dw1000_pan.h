@@ -44,6 +44,9 @@ extern "C" {
 #include <dw1000/dw1000_dev.h>
 #include <dw1000/dw1000_rng.h>
 #include <dw1000/dw1000_ftypes.h>
+#if MYNEWT_VAL(DW1000_COEX)
+#include <dw1000/dw1000_coex.h>
+#endif
 
 //! Union of response frame and frame parameters
 typedef union{
@@ -54,6 +57,9 @@ typedef union{
         uint16_t pan_id;                     //!< Assigned pan_id
         uint16_t short_address;              //!< Assigned device_id
         uint8_t slot_id;                     //!< Assigned slot_id
+#if MYNEWT_VAL(DW1000_COEX)
+        dw1000_coex_ie_t coex;               //!< Assigned channel and preamble code, the pan_master's coex->current
+#endif
     }__attribute__((__packed__, aligned(1)));
     uint8_t array[sizeof(struct _pan_frame_resp_t)];
 }pan_frame_resp_t;
@@ -82,7 +88,7 @@ typedef struct _dw1000_pan_status_t{
 //! Structure containing pan configurations
 typedef struct _dw1000_pan_config_t{
     uint32_t rx_holdoff_delay;        //!< Delay between frames, in UWB usec.
-    uint16_t rx_timeout_period;       //!< Receive response timeout, in UWB usec.
+    uint16_t rx_timeout_period;       //!< Receive response timeout, in UWB usec. Floored at the airtime derived timeout.
     uint32_t tx_holdoff_delay;        //!< Delay between frames, in UWB usec.
 }dw1000_pan_config_t;
 
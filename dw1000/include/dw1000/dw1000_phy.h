@@ -52,6 +52,8 @@ extern "C" {
 #define LDE_PARAM3_64 (0x0607)   //!< LDE masking for 64-bit configuration
 #define MIXER_GAIN_STEP (0.5)    //!< TODO
 #define DA_ATTN_STEP    (2.5)    //!< TODO
+#define DW1000_PHY_RX_TIMEOUT_GUARD (16) //!< Margin added to derived receive timeouts for RX enable latency and clock drift, in UWB usec
+#define DW1000_PHY_PRETOC_DETECT    (4)  //!< PACs of preamble allowed for detection before the preamble timeout expires
 
 //! Enum of txrf config parameters
 typedef enum {
@@ -89,9 +91,19 @@ void dw1000_phy_interrupt_mask(struct _dw1000_dev_instance_t * inst, uint32_t bi
 
 float dw1000_phy_read_wakeuptemp_SI(struct _dw1000_dev_instance_t * inst);
 float dw1000_phy_read_read_wakeupvbat_SI(struct _dw1000_dev_instance_t * inst);
+uint16_t dw1000_phy_read_tempvbat(struct _dw1000_dev_instance_t * inst);
 
 void dw1000_phy_external_sync(struct _dw1000_dev_instance_t * inst, uint8_t delay, bool enable);
 
+uint32_t dw1000_phy_SHR_duration(struct _dw1000_dev_instance_t * inst);
+uint32_t dw1000_phy_data_duration(struct _dw1000_dev_instance_t * inst, uint16_t nlen);
+uint32_t dw1000_phy_frame_duration(struct _dw1000_dev_instance_t * inst, uint16_t nlen);
+uint32_t dw1000_phy_turnaround_time(struct _dw1000_dev_instance_t * inst, uint16_t rx_nlen);
+uint16_t dw1000_phy_wait4resp_timeout(struct _dw1000_dev_instance_t * inst, uint32_t holdoff, uint16_t tx_nlen, uint16_t rx_nlen);
+uint32_t dw1000_phy_rx_window_delay(struct _dw1000_dev_instance_t * inst, uint32_t holdoff, uint16_t tx_nlen);
+uint16_t dw1000_phy_preamble_timeout(struct _dw1000_dev_instance_t * inst, uint32_t holdoff, uint16_t tx_nlen);
+#define dw1000_phy_rmarker_offset(inst) dw1000_phy_SHR_duration(inst)  //!< Offset from start of frame to the RMARKER, in UWB usec
+
 #ifdef __cplusplus
 }
 #endif
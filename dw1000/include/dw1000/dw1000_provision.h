@@ -69,8 +69,8 @@ typedef struct _dw1000_provision_status_t{
 
 //! Provision configuration parameters
 typedef struct _dw1000_provision_config_t{
-   uint32_t tx_holdoff_delay;        //!< Delay between frames, in UWB usec.
-   uint16_t rx_timeout_period;       //!< Receive response timeout, in UWB usec
+   uint32_t tx_holdoff_delay;        //!< Delay between frames, in UWB usec. Floored at dw1000_phy_turnaround_time, 0 for the PHY minimum.
+   uint16_t rx_timeout_period;       //!< Receive response timeout, in UWB usec. Floored at the airtime derived timeout.
    uint16_t period;                  //!< Provision period
    uint16_t max_node_count;          //!< Maximum number of nodes   
    uint16_t postprocess:1;           //!< Postprocess 
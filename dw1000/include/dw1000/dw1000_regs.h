@@ -486,6 +486,8 @@ extern "C" {
 **/
 #define SYS_STATE_ID            0x19            /* System State information READ ONLY */
 #define SYS_STATE_LEN           (5)
+#define SYS_STATE_TX_STATE_MASK 0x0000000FUL    /* Transmit state, 0 when idle */
+#define SYS_STATE_RX_STATE_MASK 0x00001F00UL    /* Receive state, 0 when idle */
 
 /****************************************************************************//**
  * @brief Bit definitions for register ACK_RESP_T
@@ -642,6 +644,8 @@ extern "C" {
 #define AGC_STAT1_MASK          0x0FFFFF
 #define AGC_STAT1_EDG1_MASK     0x0007C0        /* This 5-bit gain value relates to input noise power measurement. */
 #define AGC_STAT1_EDG2_MASK     0x0FF800        /* This 9-bit value relates to the input noise power measurement. */
+#define AGC_STAT1_EDG1_SHIFT    (6)
+#define AGC_STAT1_EDG2_SHIFT    (11)
 
 /****************************************************************************//**
  * @brief Bit definitions for register EXT_SYNC
@@ -958,6 +962,12 @@ extern "C" {
 
 /* offset from TX_CAL_ID in bytes */
 #define RF_STATUS_OFFSET        0x2C
+/* offset from RF_CONF_ID in bytes */
+#define RF_SENSOR_BIAS_OFFSET   0x11            /* Temperature and voltage sensor bias */
+#define RF_SENSOR_BIAS_TLD      0x80            /* Enable the temperature sensor bias */
+#define RF_SENSOR_CTRL_OFFSET   0x12            /* Temperature and voltage sensor ADC control */
+#define RF_SENSOR_CTRL_BIAS     0x0A            /* Enable the sensor and SAR ADC biases */
+#define RF_SENSOR_CTRL_OUT      0x0F            /* Enable the sensor outputs, once the biases are up */
 
 /****************************************************************************//**
  * @brief Bit definitions for register
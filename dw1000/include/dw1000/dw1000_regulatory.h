@@ -25,7 +25,14 @@
  * @date 2018
  * @brief Regulatory file
  *
- * @details This is the regulatory base class which includes header files.
+ * @details This is the regulatory engine. A region fixes the channels that may be used, the mean EIRP density limit
+ * over 1 ms and, for channels under a low duty cycle rule, the transmit time allowed per second. Every transmission is
+ * admitted from dw1000_start_tx and dw1000_start_tx_cmd: the airtime of the frame is checked against the channel and
+ * duty cycle rules, and the TX power is set to the highest level that keeps the energy transmitted in the current
+ * millisecond and second within the limit. Short frames are thereby boosted over the configured TX power, as hardware
+ * smart TX power does, but with the frames already sent in the same millisecond accounted for; hardware smart TX power
+ * is turned off while the engine runs. A refused frame fails with start_tx_error and tx_denied set; an admitted frame
+ * whose delayed transmit is aborted has its charge given back.
  */
 
 #ifndef _DW1000_REGL_H_
@@ -42,8 +49,81 @@ extern "C" {
 #include <dw1000/dw1000_regs.h>
 #include <dw1000/dw1000_dev.h>
 
+#if MYNEWT_VAL(DW1000_REGULATORY)
+
+#define DW1000_REGULATORY_STEP_MIN  (-12)   //!< Largest derating below the configured TX power, 0.5 dB steps
+#define DW1000_REGULATORY_STEP_MAX  (18)    //!< Largest boost over the configured TX power, 0.5 dB steps
+
+//! Regulatory regions
+typedef enum _dw1000_regulatory_region_t{
+    DW1000_REGION_NONE = 0,         //!< No limits, the configured TX power is used as is
+    DW1000_REGION_FCC,              //!< FCC part 15.519/15.517
+    DW1000_REGION_ETSI,             //!< ETSI EN 302 065, low duty cycle below 4.8 GHz
+    DW1000_REGION_MAX
+}dw1000_regulatory_region_t;
+
+//! Limits of a region
+typedef struct _dw1000_regulatory_limits_t{
+    int16_t eirp_max;               //!< Mean EIRP density limit over 1 ms, dBm/MHz in Q8
+    uint8_t channel_mask;           //!< Bit n set when channel n may be used
+    uint8_t ldc_channel_mask;       //!< Bit n set when channel n is under the low duty cycle rule
+    uint16_t ldc_ms_per_s;          //!< Transmit time allowed per second on low duty cycle channels, ms
+}dw1000_regulatory_limits_t;
+
+//! Regulatory configuration
+typedef struct _dw1000_regulatory_config_t{
+    dw1000_regulatory_region_t region;  //!< Region
+    int16_t eirp_ref;               //!< Mean EIRP density of continuous transmission at the configured TX power, dBm/MHz in Q8, from board calibration
+    int8_t step_max;                //!< Largest boost allowed, 0.5 dB steps up to DW1000_REGULATORY_STEP_MAX
+}dw1000_regulatory_config_t;
+
+//! Regulatory engine status
+typedef struct _dw1000_regulatory_status_t{
+    uint16_t selfmalloc:1;          //!< Internal flag for memory garbage collection
+    uint16_t initialized:1;         //!< Instance allocated
+}dw1000_regulatory_status_t;
+
+//! Regulatory engine counters
+typedef struct _dw1000_regulatory_stats_t{
+    uint32_t admitted;              //!< Frames admitted
+    uint32_t boosted;               //!< Frames admitted above the configured TX power
+    uint32_t derated;               //!< Frames admitted below the configured TX power
+    uint32_t denied_channel;        //!< Frames refused, channel not allowed in the region
+    uint32_t denied_duty;           //!< Frames refused, low duty cycle budget spent
+    uint32_t denied_energy;         //!< Frames refused, no power level within the energy budget
+    uint32_t refunded;              //!< Frames admitted then aborted before going on air, their charge given back
+}dw1000_regulatory_stats_t;
+
+//! Regulatory engine instance
+typedef struct _dw1000_regulatory_instance_t{
+    struct _dw1000_dev_instance_t * parent;         //!< Device instance structure
+    dw1000_regulatory_status_t status;              //!< Regulatory engine status
+    dw1000_regulatory_config_t config;              //!< Regulatory configuration
+    dw1000_regulatory_limits_t limits;              //!< Limits of the configured region
+    dw1000_regulatory_stats_t stats;                //!< Regulatory engine counters
+    uint32_t budget_ms;                             //!< Energy allowed per millisecond, usecs at the configured power in Q8
+    uint32_t ms_start;                              //!< Start of the current millisecond window, usecs
+    uint32_t s_start;                               //!< Start of the current second window, usecs
+    uint32_t energy_ms;                             //!< Energy transmitted in the current millisecond window
+    uint64_t energy_s;                              //!< Energy transmitted in the current second window
+    uint32_t airtime_s;                             //!< Transmit time in the current second window, usecs
+    uint32_t charge_ms;                             //!< Energy charged to the millisecond window by the last frame admitted
+    uint64_t charge_s;                              //!< Energy charged to the second window by the last frame admitted
+    uint32_t charge_airtime;                        //!< Transmit time charged by the last frame admitted, usecs
+    uint32_t base_power;                            //!< Configured TX power register
+    uint32_t power;                                 //!< TX power register as last written
+    int8_t step;                                    //!< Power step of the last frame admitted
+}dw1000_regulatory_instance_t;
+
+dw1000_regulatory_instance_t * dw1000_regulatory_init(dw1000_dev_instance_t * inst, dw1000_regulatory_config_t config);
+void dw1000_regulatory_free(dw1000_dev_instance_t * inst);
+void dw1000_regulatory_config(dw1000_dev_instance_t * inst, dw1000_regulatory_config_t config);
+bool dw1000_regulatory_admit(dw1000_dev_instance_t * inst, uint16_t nlen);
+void dw1000_regulatory_refund(dw1000_dev_instance_t * inst);
+
+#endif /* DW1000_REGULATORY */
 
 #ifdef __cplusplus
 }
 #endif
-#endif /* _DW1000_RNGL_H_ */
+#endif /* _DW1000_REGL_H_ */
@@ -59,8 +59,8 @@ extern "C" {
 //! Structure of delay parameters of range.
 typedef struct _dw1000_rng_config_t{
    uint32_t rx_holdoff_delay;        //!< Delay between frames, in UWB usec.
-   uint32_t tx_holdoff_delay;        //!< Delay between frames, in UWB usec.
-   uint16_t rx_timeout_period;       //!< Receive response timeout, in UWB usec.
+   uint32_t tx_holdoff_delay;        //!< Delay between frames, in UWB usec. Floored at dw1000_phy_turnaround_time, 0 for the PHY minimum.
+   uint16_t rx_timeout_period;       //!< Receive response timeout, in UWB usec. Floored at the airtime derived timeout.
    uint16_t bias_correction:1;       //!< Enable range bias correction polynomial
 }dw1000_rng_config_t;
 
@@ -88,6 +88,7 @@ typedef enum _dw1000_rng_modes_t{
     DWT_DS_TWR_EXT_END,              //!< End of double sided TWR in extended mode 
     DWT_PROVISION_START,             //!< Start of provision
     DWT_PROVISION_RESP,              //!< End of provision
+    DWT_RNG_DOWNLINK,                //!< Downlink payload following a ranging exchange
 }dw1000_rng_modes_t;
 
 //! Status of ranging
@@ -96,6 +97,12 @@ typedef struct _dw1000_rng_status_t{
     uint16_t initialized:1;          //!< Instance allocated
     uint16_t mac_error:1;            //!< Error caused due to frame filtering
     uint16_t invalid_code_error:1;   //!< Error due to invalid code
+    uint16_t downlink_overflow:1;    //!< Downlink payload rejected, queue full or payload too long
+    uint16_t downlink_promised:1;    //!< Last response sent flagged pending data for downlink_dst
+    uint16_t downlink_wait:1;        //!< Receiver held open for a downlink payload, sem is released on its reception or timeout
+    uint16_t downlink_tx:1;          //!< Downlink payload in flight
+    uint16_t payload_overflow:1;     //!< Application payload rejected, longer than DW1000_RNG_PAYLOAD_LEN
+    uint16_t quality_valid:1;        //!< quality belongs to a frame of the exchange in progress
 }dw1000_rng_status_t;
 
 //! Structure of TWR final frame
@@ -131,6 +138,36 @@ typedef union {
     uint8_t array[sizeof(struct _twr_frame_t)];        //!< Array of size twr_frame
 } twr_frame_t;
 
+#if MYNEWT_VAL(DW1000_RNG_DOWNLINK_SLOTS) > 0
+//! Downlink payload queued on an anchor until the addressed tag next ranges with it
+typedef struct _dw1000_rng_downlink_t{
+    uint16_t dst_address;                               //!< Tag short address
+    uint16_t len;                                       //!< Payload length, 0 when the slot is free
+    uint16_t order;                                     //!< Enqueue order, oldest is delivered first
+    uint8_t payload[MYNEWT_VAL(DW1000_RNG_DOWNLINK_LEN)];   //!< Payload
+}dw1000_rng_downlink_t;
+
+//! Downlink delivery callback, runs in the interrupt task on the tag
+typedef void dw1000_rng_downlink_cb_t(struct _dw1000_dev_instance_t * inst, uint16_t src_address, const uint8_t * payload, uint16_t len);
+#endif
+
+#if MYNEWT_VAL(DW1000_RNG_PAYLOAD_LEN) > 0
+//! Application payload callback, runs in the interrupt task for every ranging frame carrying a payload
+typedef void dw1000_rng_payload_cb_t(struct _dw1000_dev_instance_t * inst, uint16_t src_address, uint16_t code, const uint8_t * payload, uint16_t len);
+#endif
+
+#if MYNEWT_VAL(DW1000_RNG_NLOS_ENABLED)
+//! First path quality of a received ranging frame, see dw1000_rng_quality
+typedef struct _dw1000_rng_quality_t{
+    float fp_ratio;                 //!< Total received over first path power in dB, near 0 in line of sight
+    float fp_snr;                   //!< First path amplitude over the noise standard deviation
+    float pp_offset;                //!< Peak path lag behind the first path, in accumulator taps
+    float variance;                 //!< Range variance, RANGE_VARIANCE grown up to 16 fold as the confidence falls
+    uint8_t confidence;             //!< Line of sight confidence, 0 to 255
+    uint8_t nlos;                   //!< Classified as non line of sight
+}dw1000_rng_quality_t;
+#endif
+
 //! Structure of range callbacks
 typedef struct _dw1000_rng_callbacks_t{
     void (* rng_tx_complete_cb) (struct _dw1000_dev_instance_t *);  //!< Structure of range transmit complete callback
@@ -157,6 +194,26 @@ typedef struct _dw1000_rng_instance_t{
     dw1000_rng_status_t status;             //!< Structure of range status
     uint16_t idx;                           //!< Indicates number of instances for the chosen bsp
     uint16_t nframes;                       //!< Number of buffers defined to store the ranging data
+    uint16_t frame_len;                     //!< Length of the last ranging frame sent, excluding the FCS
+#if MYNEWT_VAL(DW1000_RNG_PAYLOAD_LEN) > 0
+    uint8_t payload[MYNEWT_VAL(DW1000_RNG_PAYLOAD_LEN)];    //!< Application payload attached to outbound frames
+    uint16_t payload_len;                   //!< Application payload length, 0 when detached
+    dw1000_rng_payload_cb_t * payload_cb;   //!< Application payload callback
+#endif
+#if MYNEWT_VAL(DW1000_RNG_DOWNLINK_SLOTS) > 0
+    dw1000_rng_downlink_t downlink[MYNEWT_VAL(DW1000_RNG_DOWNLINK_SLOTS)];  //!< Anchor side downlink queue
+    uint16_t downlink_order;                //!< Enqueue counter
+    uint16_t downlink_dst;                  //!< Tag the last response was sent to
+    uint8_t downlink_seq;                   //!< Sequence number of the last downlink frame sent
+    ieee_rng_request_frame_t downlink_frame;    //!< Downlink frame header under construction, the payload follows it
+    dw1000_rng_downlink_cb_t * downlink_cb; //!< Tag side delivery callback
+#endif
+#if MYNEWT_VAL(DW1000_RNG_NLOS_ENABLED)
+    dw1000_rng_quality_t quality;           //!< First path quality of the last ranging frame received, valid in rng_complete_cb
+#endif
+#if MYNEWT_VAL(DW1000_DSP_FIXEDPOINT)
+    int16_t pr_1m_q8;                       //!< Received power at 1 m for the configured device, dBm * 256
+#endif
     twr_frame_t * frames[];                 //!< Pointer to twr buffers
 }dw1000_rng_instance_t; 
 
@@ -168,6 +225,15 @@ void dw1000_rng_set_callbacks_extension(dw1000_dev_instance_t * inst,  dw1000_de
 dw1000_dev_status_t dw1000_rng_request(dw1000_dev_instance_t * inst, uint16_t dst_address, dw1000_rng_modes_t protocal);
 dw1000_dev_status_t dw1000_rng_request_delay_start(dw1000_dev_instance_t * inst, uint16_t dst_address, uint64_t delay, dw1000_rng_modes_t protocal);
 void dw1000_rng_set_frames(dw1000_dev_instance_t * inst, twr_frame_t twr[], uint16_t nframes);
+#if MYNEWT_VAL(DW1000_RNG_PAYLOAD_LEN) > 0
+dw1000_rng_status_t dw1000_rng_set_payload(dw1000_dev_instance_t * inst, const uint8_t * payload, uint16_t len);
+#define dw1000_rng_set_payload_cb(inst, cb) inst->rng->payload_cb = cb //!< Sets the application payload callback.
+#endif
+#if MYNEWT_VAL(DW1000_RNG_DOWNLINK_SLOTS) > 0
+dw1000_rng_status_t dw1000_rng_downlink_write(dw1000_dev_instance_t * inst, uint16_t dst_address, const uint8_t * payload, uint16_t len);
+uint16_t dw1000_rng_downlink_pending(dw1000_dev_instance_t * inst, uint16_t dst_address);
+#define dw1000_rng_set_downlink_cb(inst, cb) inst->rng->downlink_cb = cb //!< Sets the tag side downlink delivery callback.
+#endif
 #if MYNEWT_VAL(DW1000_RANGE)
 float dw1000_rng_twr_to_tof(twr_frame_t *fframe, twr_frame_t *nframe);
 #else
@@ -176,6 +242,13 @@ float dw1000_rng_twr_to_tof(dw1000_rng_instance_t * rng);
 
 float dw1000_rng_path_loss(float Pt, float G, float fc, float R);
 float dw1000_rng_bias_correction(dw1000_dev_instance_t * inst, float Pr);
+#if MYNEWT_VAL(DW1000_DSP_FIXEDPOINT)
+int16_t dw1000_rng_path_loss_q8(dw1000_dev_instance_t * inst, float R);
+int32_t dw1000_rng_bias_correction_q16(dw1000_dev_instance_t * inst, int16_t pr_q8);
+#endif
+#if MYNEWT_VAL(DW1000_RNG_NLOS_ENABLED)
+dw1000_rng_quality_t dw1000_rng_quality(dw1000_dev_instance_t * inst);
+#endif
 uint32_t dw1000_rng_twr_to_tof_sym(twr_frame_t twr[], dw1000_rng_modes_t code);
 #define dw1000_rng_tof_to_meters(ToF) (float)(ToF * 299792458 * (1.0/499.2e6/128.0)) //!< Converts time of flight to meters.
 #define dw1000_rng_set_interface_extension_cb(inst, cb) inst->rng_interface_extension_cb = cb //!< Sets the interface extension callback.
@@ -0,0 +1,122 @@
+/*
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file dw1000_sniffer.h
+ * @date 2026
+ * @brief sniffer
+ *
+ * @details This is the sniffer role. While started, frame filtering is off, the receiver runs continuously on both
+ * receive buffers and every frame, ranging or not, is captured with its RX timestamp and diagnostics instead of being
+ * handed to the MAC services. Captured frames are queued as records and drained from the default event queue to an
+ * output callback, typically a UART or USB channel. The record layout below is fixed so that a host can convert the
+ * stream to pcap, LINKTYPE_IEEE802_15_4_TAP carrying the FCS, channel and timestamp; tools/dw1000_sniffer_pcap.py
+ * does so.
+ *
+ */
+
+#ifndef _DW1000_SNIFFER_H_
+#define _DW1000_SNIFFER_H_
+
+#include <stdlib.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <hal/hal_spi.h>
+#include <dw1000/dw1000_regs.h>
+#include <dw1000/dw1000_dev.h>
+
+#define DW1000_SNIFFER_SYNC     (0xA55A)    //!< Leading word of every record, lets the host resynchronise on a byte stream
+
+//! Sniffer status
+typedef struct _dw1000_sniffer_status_t{
+    uint16_t selfmalloc:1;          //!< Internal flag for memory garbage collection
+    uint16_t initialized:1;         //!< Instance allocated
+    uint16_t started:1;             //!< Capturing, the device callbacks belong to the sniffer
+}dw1000_sniffer_status_t;
+
+//! Sniffer counters
+typedef struct _dw1000_sniffer_stats_t{
+    uint32_t frames;                //!< Frames captured
+    uint32_t overruns;              //!< Frames lost because the record queue was full
+    uint32_t truncated;             //!< Frames longer than DW1000_SNIFFER_FRAME_LEN, captured in part
+    uint32_t rx_errors;             //!< Receive errors, bad FCS, PHR or SFD
+}dw1000_sniffer_stats_t;
+
+//! Capture record header, the captured frame including its FCS follows. Multi-byte fields are little endian.
+typedef struct _dw1000_sniffer_record_t{
+    uint16_t sync;                  //!< DW1000_SNIFFER_SYNC
+    uint16_t caplen;                //!< Bytes of the frame that follow this header
+    uint16_t len;                   //!< Length of the frame on air, including the FCS
+    uint8_t rx_timestamp[5];        //!< 40-bit RX timestamp, in device time units
+    uint8_t channel;                //!< UWB channel
+    uint8_t prf;                    //!< Pulse repetition frequency, DWT_PRF_16M or DWT_PRF_64M
+    uint8_t flags;                  //!< DW1000_MAC_CB_RX_FLAG_ bits of the frame
+    uint16_t overruns;              //!< Frames lost since the previous record
+    uint16_t fp_idx;                //!< First path index, 10.6 fixed point
+    uint16_t fp_amp;                //!< Amplitude at floor(fp_idx) + 1
+    uint16_t fp_amp2;               //!< Amplitude at floor(fp_idx) + 2
+    uint16_t fp_amp3;               //!< Amplitude at floor(fp_idx) + 3
+    uint16_t rx_std;                //!< Standard deviation of noise
+    uint16_t cir_pwr;               //!< Channel impulse response power
+    uint16_t pacc_cnt;              //!< Preamble symbols accumulated
+}__attribute__((__packed__,aligned(1))) dw1000_sniffer_record_t;
+
+//! Record output callback, runs in the default event queue task
+typedef void dw1000_sniffer_output_cb_t(struct _dw1000_dev_instance_t * inst, const uint8_t * record, uint16_t len);
+
+//! One queued record
+typedef struct _dw1000_sniffer_slot_t{
+    dw1000_sniffer_record_t record;                         //!< Record header
+    uint8_t frame[MYNEWT_VAL(DW1000_SNIFFER_FRAME_LEN)];    //!< Captured frame
+}__attribute__((__packed__,aligned(1))) dw1000_sniffer_slot_t;
+
+//! Sniffer instance
+typedef struct _dw1000_sniffer_instance_t{
+    struct _dw1000_dev_instance_t * parent;         //!< Device instance structure
+    dw1000_sniffer_status_t status;                 //!< Sniffer status
+    dw1000_sniffer_stats_t stats;                   //!< Sniffer counters
+    struct os_callout sniffer_callout_postprocess;  //!< Drains the record queue
+    dw1000_sniffer_output_cb_t * output_cb;         //!< Record output callback
+    dw1000_dev_cb_t rx_complete_cb;                 //!< Device callbacks displaced while started
+    dw1000_dev_cb_t rx_error_cb;
+    dw1000_dev_cb_t rng_rx_complete_cb;
+    dw1000_dev_cb_t rng_rx_error_cb;
+    dw1000_dev_config_t config;                     //!< Device configuration displaced while started
+    uint16_t framefilter;                           //!< Frame filter displaced while started
+    volatile uint16_t head;                         //!< Next slot written by the interrupt task
+    volatile uint16_t tail;                         //!< Next slot drained by the postprocess
+    uint16_t overruns;                              //!< Frames lost since the last queued record
+    dw1000_sniffer_slot_t slots[MYNEWT_VAL(DW1000_SNIFFER_RECORDS)];   //!< Record queue
+}dw1000_sniffer_instance_t;
+
+dw1000_sniffer_instance_t * dw1000_sniffer_init(dw1000_dev_instance_t * inst, dw1000_sniffer_output_cb_t * output_cb);
+void dw1000_sniffer_free(dw1000_dev_instance_t * inst);
+dw1000_dev_status_t dw1000_sniffer_start(dw1000_dev_instance_t * inst);
+dw1000_dev_status_t dw1000_sniffer_stop(dw1000_dev_instance_t * inst);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* _DW1000_SNIFFER_H_ */
@@ -0,0 +1,119 @@
+/*
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file dw1000_survey.h
+ * @date 2026
+ * @brief channel survey
+ *
+ * @details The survey listens on every channel and preamble code pair allowed by a channel mask for an equal share of
+ * a time budget, and records the input noise level from AGC_STAT1 together with the event counters: SFD timeouts,
+ * which without a transmitter on the pair are false preamble detections, PHR and Reed Solomon errors, bad and good
+ * frames. Pairs are ranked by error and traffic count, then by noise. A monitor can watch the same counters on the
+ * pair in use and run a survey when the error count over a period crosses a threshold; the default postprocess then
+ * moves to the best pair, through the coexistence countdown when that service is running. The monitor runs on a task
+ * of its own, so that the survey it triggers blocks neither the default queue nor the CCP and TDMA events on it.
+ *
+ */
+
+#ifndef _DW1000_SURVEY_H_
+#define _DW1000_SURVEY_H_
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <hal/hal_spi.h>
+#include <dw1000/dw1000_regs.h>
+#include <dw1000/dw1000_dev.h>
+#include <dw1000/dw1000_mac.h>
+
+#define DW1000_SURVEY_NRESULTS  (24)    //!< Six channels of four preamble codes
+#define DW1000_SURVEY_NSAMPLES  (4)     //!< Noise samples per pair
+
+//! Survey status
+typedef struct _dw1000_survey_status_t{
+    uint16_t selfmalloc:1;          //!< Internal flag for memory garbage collection
+    uint16_t initialized:1;         //!< Instance allocated
+    uint16_t busy:1;                //!< Survey running, the device is held
+    uint16_t valid:1;               //!< Results are from a completed survey
+    uint16_t monitoring:1;          //!< Error monitor running
+    uint16_t listen:1;              //!< Receiver was on when the survey started
+}dw1000_survey_status_t;
+
+//! Survey configuration
+typedef struct _dw1000_survey_config_t{
+    uint8_t channel_mask;           //!< Channels to survey, bit n for channel n
+    uint32_t budget;                //!< Duration of a survey in usecs, shared evenly by the pairs
+    uint32_t period;                //!< Error monitor period in usecs
+    uint16_t threshold;             //!< Errors per monitor period that trigger a survey
+    uint16_t postprocess:1;         //!< Postprocess set by the application
+}dw1000_survey_config_t;
+
+//! Measurements of one channel and preamble code pair
+typedef struct _dw1000_survey_result_t{
+    uint8_t channel;                //!< Channel
+    uint8_t preamble_code;          //!< Preamble code
+    int16_t noise;                  //!< Mean input noise level, relative dB in Q8
+    uint16_t false_preambles;       //!< Preambles detected without an SFD
+    uint16_t phr_errors;            //!< PHY header errors
+    uint16_t rs_errors;             //!< Reed Solomon decoder, frame sync loss, errors
+    uint16_t crc_errors;            //!< Frames with a bad FCS
+    uint16_t frames;                //!< Frames with a good FCS, traffic already on the pair
+}dw1000_survey_result_t;
+
+//! Survey counters
+typedef struct _dw1000_survey_stats_t{
+    uint32_t surveys;               //!< Surveys completed
+    uint32_t triggers;              //!< Surveys started by the error monitor
+    uint32_t switches;              //!< Moves to a better pair by the default postprocess
+}dw1000_survey_stats_t;
+
+//! Survey instance
+typedef struct _dw1000_survey_instance_t{
+    struct _dw1000_dev_instance_t * parent;         //!< Device instance structure
+    dw1000_survey_status_t status;                  //!< Survey status
+    dw1000_survey_config_t config;                  //!< Survey configuration
+    dw1000_survey_stats_t stats;                    //!< Survey counters
+    struct os_callout survey_callout_timer;         //!< Error monitor timer
+    struct os_callout survey_callout_postprocess;   //!< Run once the results are ranked
+    uint32_t dwell;                                 //!< Noise sample interval in os ticks
+    uint16_t errors;                                //!< Monitor error count at the last period
+    uint8_t nresults;                               //!< Pairs surveyed
+    dw1000_survey_result_t results[DW1000_SURVEY_NRESULTS]; //!< Ranked best first once valid
+}dw1000_survey_instance_t;
+
+dw1000_survey_instance_t * dw1000_survey_init(dw1000_dev_instance_t * inst, dw1000_survey_config_t config);
+void dw1000_survey_free(dw1000_dev_instance_t * inst);
+void dw1000_survey_set_postprocess(dw1000_dev_instance_t * inst, os_event_fn * survey_postprocess);
+void dw1000_survey_start(dw1000_dev_instance_t * inst);
+void dw1000_survey_monitor_start(dw1000_dev_instance_t * inst);
+void dw1000_survey_monitor_stop(dw1000_dev_instance_t * inst);
+int16_t dw1000_survey_noise(dw1000_dev_instance_t * inst);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* _DW1000_SURVEY_H_ */
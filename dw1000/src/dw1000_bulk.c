@@ -0,0 +1,754 @@
+/*
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file dw1000_bulk.c
+ * @date 2026
+ * @brief bulk transfer
+ *
+ * @details This is the bulk transfer service. The sender opens or resumes a transfer with a query, the receiver
+ * answers with a SACK carrying the first missing chunk and a bitmap of the chunks received above it. Each call to
+ * dw1000_bulk_window then sends up to config.window missing chunks back to back, the last one requesting the next SACK.
+ * Chunks carry a CRC16 of their payload and are delivered to the receiver through the rx callback as they arrive, in
+ * any order, at their offset in the blob.
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <os/os.h>
+#include <hal/hal_spi.h>
+#include <hal/hal_gpio.h>
+#include "bsp/bsp.h"
+
+#include <dw1000/dw1000_regs.h>
+#include <dw1000/dw1000_dev.h>
+#include <dw1000/dw1000_hal.h>
+#include <dw1000/dw1000_mac.h>
+#include <dw1000/dw1000_phy.h>
+#include <dw1000/dw1000_ftypes.h>
+
+#if MYNEWT_VAL(DW1000_BULK)
+#include <crc/crc16.h>
+#include <dw1000/dw1000_bulk.h>
+
+static void bulk_rx_complete_cb(dw1000_dev_instance_t * inst);
+static void bulk_rx_timeout_cb(dw1000_dev_instance_t * inst);
+static void bulk_rx_error_cb(dw1000_dev_instance_t * inst);
+static void bulk_tx_error_cb(dw1000_dev_instance_t * inst);
+static void bulk_tx_complete_cb(dw1000_dev_instance_t * inst);
+static void bulk_postprocess(struct os_event * ev);
+
+/**
+ * Allocate resources for the bulk transfer service. The same instance sends and receives.
+ *
+ * @param inst    Pointer to dw1000_dev_instance_t.
+ * @param config  Configures bulk transfer features.
+ * @return dw1000_bulk_instance_t
+ */
+dw1000_bulk_instance_t *
+dw1000_bulk_init(dw1000_dev_instance_t * inst, dw1000_bulk_config_t config){
+    assert(inst);
+    assert(config.window > 0 && config.window <= DW1000_BULK_WINDOW_MAX);
+    assert(config.chunk_len > 0);
+    assert(sizeof(bulk_data_frame_t) + config.chunk_len + 2 <= ((inst->config.rx.phrMode == DWT_PHRMODE_EXT) ? 1023 : 127));
+
+    dw1000_extension_callbacks_t bulk_cbs;
+    if (inst->bulk == NULL ){
+        inst->bulk = (dw1000_bulk_instance_t *) malloc(sizeof(dw1000_bulk_instance_t) + config.chunk_len);
+        assert(inst->bulk);
+        memset(inst->bulk, 0, sizeof(dw1000_bulk_instance_t));
+        inst->bulk->status.selfmalloc = 1;
+    }
+    dw1000_bulk_instance_t * bulk = inst->bulk;
+
+    bulk->parent = inst;
+    memcpy(&bulk->config, &config, sizeof(dw1000_bulk_config_t));
+    os_error_t err = os_sem_init(&bulk->sem, 0x1);
+    assert(err == OS_OK);
+
+    bulk_cbs.tx_complete_cb = bulk_tx_complete_cb;
+    bulk_cbs.rx_complete_cb = bulk_rx_complete_cb;
+    bulk_cbs.rx_timeout_cb = bulk_rx_timeout_cb;
+    bulk_cbs.rx_error_cb = bulk_rx_error_cb;
+    bulk_cbs.tx_error_cb = bulk_tx_error_cb;
+    dw1000_bulk_set_ext_callbacks(inst, bulk_cbs);
+
+    dw1000_bulk_set_postprocess(inst, &bulk_postprocess);
+    bulk->status.initialized = 1;
+    return bulk;
+}
+
+/**
+ * Free resources and restore default behaviour.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @return void
+ */
+void
+dw1000_bulk_free(dw1000_dev_instance_t * inst){
+    assert(inst != NULL);
+    assert(inst->bulk != NULL);
+    dw1000_remove_extension_callbacks(inst, DW1000_BULK);
+    if (inst->bulk->status.selfmalloc){
+        free(inst->bulk);
+        inst->bulk = NULL;
+    }
+    else
+        inst->bulk->status.initialized = 0;
+}
+
+/**
+ * Sets the callbacks to be called for bulk transfer related rx_complete, rx_timeout, etc in a linked list.
+ *
+ * @param inst      Pointer to dw1000_dev_instance_t.
+ * @param bulk_cbs  Structure to dw1000_extension_callbacks_t.
+ * @return void
+ */
+void
+dw1000_bulk_set_ext_callbacks(dw1000_dev_instance_t * inst, dw1000_extension_callbacks_t bulk_cbs){
+    bulk_cbs.id = DW1000_BULK;
+    dw1000_add_extension_callbacks(inst, bulk_cbs);
+}
+
+/**
+ * Sets the postprocess event, posted when an outbound transfer is acknowledged in full or an inbound transfer
+ * is complete.
+ *
+ * @param inst              Pointer to dw1000_dev_instance_t.
+ * @param bulk_postprocess  Pointer to os_event_fn.
+ * @return void
+ */
+void
+dw1000_bulk_set_postprocess(dw1000_dev_instance_t * inst, os_event_fn * bulk_postprocess){
+    assert(inst != NULL);
+    assert(inst->bulk != NULL);
+    dw1000_bulk_instance_t * bulk = inst->bulk;
+    os_callout_init(&bulk->bulk_callout_postprocess, os_eventq_dflt_get(), bulk_postprocess, (void *) inst);
+    bulk->config.postprocess = true;
+}
+
+/**
+ * Sets the chunk delivery callback of the receiver. The callback runs in the interrupt task once for every chunk
+ * that passed its CRC and was not delivered before, and should only copy or queue the payload.
+ *
+ * @param inst   Pointer to dw1000_dev_instance_t.
+ * @param rx_cb  Pointer to dw1000_bulk_rx_cb_t, NULL to drop the payload.
+ * @return void
+ */
+void
+dw1000_bulk_set_rx_cb(dw1000_dev_instance_t * inst, dw1000_bulk_rx_cb_t * rx_cb){
+    assert(inst != NULL);
+    assert(inst->bulk != NULL);
+    inst->bulk->rx_cb = rx_cb;
+}
+
+/**
+ * Default postprocess, prints the transfer counters.
+ *
+ * @param ev    Pointer to os_events.
+ * @return void
+ */
+static void
+bulk_postprocess(struct os_event * ev){
+    assert(ev != NULL);
+    assert(ev->ev_arg != NULL);
+    dw1000_dev_instance_t * inst = (dw1000_dev_instance_t *)ev->ev_arg;
+    dw1000_bulk_instance_t * bulk = inst->bulk;
+
+    printf("{\"utime\":%lu,\"bulk\":{\"tx_chunks\":%lu,\"tx_windows\":%lu,\"sack_timeouts\":%lu,\"rx_chunks\":%lu,\"rx_duplicates\":%lu,\"rx_crc_errors\":%lu}}\n",
+            os_cputime_ticks_to_usecs(os_cputime_get32()),
+            bulk->stats.tx_chunks,
+            bulk->stats.tx_windows,
+            bulk->stats.sack_timeouts,
+            bulk->stats.rx_chunks,
+            bulk->stats.rx_duplicates,
+            bulk->stats.rx_crc_errors
+    );
+}
+
+/**
+ * RMARKER to RMARKER spacing after a frame of length nlen. The configured tx_holdoff_delay is used unless it is
+ * shorter than the PHY allows for the current configuration, a value of zero selects the PHY minimum.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @param nlen  Length of the preceding frame, excluding the FCS.
+ * @return uint32_t Holdoff in UWB usec.
+ */
+static uint32_t
+bulk_tx_holdoff(dw1000_dev_instance_t * inst, uint16_t nlen){
+    uint32_t holdoff = dw1000_phy_turnaround_time(inst, nlen);
+    return (inst->bulk->config.tx_holdoff_delay > holdoff) ? inst->bulk->config.tx_holdoff_delay : holdoff;
+}
+
+/**
+ * Arm a command to wait for a SACK sent by the peer bulk_tx_holdoff after our frame. As with ranging, the receiver
+ * is held off until shortly before the expected preamble unless a longer rx_timeout_period is configured.
+ *
+ * @param inst      Pointer to dw1000_dev_instance_t.
+ * @param cmd       Command to update.
+ * @param tx_nlen   Length of the outbound frame, excluding the FCS.
+ * @return void
+ */
+static void
+bulk_wait4sack(dw1000_dev_instance_t * inst, dw1000_mac_cmd_t * cmd, uint16_t tx_nlen){
+    dw1000_bulk_instance_t * bulk = inst->bulk;
+    uint32_t holdoff = bulk_tx_holdoff(inst, tx_nlen);
+    uint16_t timeout = dw1000_phy_wait4resp_timeout(inst, holdoff, tx_nlen, sizeof(bulk_ctrl_frame_t));
+
+    cmd->wait4resp = true;
+    if (bulk->config.rx_timeout_period < timeout){
+        cmd->wait4resp_delay = dw1000_phy_rx_window_delay(inst, holdoff, tx_nlen);
+        cmd->rx_timeout = dw1000_phy_wait4resp_timeout(inst, holdoff - cmd->wait4resp_delay, tx_nlen, sizeof(bulk_ctrl_frame_t));
+        cmd->preamble_timeout = dw1000_phy_preamble_timeout(inst, holdoff - cmd->wait4resp_delay, tx_nlen);
+    }else
+        cmd->rx_timeout = bulk->config.rx_timeout_period;
+}
+
+/**
+ * Send a query (sender) or SACK (receiver). A query waits for the SACK, a SACK leaves the receiver on without a
+ * timeout for the next window.
+ *
+ * @param inst          Pointer to dw1000_dev_instance_t.
+ * @param code          DWT_BULK_QUERY or DWT_BULK_SACK.
+ * @param dst_address   Peer short address.
+ * @param delay         Delayed transmit time, 0 to transmit immediately.
+ * @return dw1000_dev_status_t
+ */
+static dw1000_dev_status_t
+bulk_start_ctrl(dw1000_dev_instance_t * inst, dw1000_bulk_codes_t code, uint16_t dst_address, uint64_t delay){
+    dw1000_bulk_instance_t * bulk = inst->bulk;
+    bulk_ctrl_frame_t * frame = &bulk->ctrl;
+
+    frame->fctrl = FCNTL_IEEE_BULK_16;
+    frame->seq_num = ++bulk->seq_num;
+    frame->PANID = inst->PANID;
+    frame->dst_address = dst_address;
+    frame->src_address = inst->my_short_address;
+    frame->code = code;
+    if (code == DWT_BULK_QUERY){
+        frame->xfer_id = bulk->tx.xfer_id;
+        frame->base = 0;
+        frame->nchunks = bulk->tx.nchunks;
+        frame->bitmap = 0;
+    }else{
+        frame->xfer_id = bulk->rx.xfer_id;
+        frame->base = bulk->rx.base;
+        frame->nchunks = bulk->rx.nchunks;
+        frame->bitmap = bulk->rx.bitmap;
+    }
+
+    dw1000_mac_cmd_t cmd = {
+        .payload = frame->array,
+        .frame_len = sizeof(bulk_ctrl_frame_t),
+        .delay = delay,
+        .wait4resp = true
+    };
+    if (code == DWT_BULK_QUERY)
+        bulk_wait4sack(inst, &cmd, sizeof(bulk_ctrl_frame_t));
+    return dw1000_start_tx_cmd(inst, &cmd);
+}
+
+/**
+ * Next chunk of the current window, scanning the SACK bitmap from tx.next.
+ *
+ * @param bulk  Pointer to dw1000_bulk_instance_t.
+ * @return int  Bitmap position of the chunk, -1 when the window is done.
+ */
+static int
+bulk_next_chunk(dw1000_bulk_instance_t * bulk){
+    dw1000_bulk_tx_t * tx = &bulk->tx;
+    if (tx->burst >= bulk->config.window)
+        return -1;
+    for (uint16_t i = tx->next; i < DW1000_BULK_WINDOW_MAX && tx->base + i < tx->nchunks; i++)
+        if (!(tx->bitmap & (1UL << i)))
+            return i;
+    return -1;
+}
+
+/**
+ * Send the chunk at bitmap position idx. The payload is written straight from the blob behind the header; the
+ * last chunk of the window requests a SACK.
+ *
+ * @param inst   Pointer to dw1000_dev_instance_t.
+ * @param idx    Bitmap position of the chunk, from bulk_next_chunk.
+ * @param delay  Delayed transmit time, 0 to transmit immediately.
+ * @return dw1000_dev_status_t
+ */
+static dw1000_dev_status_t
+bulk_start_chunk(dw1000_dev_instance_t * inst, int idx, uint64_t delay){
+    dw1000_bulk_instance_t * bulk = inst->bulk;
+    dw1000_bulk_tx_t * tx = &bulk->tx;
+    bulk_data_frame_t * frame = &bulk->data;
+
+    uint16_t chunk = tx->base + idx;
+    uint32_t offset = (uint32_t) chunk * bulk->config.chunk_len;
+    uint16_t len = (tx->len - offset < bulk->config.chunk_len) ? tx->len - offset : bulk->config.chunk_len;
+    tx->next = idx + 1;
+    tx->burst++;
+    bool last = bulk_next_chunk(bulk) < 0;
+
+    frame->fctrl = FCNTL_IEEE_BULK_16;
+    frame->seq_num = ++bulk->seq_num;
+    frame->PANID = inst->PANID;
+    frame->dst_address = tx->dst_address;
+    frame->src_address = inst->my_short_address;
+    frame->code = (last) ? DWT_BULK_DATA_LAST : DWT_BULK_DATA;
+    frame->xfer_id = tx->xfer_id;
+    frame->chunk = chunk;
+    frame->crc = crc16_ccitt(CRC16_INITIAL_CRC, &tx->data[offset], len);
+    tx->frame_len = sizeof(bulk_data_frame_t) + len;
+
+    // Header last, dw1000_write_tx takes the frame control from the bytes it writes
+    dw1000_write_tx(inst, (uint8_t *) &tx->data[offset], sizeof(bulk_data_frame_t), len);
+    dw1000_write_tx(inst, frame->array, 0, sizeof(bulk_data_frame_t));
+
+    dw1000_mac_cmd_t cmd = {
+        .payload = NULL,
+        .frame_len = tx->frame_len,
+        .delay = delay
+    };
+    if (last)
+        bulk_wait4sack(inst, &cmd, tx->frame_len);
+    bulk->stats.tx_chunks++;
+    return dw1000_start_tx_cmd(inst, &cmd);
+}
+
+/**
+ * End the window in flight and unblock dw1000_bulk_window.
+ *
+ * @param bulk  Pointer to dw1000_bulk_instance_t.
+ * @return void
+ */
+static void
+bulk_window_done(dw1000_bulk_instance_t * bulk){
+    bulk->status.window_pending = 0;
+    os_error_t err = os_sem_release(&bulk->sem);
+    assert(err == OS_OK);
+}
+
+/**
+ * Account for a window that went unanswered. The next window queries the receiver rather than resending every
+ * chunk, after max_retries the transfer is suspended until dw1000_bulk_resume.
+ *
+ * @param bulk  Pointer to dw1000_bulk_instance_t.
+ * @return void
+ */
+static void
+bulk_window_lost(dw1000_bulk_instance_t * bulk){
+    bulk->stats.sack_timeouts++;
+    bulk->status.resync = 1;
+    if (++bulk->tx.retries >= bulk->config.max_retries)
+        bulk->status.suspended = 1;
+    bulk_window_done(bulk);
+}
+
+/**
+ * Receive a data chunk. Duplicates, chunks outside the SACK window and chunks of another transfer are dropped on the
+ * cached header alone; only new chunks have their payload read and checked against the CRC.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @return void
+ */
+static void
+bulk_rx_chunk(dw1000_dev_instance_t * inst){
+    dw1000_bulk_instance_t * bulk = inst->bulk;
+    dw1000_bulk_rx_t * rx = &bulk->rx;
+    bulk_data_frame_t frame;
+
+    memcpy(frame.array, inst->cb_data.header, sizeof(bulk_data_frame_t));
+    uint16_t len = inst->frame_len - sizeof(bulk_data_frame_t);
+    if (!rx->valid || frame.xfer_id != rx->xfer_id || frame.src_address != rx->src_address
+        || frame.chunk >= rx->nchunks || len > bulk->config.chunk_len){
+        bulk->stats.rx_out_of_window++;
+        return;
+    }
+    if (frame.chunk < rx->base || (frame.chunk - rx->base < DW1000_BULK_WINDOW_MAX && (rx->bitmap & (1UL << (frame.chunk - rx->base))))){
+        bulk->stats.rx_duplicates++;
+        return;
+    }
+    if (frame.chunk - rx->base >= DW1000_BULK_WINDOW_MAX){
+        bulk->stats.rx_out_of_window++;
+        return;
+    }
+
+    dw1000_read_rx(inst, bulk->buf, sizeof(bulk_data_frame_t), len);
+    if (crc16_ccitt(CRC16_INITIAL_CRC, bulk->buf, len) != frame.crc){
+        bulk->stats.rx_crc_errors++;
+        return;
+    }
+    if (bulk->rx_cb)
+        bulk->rx_cb(inst, frame.xfer_id, (uint32_t) frame.chunk * bulk->config.chunk_len, bulk->buf, len);
+    bulk->stats.rx_chunks++;
+
+    rx->bitmap |= 1UL << (frame.chunk - rx->base);
+    while ((rx->bitmap & 1) && rx->base < rx->nchunks){
+        rx->bitmap >>= 1;
+        rx->base++;
+    }
+    if (rx->base == rx->nchunks && !bulk->status.rx_complete){
+        bulk->status.rx_complete = 1;
+        if (bulk->config.postprocess)
+            os_eventq_put(os_eventq_dflt_get(), &bulk->bulk_callout_postprocess.c_ev);
+    }
+}
+
+/**
+ * Receive complete callback. On the receiver data chunks are delivered and queries and windows answered with a SACK,
+ * on the sender a SACK ends the window in flight.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @return void
+ */
+static void
+bulk_rx_complete_cb(dw1000_dev_instance_t * inst){
+    assert(inst != NULL);
+    if(inst->fctrl != FCNTL_IEEE_BULK_16){
+        if(inst->extension_cb->next != NULL){
+            inst->extension_cb = inst->extension_cb->next;
+            inst->extension_cb->rx_complete_cb(inst);
+        }
+        else if(inst->fctrl != FCNTL_IEEE_RANGE_16){
+            dw1000_dev_control_t control = inst->control_rx_context;
+            dw1000_restart_rx(inst, control);
+        }
+        return;
+    }
+    assert(inst->bulk != NULL);
+    dw1000_bulk_instance_t * bulk = inst->bulk;
+    dw1000_dev_control_t control = inst->control_rx_context;
+    uint16_t code, dst_address, src_address;
+
+    if (inst->frame_len < sizeof(bulk_data_frame_t)){
+        dw1000_restart_rx(inst, control);
+        return;
+    }
+    memcpy(&code, &inst->cb_data.header[offsetof(bulk_data_frame_t,code)], sizeof(uint16_t));
+    memcpy(&dst_address, &inst->cb_data.header[offsetof(bulk_data_frame_t,dst_address)], sizeof(uint16_t));
+    memcpy(&src_address, &inst->cb_data.header[offsetof(bulk_data_frame_t,src_address)], sizeof(uint16_t));
+    if (dst_address != inst->my_short_address && dst_address != BROADCAST_ADDRESS){
+        dw1000_restart_rx(inst, control);
+        return;
+    }
+
+    switch(code){
+        case DWT_BULK_DATA:
+            bulk_rx_chunk(inst);
+            dw1000_restart_rx(inst, control);
+            break;
+        case DWT_BULK_DATA_LAST:
+            {
+                bulk_rx_chunk(inst);
+                if (!bulk->rx.valid || src_address != bulk->rx.src_address){
+                    dw1000_restart_rx(inst, control);
+                    break;
+                }
+                uint64_t delay = inst->cb_data.rx_timestamp + ((uint64_t) bulk_tx_holdoff(inst, inst->frame_len) << 16);
+                if (bulk_start_ctrl(inst, DWT_BULK_SACK, bulk->rx.src_address, delay).start_tx_error)
+                    dw1000_restart_rx(inst, control);
+                break;
+            }
+        case DWT_BULK_QUERY:
+            {
+                bulk_ctrl_frame_t * frame = &bulk->ctrl;
+                if (inst->frame_len < sizeof(bulk_ctrl_frame_t)){
+                    dw1000_restart_rx(inst, control);
+                    break;
+                }
+                dw1000_read_rx_frame(inst, frame->array, sizeof(bulk_ctrl_frame_t));
+                // A query for the transfer in progress resumes it, anything else starts over
+                if (!bulk->rx.valid || frame->xfer_id != bulk->rx.xfer_id || frame->src_address != bulk->rx.src_address
+                    || frame->nchunks != bulk->rx.nchunks){
+                    bulk->rx = (dw1000_bulk_rx_t){
+                        .src_address = frame->src_address,
+                        .xfer_id = frame->xfer_id,
+                        .valid = 1,
+                        .nchunks = frame->nchunks,
+                    };
+                    bulk->status.rx_complete = 0;
+                }
+                uint64_t delay = inst->cb_data.rx_timestamp + ((uint64_t) bulk_tx_holdoff(inst, sizeof(bulk_ctrl_frame_t)) << 16);
+                if (bulk_start_ctrl(inst, DWT_BULK_SACK, bulk->rx.src_address, delay).start_tx_error)
+                    dw1000_restart_rx(inst, control);
+                break;
+            }
+        case DWT_BULK_SACK:
+            {
+                dw1000_bulk_tx_t * tx = &bulk->tx;
+                bulk_ctrl_frame_t * frame = &bulk->ctrl;
+                if (!bulk->status.window_pending || inst->frame_len < sizeof(bulk_ctrl_frame_t)){
+                    dw1000_restart_rx(inst, control);
+                    break;
+                }
+                dw1000_read_rx_frame(inst, frame->array, sizeof(bulk_ctrl_frame_t));
+                if (frame->xfer_id != tx->xfer_id || frame->src_address != tx->dst_address || frame->base < tx->base){
+                    dw1000_restart_rx(inst, control);
+                    break;
+                }
+                tx->base = frame->base;
+                tx->bitmap = frame->bitmap;
+                tx->retries = 0;
+                bulk->status.resync = 0;
+                bulk->stats.tx_windows++;
+                if (tx->base >= tx->nchunks){
+                    bulk->status.tx_complete = 1;
+                    if (bulk->config.postprocess)
+                        os_eventq_put(os_eventq_dflt_get(), &bulk->bulk_callout_postprocess.c_ev);
+                }
+                bulk_window_done(bulk);
+                break;
+            }
+        default:
+            dw1000_restart_rx(inst, control);
+            break;
+    }
+}
+
+/**
+ * Transmit complete callback. While a window is in flight the next chunk is scheduled bulk_tx_holdoff after the
+ * one just sent, so that the receiver has read and rearmed before it arrives.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @return void
+ */
+static void
+bulk_tx_complete_cb(dw1000_dev_instance_t * inst){
+    if(inst->fctrl != FCNTL_IEEE_BULK_16){
+        if(inst->extension_cb->next != NULL){
+            inst->extension_cb = inst->extension_cb->next;
+            if(inst->extension_cb->tx_complete_cb != NULL)
+                inst->extension_cb->tx_complete_cb(inst);
+        }
+        return;
+    }
+    dw1000_bulk_instance_t * bulk = inst->bulk;
+    if (!bulk->status.window_pending || bulk->status.resync)
+        return;
+
+    int idx = bulk_next_chunk(bulk);
+    if (idx < 0)
+        return;     // Last chunk of the window sent, waiting for the SACK
+
+    uint64_t delay = dw1000_read_txtime(inst) + ((uint64_t) bulk_tx_holdoff(inst, bulk->tx.frame_len) << 16);
+    bulk->status.start_tx_error = bulk_start_chunk(inst, idx, delay).start_tx_error;
+    if (bulk->status.start_tx_error){
+        bulk->status.resync = 1;    // Learn what made it through before sending more
+        bulk_window_done(bulk);
+    }
+}
+
+/**
+ * Receive timeout callback, a window or query went unanswered.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @return void
+ */
+static void
+bulk_rx_timeout_cb(dw1000_dev_instance_t * inst){
+    assert(inst != NULL);
+    if(inst->fctrl != FCNTL_IEEE_BULK_16){
+        if(inst->extension_cb->next != NULL){
+            inst->extension_cb = inst->extension_cb->next;
+            if(inst->extension_cb->rx_timeout_cb != NULL)
+                inst->extension_cb->rx_timeout_cb(inst);
+        }
+        return;
+    }
+    assert(inst->bulk != NULL);
+    if (inst->bulk->status.window_pending)
+        bulk_window_lost(inst->bulk);
+    else{
+        dw1000_dev_control_t control = inst->control_rx_context;
+        dw1000_restart_rx(inst, control);
+    }
+}
+
+/**
+ * Receive error callback, a corrupted SACK counts as an unanswered window.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @return void
+ */
+static void
+bulk_rx_error_cb(dw1000_dev_instance_t * inst){
+    assert(inst != NULL);
+    if(inst->fctrl != FCNTL_IEEE_BULK_16){
+        if(inst->extension_cb->next != NULL){
+            inst->extension_cb = inst->extension_cb->next;
+            if(inst->extension_cb->rx_error_cb != NULL)
+                inst->extension_cb->rx_error_cb(inst);
+        }
+        return;
+    }
+    assert(inst->bulk != NULL);
+    if (inst->bulk->status.window_pending)
+        bulk_window_lost(inst->bulk);
+    else{
+        dw1000_dev_control_t control = inst->control_rx_context;
+        dw1000_restart_rx(inst, control);
+    }
+}
+
+/**
+ * Transmit error callback.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @return void
+ */
+static void
+bulk_tx_error_cb(dw1000_dev_instance_t * inst){
+    assert(inst != NULL);
+    if(inst->fctrl != FCNTL_IEEE_BULK_16){
+        if(inst->extension_cb->next != NULL){
+            inst->extension_cb = inst->extension_cb->next;
+            if(inst->extension_cb->tx_error_cb != NULL)
+                inst->extension_cb->tx_error_cb(inst);
+        }
+        return;
+    }
+    assert(inst->bulk != NULL);
+    if (inst->bulk->status.window_pending){
+        inst->bulk->status.start_tx_error = 1;
+        inst->bulk->status.resync = 1;
+        bulk_window_done(inst->bulk);
+    }
+}
+
+/**
+ * Set up an outbound transfer. No frame is sent, the first dw1000_bulk_window queries the receiver, which resumes
+ * a transfer with the same xfer_id from where it stopped. The blob must stay valid until the transfer completes.
+ *
+ * @param inst          Pointer to dw1000_dev_instance_t.
+ * @param dst_address   Receiver short address.
+ * @param xfer_id       Transfer identifier, change it for every new blob.
+ * @param data          Blob to send.
+ * @param len           Length of the blob, at most 65535 chunks.
+ * @return dw1000_bulk_status_t
+ */
+dw1000_bulk_status_t
+dw1000_bulk_write(dw1000_dev_instance_t * inst, uint16_t dst_address, uint8_t xfer_id, const uint8_t * data, uint32_t len){
+    assert(inst != NULL);
+    assert(inst->bulk != NULL);
+    dw1000_bulk_instance_t * bulk = inst->bulk;
+    assert(len <= (uint32_t) bulk->config.chunk_len * UINT16_MAX);
+
+    os_error_t err = os_sem_pend(&bulk->sem, OS_TIMEOUT_NEVER); // Wait for a window in flight
+    assert(err == OS_OK);
+
+    bulk->tx = (dw1000_bulk_tx_t){
+        .data = data,
+        .len = len,
+        .dst_address = dst_address,
+        .xfer_id = xfer_id,
+        .nchunks = (len + bulk->config.chunk_len - 1) / bulk->config.chunk_len,
+    };
+    bulk->status.tx_complete = bulk->tx.nchunks == 0;
+    bulk->status.resync = 1;
+    bulk->status.suspended = 0;
+
+    err = os_sem_release(&bulk->sem);
+    assert(err == OS_OK);
+    return bulk->status;
+}
+
+/**
+ * Run one window of the outbound transfer: a query when the receiver state is unknown, otherwise up to config.window
+ * missing chunks followed by the SACK. The airtime of a window is bounded by dw1000_bulk_window_duration, call this
+ * from a TDMA slot to interleave the transfer with ranging. Repeat until status.tx_complete.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @param mode  dw1000_dev_modes_t for DWT_BLOCKING, DWT_NONBLOCKING.
+ * @return dw1000_bulk_status_t
+ */
+dw1000_bulk_status_t
+dw1000_bulk_window(dw1000_dev_instance_t * inst, dw1000_dev_modes_t mode){
+    assert(inst != NULL);
+    assert(inst->bulk != NULL);
+    dw1000_bulk_instance_t * bulk = inst->bulk;
+
+    os_error_t err = os_sem_pend(&bulk->sem, OS_TIMEOUT_NEVER);
+    assert(err == OS_OK);
+
+    if (bulk->tx.data == NULL || bulk->status.tx_complete || bulk->status.suspended){
+        err = os_sem_release(&bulk->sem);
+        assert(err == OS_OK);
+        return bulk->status;
+    }
+
+    bulk->status.window_pending = 1;
+    bulk->tx.next = bulk->tx.burst = 0;
+    if (bulk->status.resync)
+        bulk->status.start_tx_error = bulk_start_ctrl(inst, DWT_BULK_QUERY, bulk->tx.dst_address, 0).start_tx_error;
+    else
+        bulk->status.start_tx_error = bulk_start_chunk(inst, bulk_next_chunk(bulk), 0).start_tx_error;
+
+    if (bulk->status.start_tx_error)
+        bulk_window_done(bulk);
+    else if (mode == DWT_BLOCKING){
+        err = os_sem_pend(&bulk->sem, OS_TIMEOUT_NEVER); // Wait for the SACK, timeout or error
+        assert(err == OS_OK);
+        err = os_sem_release(&bulk->sem);
+        assert(err == OS_OK);
+    }
+    return bulk->status;
+}
+
+/**
+ * Resume a suspended or interrupted transfer. The next window queries the receiver for the chunks it holds.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @return void
+ */
+void
+dw1000_bulk_resume(dw1000_dev_instance_t * inst){
+    assert(inst != NULL);
+    assert(inst->bulk != NULL);
+    dw1000_bulk_instance_t * bulk = inst->bulk;
+
+    os_error_t err = os_sem_pend(&bulk->sem, OS_TIMEOUT_NEVER);
+    assert(err == OS_OK);
+    bulk->status.resync = 1;
+    bulk->status.suspended = 0;
+    bulk->tx.retries = 0;
+    err = os_sem_release(&bulk->sem);
+    assert(err == OS_OK);
+}
+
+/**
+ * Airtime of a full window, from the first preamble to the end of the SACK, for sizing TDMA slots. Host latency
+ * ahead of the first frame is not included.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @return uint32_t Duration in UWB usec.
+ */
+uint32_t
+dw1000_bulk_window_duration(dw1000_dev_instance_t * inst){
+    assert(inst != NULL);
+    assert(inst->bulk != NULL);
+    dw1000_bulk_instance_t * bulk = inst->bulk;
+    uint16_t nlen = sizeof(bulk_data_frame_t) + bulk->config.chunk_len;
+
+    return dw1000_phy_SHR_duration(inst) + bulk->config.window * bulk_tx_holdoff(inst, nlen)
+        + dw1000_phy_data_duration(inst, sizeof(bulk_ctrl_frame_t));
+}
+
+#endif /* MYNEWT_VAL(DW1000_BULK) */
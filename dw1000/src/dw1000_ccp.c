@@ -38,7 +38,11 @@
 #include "bsp/bsp.h"
 
 #if MYNEWT_VAL(DW1000_CCP_ENABLED)
+#include <dw1000/dw1000_phy.h>
 #include <dw1000/dw1000_ccp.h>
+#if MYNEWT_VAL(DW1000_COEX)
+#include <dw1000/dw1000_coex.h>
+#endif
 
 #if MYNEWT_VAL(CLOCK_CALIBRATION_ENABLED)
 #include <clkcal/clkcal.h>
@@ -57,6 +61,18 @@
  sos2c(sos,'g_fs_xtalt')
 */
 #define FS_XTALT_SETTLINGTIME 17
+#if MYNEWT_VAL(DW1000_DSP_FIXEDPOINT)
+static const int32_t g_fs_xtalt_b_q30[] ={
+     	DW1000_Q(2.160326e-04, 30), DW1000_Q(9.661246e-05, 30), DW1000_Q(2.160326e-04, 30), 
+     	DW1000_Q(1.000000e+00, 30), DW1000_Q(-1.302658e+00, 30), DW1000_Q(1.000000e+00, 30), 
+     	DW1000_Q(1.000000e+00, 30), DW1000_Q(-1.593398e+00, 30), DW1000_Q(1.000000e+00, 30), 
+     	};
+static const int32_t g_fs_xtalt_a_q30[] ={
+     	DW1000_Q(1.000000e+00, 30), DW1000_Q(-1.555858e+00, 30), DW1000_Q(6.083635e-01, 30), 
+     	DW1000_Q(1.000000e+00, 30), DW1000_Q(-1.661260e+00, 30), DW1000_Q(7.136943e-01, 30), 
+     	DW1000_Q(1.000000e+00, 30), DW1000_Q(-1.836731e+00, 30), DW1000_Q(8.911796e-01, 30), 
+     	};
+#else
 static float g_fs_xtalt_b[] ={
      	2.160326e-04, 9.661246e-05, 2.160326e-04, 
      	1.000000e+00, -1.302658e+00, 1.000000e+00, 
@@ -67,15 +83,25 @@ static float g_fs_xtalt_a[] ={
      	1.000000e+00, -1.661260e+00, 7.136943e-01, 
      	1.000000e+00, -1.836731e+00, 8.911796e-01, 
      	};
+#endif
 /*
 % From Figure 29 PPM vs Crystal Trim
 p=polyfit([30,20,0,-18],[0,5,17,30],2) 
 mat2c(p,'g_fs_xtalt_poly')
+% Fixed point, in u = ppm / FS_XTALT_PPM_SCALE
+mat2c(p .* FS_XTALT_PPM_SCALE.^(2:-1:0) * 2^16,'g_fs_xtalt_poly_q16')
 */
+#if MYNEWT_VAL(DW1000_DSP_FIXEDPOINT)
+#define FS_XTALT_PPM_SCALE 64
+static const int32_t g_fs_xtalt_poly_q16[] ={
+     	DW1000_Q(3.252948e-03 * FS_XTALT_PPM_SCALE * FS_XTALT_PPM_SCALE, 16), DW1000_Q(-6.641957e-01 * FS_XTALT_PPM_SCALE, 16), DW1000_Q(1.699287e+01, 16), 
+     	};
+#else
 static float g_fs_xtalt_poly[] ={
      	3.252948e-03, -6.641957e-01, 1.699287e+01, 
      	};
 #endif
+#endif
 
 
 static void ccp_rx_complete_cb(struct _dw1000_dev_instance_t * inst);
@@ -87,6 +113,9 @@ static struct _dw1000_ccp_status_t dw1000_ccp_blink(struct _dw1000_dev_instance_
 #if MYNEWT_VAL(CLOCK_CALIBRATION_ENABLED) !=1
 static void ccp_postprocess(struct os_event * ev);
 #endif
+#if MYNEWT_VAL(DW1000_CCP_EXT_SYNC)
+static void ccp_ext_sync_resume_blinks(struct _dw1000_dev_instance_t * inst);
+#endif
 
 /** 
  * The OS scheduler is not accurate enough for the timing requirement of an RTLS system.  
@@ -104,8 +133,12 @@ ccp_timer_ev_cb(struct os_event *ev) {
 
     dw1000_dev_instance_t * inst = (dw1000_dev_instance_t *)ev->ev_arg;
     dw1000_ccp_instance_t * ccp = inst->ccp; 
+#if MYNEWT_VAL(DW1000_CCP_EXT_SYNC)
+    if (ccp->status.ext_sync_locked)
+        return;     // The wired sync stands in for the blinks, resumed when it is lost
+#endif
     if(dw1000_ccp_blink(inst, DWT_BLOCKING).start_tx_error)
-      os_callout_reset(&ccp->callout_timer, OS_TICKS_PER_SEC * (ccp->period - MYNEWT_VAL(OS_LATENCY)) * 1e-6);
+      os_callout_reset(&ccp->callout_timer, OS_TICKS_PER_SEC * (ccp->period - MYNEWT_VAL(OS_LATENCY) - dw1000_phy_SHR_duration(inst)) * 1e-6);
 }
 
 /**
@@ -190,6 +223,8 @@ dw1000_ccp_init(struct _dw1000_dev_instance_t * inst, uint16_t nframes, uint64_t
     ccp_cbs.tx_error_cb = ccp_tx_error_cb;
     
     dw1000_ccp_set_ext_callbacks(inst, ccp_cbs);
+    // CCP blinks are reserved frame types, pass them until TDMA narrows the window to slot 0
+    dw1000_mac_framefilter_window(inst, DW1000_CCP, true);
 
     dw1000_ccp_instance_t * ccp = inst->ccp; 
     ccp_frame_t * frame = ccp->frames[(ccp->idx)%ccp->nframes]; 
@@ -201,7 +236,11 @@ dw1000_ccp_init(struct _dw1000_dev_instance_t * inst, uint16_t nframes, uint64_t
 #endif
 
 #if MYNEWT_VAL(FS_XTALT_AUTOTUNE_ENABLED) 
+#if MYNEWT_VAL(DW1000_DSP_FIXEDPOINT)
+    inst->ccp->xtalt_sos = dw1000_sosfilt_q31_init(NULL, sizeof(g_fs_xtalt_b_q30)/sizeof(int32_t)/DW1000_BIQUAD_N);
+#else
     inst->ccp->xtalt_sos = sosfilt_init(NULL, sizeof(g_fs_xtalt_b)/sizeof(float)/BIQUAD_N);
+#endif
 #endif
 
     inst->ccp->status.initialized = 1;
@@ -221,7 +260,11 @@ dw1000_ccp_free(dw1000_ccp_instance_t * inst){
     clkcal_free(inst->clkcal);
 #endif         
 #if MYNEWT_VAL(FS_XTALT_AUTOTUNE_ENABLED) 
+#if MYNEWT_VAL(DW1000_DSP_FIXEDPOINT)
+    dw1000_sosfilt_q31_free(inst->xtalt_sos);
+#else
     sosfilt_free(inst->xtalt_sos);
+#endif
 #endif   
     if (inst->status.selfmalloc){
         for (uint16_t i = 0; i < inst->nframes; i++)
@@ -304,7 +347,7 @@ ccp_rx_complete_cb(struct _dw1000_dev_instance_t * inst){
     if (inst->fctrl_array[0] == FCNTL_IEEE_BLINK_CCP_64){
         // CCP Packet Received
         uint64_t clock_master;
-        dw1000_read_rx(inst, (uint8_t *) &clock_master, offsetof(ieee_blink_frame_t,long_address), sizeof(uint64_t));
+        memcpy(&clock_master, &inst->cb_data.header[offsetof(ieee_blink_frame_t,long_address)], sizeof(uint64_t));
         if(inst->clock_master != clock_master){
             dw1000_restart_rx(inst, inst->control_rx_context);
             return;
@@ -328,14 +371,25 @@ ccp_rx_complete_cb(struct _dw1000_dev_instance_t * inst){
         return;
     }
     dw1000_ccp_instance_t * ccp = inst->ccp; 
+#if MYNEWT_VAL(DW1000_CCP_EXT_SYNC)
+    if (ccp->status.ext_sync_locked){
+        // Blinks are on another timebase than the wired sync, only the fallback uses them
+        dw1000_restart_rx(inst, inst->control_rx_context);
+        return;
+    }
+#endif
     ccp_frame_t * frame = ccp->frames[(++ccp->idx)%ccp->nframes];
     
-    dw1000_read_rx(inst, frame->array, 0, sizeof(ieee_blink_frame_t));
+    dw1000_read_rx_frame(inst, frame->array, sizeof(ieee_blink_frame_t));
+#if MYNEWT_VAL(DW1000_COEX)
+    if (inst->coex && inst->frame_len >= sizeof(ieee_blink_frame_t) + sizeof(dw1000_coex_ie_t))
+        dw1000_coex_beacon_rx(inst, sizeof(ieee_blink_frame_t));
+#endif
 
 #if MYNEWT_VAL(ADAPTIVE_TIMESCALE_ENABLED) 
     frame->reception_timestamp = _dw1000_read_rxtime_raw(inst); 
 #else
-    frame->reception_timestamp = dw1000_read_rxtime(inst);
+    frame->reception_timestamp = inst->cb_data.rx_timestamp;
 #endif
 
     int32_t tracking_interval = (int32_t) dw1000_read_reg(inst, RX_TTCKI_ID, 0, sizeof(int32_t));
@@ -351,11 +405,25 @@ ccp_rx_complete_cb(struct _dw1000_dev_instance_t * inst){
     }
 #if MYNEWT_VAL(FS_XTALT_AUTOTUNE_ENABLED) 
     if (ccp->config.fs_xtalt_autotune && ccp->status.valid){  
+#if MYNEWT_VAL(DW1000_DSP_FIXEDPOINT)
+        // Offset in ppm Q16, the 19-bit tracking offset scaled by 1e6 * 2^16 stays within 64 bits
+        int32_t fs_xtalt_offset = (int32_t)(((int64_t) tracking_offset * 1000000 * 65536) / tracking_interval);
+        fs_xtalt_offset = dw1000_sosfilt_q31(ccp->xtalt_sos, fs_xtalt_offset, g_fs_xtalt_b_q30, g_fs_xtalt_a_q30);
+#else
         float fs_xtalt_offset = sosfilt(ccp->xtalt_sos,  1e6 * ((float)tracking_offset) / tracking_interval, g_fs_xtalt_b, g_fs_xtalt_a);  
+#endif
         if(ccp->xtalt_sos->clk % FS_XTALT_SETTLINGTIME == 0){ 
             int8_t reg = dw1000_read_reg(inst, FS_CTRL_ID, FS_XTALT_OFFSET, sizeof(uint8_t)) & FS_XTALT_MASK;
+#if MYNEWT_VAL(DW1000_DSP_FIXEDPOINT)
+            int32_t u = fs_xtalt_offset / (FS_XTALT_PPM_SCALE << 1);   // ppm Q16 to u Q15
+            u = (u < INT16_MIN) ? INT16_MIN : (u > INT16_MAX) ? INT16_MAX : u;
+            int32_t trim_q16 = dw1000_polyval_q15(g_fs_xtalt_poly_q16, u, sizeof(g_fs_xtalt_poly_q16)/sizeof(int32_t)) 
+                                - g_fs_xtalt_poly_q16[sizeof(g_fs_xtalt_poly_q16)/sizeof(int32_t) - 1];
+            int8_t trim_code = (int8_t)((trim_q16 + (1 << 15)) >> 16);
+#else
             int8_t trim_code = (int8_t) roundf(polyval(g_fs_xtalt_poly, fs_xtalt_offset, sizeof(g_fs_xtalt_poly)/sizeof(float)) 
                                 - polyval(g_fs_xtalt_poly, 0, sizeof(g_fs_xtalt_poly)/sizeof(float)));
+#endif
             if(reg - trim_code < 0)
                 reg = 0;
             else if(reg - trim_code > FS_XTALT_MASK)
@@ -412,7 +480,7 @@ ccp_tx_complete_cb(struct _dw1000_dev_instance_t * inst){
         frame->seq_num
     );
     if (ccp->status.timer_enabled) 
-        os_callout_reset(&ccp->callout_timer, OS_TICKS_PER_SEC * (ccp->period - MYNEWT_VAL(OS_LATENCY)) * 1e-6);    
+        os_callout_reset(&ccp->callout_timer, OS_TICKS_PER_SEC * (ccp->period - MYNEWT_VAL(OS_LATENCY) - dw1000_phy_SHR_duration(inst)) * 1e-6);    
     os_sem_release(&inst->ccp->sem);  
 }
 
@@ -495,8 +563,13 @@ dw1000_ccp_blink(struct _dw1000_dev_instance_t * inst, dw1000_dev_modes_t mode){
     frame->seq_num += inst->ccp->nframes;
     frame->long_address = inst->my_short_address;
 
+    uint16_t frame_len = sizeof(ieee_blink_frame_t);
     dw1000_write_tx(inst, frame->array, 0, sizeof(ieee_blink_frame_t));
-    dw1000_write_tx_fctrl(inst, sizeof(ieee_blink_frame_t), 0, true); 
+#if MYNEWT_VAL(DW1000_COEX)
+    if (inst->coex)
+        frame_len += dw1000_coex_beacon_tx(inst, sizeof(ieee_blink_frame_t));
+#endif
+    dw1000_write_tx_fctrl(inst, frame_len, 0, true); 
     dw1000_set_wait4resp(inst, false);    
     dw1000_set_delay_start(inst, frame->transmission_timestamp); 
    
@@ -545,4 +618,187 @@ dw1000_ccp_stop(dw1000_dev_instance_t * inst){
     os_callout_stop(&ccp->callout_timer);
 }
 
+#if MYNEWT_VAL(DW1000_CCP_EXT_SYNC)
+
+#define CCP_EXT_SYNC_WAIT_DTU       (1664)          //!< Device time units per 38.4 MHz wait counter cycle
+#define CCP_EXT_SYNC_TOLERANCE_DTU  (0x4000000ULL)  //!< About 1 ms, timebase error taken as a reset
+#define CCP_SYSTIME_MASK            (0xFFFFFFFFFFULL)
+
+/**
+ * Device time units to usecs.
+ *
+ * @param dtu  Duration in device time units.
+ * @return uint32_t usecs
+ */
+static uint32_t
+ccp_dtu_to_usecs(uint64_t dtu){
+    return (dtu * 10) / 638976;
+}
+
+/**
+ * Usecs to device time units.
+ *
+ * @param usecs  Duration in usecs.
+ * @return uint64_t device time units
+ */
+static uint64_t
+ccp_usecs_to_dtu(uint32_t usecs){
+    return ((uint64_t) usecs * 638976) / 10;
+}
+
+/**
+ * Arm the one-shot timebase reset and note the system and CPU times it was armed at.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @return void
+ */
+static void
+ccp_ext_sync_arm(struct _dw1000_dev_instance_t * inst){
+    dw1000_ccp_instance_t * ccp = inst->ccp;
+    dw1000_phy_external_sync(inst, ccp->ext_sync_wait, true);
+    ccp->ext_sync_cputime = os_cputime_get32();
+    ccp->ext_sync_systime = dw1000_read_systime(inst);
+}
+
+/**
+ * Restart the clock master blinks from the current timebase, the sequence left off before the wired sync took over
+ * is meaningless after the timebase resets. The latest synthetic frame is retired as if it had been sent, the way
+ * ccp_tx_complete_cb advances the index, so the first resumed blink follows it in sequence number and is timed from now.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @return void
+ */
+static void
+ccp_ext_sync_resume_blinks(struct _dw1000_dev_instance_t * inst){
+    dw1000_ccp_instance_t * ccp = inst->ccp;
+    if (!ccp->status.timer_enabled)
+        return;
+    ccp_frame_t * previous_frame = ccp->frames[(ccp->idx)%ccp->nframes];
+    ccp_frame_t * frame = ccp->frames[(++ccp->idx)%ccp->nframes];
+    previous_frame->transmission_timestamp = dw1000_read_systime(inst);
+    frame->seq_num = previous_frame->seq_num + 1 - ccp->nframes;   // dw1000_ccp_blink adds nframes to the reused slot
+    os_callout_reset(&ccp->callout_timer, OS_TICKS_PER_SEC/100);
+}
+
+/**
+ * Wired sync check timer, runs in interrupt context and defers to the default queue.
+ *
+ * @param arg  Pointer to dw1000_dev_instance_t.
+ * @return void
+ */
+static void
+ccp_ext_sync_timer_cb(void * arg){
+    dw1000_dev_instance_t * inst = (dw1000_dev_instance_t *) arg;
+    os_eventq_put(os_eventq_dflt_get(), &inst->ccp->ext_sync_ev);
+}
+
+/**
+ * Look for a timebase reset since the last check. The DW1000 does not flag the reset, it is recognised by the system
+ * time having moved away from the CPU time by more than the tolerance while reading less than the time since arming.
+ * On a reset a CCP frame is entered with the sync edge as its timestamp, on the local timebase that is -ext_sync_offset
+ * for every node, and the postprocess runs as it would for a received blink. Once locked the check is timed from the
+ * edge, so it runs at the CCP frame latency that the TDMA superframe timing expects.
+ *
+ * @param ev  Pointer to os_events.
+ * @return void
+ */
+static void
+ccp_ext_sync_ev_cb(struct os_event * ev){
+    assert(ev != NULL);
+    assert(ev->ev_arg != NULL);
+    dw1000_dev_instance_t * inst = (dw1000_dev_instance_t *)ev->ev_arg;
+    dw1000_ccp_instance_t * ccp = inst->ccp;
+    if (!ccp->status.ext_sync)
+        return;
+
+    uint32_t cputime = os_cputime_get32();
+    uint64_t systime = dw1000_read_systime(inst);
+    uint64_t elapsed = ccp_usecs_to_dtu(os_cputime_ticks_to_usecs(cputime - ccp->ext_sync_cputime));
+    uint64_t error = (systime - ccp->ext_sync_systime - elapsed) & CCP_SYSTIME_MASK;
+    error = (error > (CCP_SYSTIME_MASK >> 1)) ? CCP_SYSTIME_MASK + 1 - error : error;
+    uint32_t period = ccp_dtu_to_usecs((uint64_t) ccp->period << 16);
+
+    if (error < CCP_EXT_SYNC_TOLERANCE_DTU || systime > elapsed + CCP_EXT_SYNC_TOLERANCE_DTU){
+        if (ccp->status.ext_sync_locked && ++ccp->ext_sync_misses >= MYNEWT_VAL(DW1000_CCP_EXT_SYNC_MISSES)){
+            ccp->status.ext_sync_locked = 0;
+            ccp_ext_sync_resume_blinks(inst);
+        }
+        ccp_ext_sync_arm(inst);
+        os_cputime_timer_relative(&ccp->ext_sync_timer, period);
+        return;
+    }
+
+    uint32_t edge = cputime - os_cputime_usecs_to_ticks(ccp_dtu_to_usecs(systime + ccp->ext_sync_offset));
+    ccp_ext_sync_arm(inst);
+    ccp->ext_sync_misses = 0;
+    // On the clock master frames[idx] is the slot of the next blink, the first synthetic frame takes it
+    if (!ccp->status.timer_enabled || ccp->status.ext_sync_locked)
+        ccp->idx++;
+    ccp->status.ext_sync_locked = 1;
+
+    ccp_frame_t * previous_frame = ccp->frames[(ccp->idx-1)%ccp->nframes];
+    ccp_frame_t * frame = ccp->frames[(ccp->idx)%ccp->nframes];
+    frame->seq_num = previous_frame->seq_num + 1;
+    frame->long_address = inst->clock_master;
+    frame->reception_timestamp = frame->transmission_timestamp = (0 - (uint64_t) ccp->ext_sync_offset) & CCP_SYSTIME_MASK;
+    frame->correction_factor = 1.0f;
+    ccp->status.valid |= ccp->idx > ccp->nframes;
+    if (ccp->config.postprocess && ccp->status.valid)
+        os_eventq_put(os_eventq_dflt_get(), &ccp->callout_postprocess.c_ev);
+
+    uint32_t latency = ccp_dtu_to_usecs((uint64_t)(MYNEWT_VAL(OS_LATENCY) + dw1000_phy_data_duration(inst, sizeof(ccp_frame_t))) << 16);
+    os_cputime_timer_start(&ccp->ext_sync_timer, edge + os_cputime_usecs_to_ticks(period + latency));
+}
+
+/**
+ * Use a cabled SYNC signal in place of the CCP blinks. Each pulse resets the timebase of every node wired to it, one
+ * pulse per CCP period is expected. While the pulses arrive the clock master stops blinking and received blinks are
+ * ignored; after DW1000_CCP_EXT_SYNC_MISSES periods without one, wireless CCP takes over until they return. Delayed
+ * transmits and receives must not be scheduled across a pulse.
+ *
+ * @param inst   Pointer to dw1000_dev_instance_t.
+ * @param wait   Wait counter, 38.4 MHz cycles from the sync edge to the reset.
+ * @param delay  Cable and board delay of this node from the sync source, in device time units.
+ * @return void
+ */
+void
+dw1000_ccp_ext_sync_start(struct _dw1000_dev_instance_t * inst, uint8_t wait, uint32_t delay){
+    dw1000_ccp_instance_t * ccp = inst->ccp;
+    assert(ccp);
+
+    ccp->ext_sync_wait = wait;
+    ccp->ext_sync_offset = delay + wait * CCP_EXT_SYNC_WAIT_DTU;
+    ccp->ext_sync_misses = 0;
+    ccp->ext_sync_ev.ev_cb = ccp_ext_sync_ev_cb;
+    ccp->ext_sync_ev.ev_arg = (void *) inst;
+    os_cputime_timer_init(&ccp->ext_sync_timer, ccp_ext_sync_timer_cb, (void *) inst);
+    ccp->status.ext_sync_locked = 0;
+    ccp->status.ext_sync = 1;
+
+    ccp_ext_sync_arm(inst);
+    os_cputime_timer_relative(&ccp->ext_sync_timer, ccp_dtu_to_usecs((uint64_t) ccp->period << 16));
+}
+
+/**
+ * Stop using the SYNC signal, wireless CCP resumes.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @return void
+ */
+void
+dw1000_ccp_ext_sync_stop(struct _dw1000_dev_instance_t * inst){
+    dw1000_ccp_instance_t * ccp = inst->ccp;
+    assert(ccp);
+
+    ccp->status.ext_sync = 0;
+    os_cputime_timer_stop(&ccp->ext_sync_timer);
+    dw1000_phy_external_sync(inst, 0, false);
+    if (ccp->status.ext_sync_locked){
+        ccp->status.ext_sync_locked = 0;
+        ccp_ext_sync_resume_blinks(inst);
+    }
+}
+
+#endif /* DW1000_CCP_EXT_SYNC */
+
 #endif /* MYNEWT_VAL(DW1000_CCP_ENABLED) */
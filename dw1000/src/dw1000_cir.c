@@ -0,0 +1,250 @@
+/*
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file dw1000_cir.c
+ * @date 2026
+ * @brief channel impulse response capture
+ *
+ * @details This is the CIR capture service. dw1000_cir_capture is called by the interrupt handler for every good
+ * frame once the receive callbacks have returned, so a ranging response is committed before the accumulator is read.
+ * The accumulator keeps the frame until the next preamble is accumulated; a receiver re-enabled by a callback can
+ * only lose it to a frame that is already on air by the time the capture runs. Frames failing the capture policy cost
+ * a few comparisons. A captured window is read in DW1000_CIR_CHUNK_LEN byte chunks, the ACC clocks being forced on
+ * and released again under the device mutex for each chunk, so the PMSC_CTRL0 read modify write cannot interleave
+ * with another one and a register update is never held off by more than one chunk. Records are exported from the
+ * default event queue.
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <os/os.h>
+#include <hal/hal_spi.h>
+#include <hal/hal_gpio.h>
+#include "bsp/bsp.h"
+
+#include <dw1000/dw1000_regs.h>
+#include <dw1000/dw1000_dev.h>
+#include <dw1000/dw1000_hal.h>
+#include <dw1000/dw1000_mac.h>
+#include <dw1000/dw1000_phy.h>
+#include <dw1000/dw1000_ftypes.h>
+
+#if MYNEWT_VAL(DW1000_CIR)
+#include <dw1000/dw1000_cir.h>
+
+static void cir_postprocess(struct os_event * ev);
+static void cir_read_taps(dw1000_dev_instance_t * inst, uint8_t * taps, uint16_t first_tap, uint16_t ntaps);
+
+/**
+ * Allocate resources for CIR capture. Receive diagnostics are turned on, the capture window is placed from them.
+ *
+ * @param inst       Pointer to dw1000_dev_instance_t.
+ * @param config     Capture policy.
+ * @param output_cb  Record output callback.
+ * @return dw1000_cir_instance_t
+ */
+dw1000_cir_instance_t *
+dw1000_cir_init(dw1000_dev_instance_t * inst, dw1000_cir_config_t config, dw1000_cir_output_cb_t * output_cb){
+    assert(inst);
+    assert(output_cb);
+
+    if (inst->cir == NULL ){
+        inst->cir = (dw1000_cir_instance_t *) malloc(sizeof(dw1000_cir_instance_t));
+        assert(inst->cir);
+        memset(inst->cir, 0, sizeof(dw1000_cir_instance_t));
+        inst->cir->status.selfmalloc = 1;
+    }
+    dw1000_cir_instance_t * cir = inst->cir;
+
+    cir->parent = inst;
+    cir->output_cb = output_cb;
+    dw1000_cir_config(inst, config);
+    os_callout_init(&cir->cir_callout_postprocess, os_eventq_dflt_get(), cir_postprocess, (void *) inst);
+    inst->config.rxdiag_enable = 1;
+    cir->status.initialized = 1;
+    return cir;
+}
+
+/**
+ * Free resources. Captures not yet exported are lost.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @return void
+ */
+void
+dw1000_cir_free(dw1000_dev_instance_t * inst){
+    assert(inst != NULL);
+    assert(inst->cir != NULL);
+    os_callout_stop(&inst->cir->cir_callout_postprocess);
+    if (inst->cir->status.selfmalloc){
+        free(inst->cir);
+        inst->cir = NULL;
+    }
+    else
+        inst->cir->status.initialized = 0;
+}
+
+/**
+ * Set the capture policy.
+ *
+ * @param inst    Pointer to dw1000_dev_instance_t.
+ * @param config  Capture policy.
+ * @return void
+ */
+void
+dw1000_cir_config(dw1000_dev_instance_t * inst, dw1000_cir_config_t config){
+    assert(inst->cir);
+    assert(config.pre + config.post > 0);
+    assert(config.pre + config.post <= MYNEWT_VAL(DW1000_CIR_MAX_TAPS));
+    inst->cir->config = config;
+    inst->cir->eligible = 0;
+}
+
+/**
+ * Capture the accumulator window around the first path of the frame just received, if the frame passes the capture
+ * policy. Called from the interrupt handler after the receive callbacks, once the diagnostics are in cb_data.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @return void
+ */
+void
+dw1000_cir_capture(dw1000_dev_instance_t * inst){
+    dw1000_cir_instance_t * cir = inst->cir;
+    const dw1000_dev_rxdiag_t * diag = dw1000_mac_rxdiag(inst);
+    uint16_t src_address = 0xFFFF;
+    uint8_t seq_num = 0;
+
+    if (!cir->status.initialized || diag == NULL)
+        return;
+
+    // Source and sequence number are only known for 16-bit source addressing, as used by every service in this driver
+    if ((inst->fctrl & 0xCC00) == 0x8800 && inst->frame_len >= offsetof(ieee_std_frame_t, src_address) + sizeof(uint16_t)){
+        seq_num = inst->cb_data.header[offsetof(ieee_std_frame_t, seq_num)];
+        memcpy(&src_address, &inst->cb_data.header[offsetof(ieee_std_frame_t, src_address)], sizeof(uint16_t));
+    }
+    if (cir->config.src_address != 0xFFFF && cir->config.src_address != src_address)
+        return;
+    if (cir->config.fp_snr_max && (uint32_t) diag->fp_amp >= (uint32_t) cir->config.fp_snr_max * diag->rx_std)
+        return;
+    if (cir->config.every_nth > 1 && (cir->eligible++ % cir->config.every_nth) != 0)
+        return;
+
+    uint8_t fill = cir->fill;
+    if (cir->busy & (1 << fill)){
+        cir->dropped++;
+        cir->stats.dropped++;
+        return;
+    }
+
+    dw1000_cir_buffer_t * buffer = &cir->buffers[fill];
+    dw1000_cir_record_t * record = &buffer->record;
+    uint16_t acc_len = (inst->config.prf == DWT_PRF_16M) ? DW1000_CIR_TAPS_PRF16 : DW1000_CIR_TAPS_PRF64;
+    uint16_t ntaps = cir->config.pre + cir->config.post;
+    int32_t first_tap = (int32_t)(diag->fp_idx >> 6) - cir->config.pre;
+
+    if (first_tap + ntaps > acc_len)
+        first_tap = acc_len - ntaps;
+    if (first_tap < 0)
+        first_tap = 0;
+
+    cir_read_taps(inst, buffer->taps, first_tap, ntaps);
+
+    record->sync = DW1000_CIR_SYNC;
+    record->ntaps = ntaps;
+    record->first_tap = first_tap;
+    record->fp_idx = diag->fp_idx;
+    for (uint8_t i = 0; i < sizeof(record->rx_timestamp); i++)
+        record->rx_timestamp[i] = (inst->cb_data.rx_timestamp >> (8 * i)) & 0xFF;
+    record->seq_num = seq_num;
+    record->src_address = src_address;
+    record->fp_amp = diag->fp_amp;
+    record->fp_amp2 = diag->fp_amp2;
+    record->fp_amp3 = diag->fp_amp3;
+    record->rx_std = diag->rx_std;
+    record->cir_pwr = diag->cir_pwr;
+    record->pacc_cnt = diag->pacc_cnt;
+    record->dropped = cir->dropped;
+
+    cir->dropped = 0;
+    cir->busy |= (1 << fill);
+    cir->fill = fill ^ 1;
+    os_eventq_put(os_eventq_dflt_get(), &cir->cir_callout_postprocess.c_ev);
+}
+
+/**
+ * Read ntaps accumulator taps from first_tap on, one chunk per hold of the device mutex. Each ACC_MEM read starts
+ * with a dummy octet, the chunks go through a bounce buffer one octet longer so the taps land contiguously.
+ *
+ * @param inst       Pointer to dw1000_dev_instance_t.
+ * @param taps       Destination, ntaps * DW1000_CIR_TAP_LEN bytes.
+ * @param first_tap  Accumulator index of the first tap.
+ * @param ntaps      Taps to read.
+ * @return void
+ */
+static void
+cir_read_taps(dw1000_dev_instance_t * inst, uint8_t * taps, uint16_t first_tap, uint16_t ntaps){
+    uint8_t bounce[MYNEWT_VAL(DW1000_CIR_CHUNK_LEN) + 1];
+    uint16_t offset = first_tap * DW1000_CIR_TAP_LEN;
+    uint16_t len = ntaps * DW1000_CIR_TAP_LEN;
+
+    for (uint16_t i = 0; i < len; i += MYNEWT_VAL(DW1000_CIR_CHUNK_LEN)){
+        uint16_t n = (len - i < MYNEWT_VAL(DW1000_CIR_CHUNK_LEN)) ? len - i : MYNEWT_VAL(DW1000_CIR_CHUNK_LEN);
+        // Read modify write critical section enter, the ACC clocks share PMSC_CTRL0 with the other clock controls
+        os_error_t err = os_mutex_pend(&inst->mutex, OS_WAIT_FOREVER);
+        assert(err == OS_OK);
+        dw1000_phy_sysclk_ACC(inst, true);
+        dw1000_read(inst, ACC_MEM_ID, offset + i, bounce, n + 1);
+        dw1000_phy_sysclk_ACC(inst, false);
+        err = os_mutex_release(&inst->mutex);
+        assert(err == OS_OK);
+        memcpy(&taps[i], &bounce[1], n);
+    }
+}
+
+/**
+ * Export the filled buffers, oldest first, to the output callback.
+ *
+ * @param ev    Pointer to os_events.
+ * @return void
+ */
+static void
+cir_postprocess(struct os_event * ev){
+    assert(ev != NULL);
+    assert(ev->ev_arg != NULL);
+    dw1000_dev_instance_t * inst = (dw1000_dev_instance_t *)ev->ev_arg;
+    dw1000_cir_instance_t * cir = inst->cir;
+
+    while (cir->busy & (1 << cir->drain)){
+        dw1000_cir_buffer_t * buffer = &cir->buffers[cir->drain];
+        cir->output_cb(inst, (const uint8_t *) buffer, sizeof(dw1000_cir_record_t) + buffer->record.ntaps * DW1000_CIR_TAP_LEN);
+        cir->stats.captured++;
+        os_sr_t sr;
+        OS_ENTER_CRITICAL(sr);  // The busy bits are set from the interrupt task
+        cir->busy &= ~(1 << cir->drain);
+        OS_EXIT_CRITICAL(sr);
+        cir->drain ^= 1;
+    }
+}
+
+#endif /* DW1000_CIR */
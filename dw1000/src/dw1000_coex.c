@@ -0,0 +1,339 @@
+/*
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file dw1000_coex.c
+ * @date 2026
+ * @brief multi-PAN channel and preamble code coexistence
+ *
+ * @details The information element rides in the CCP beacon right after the blink. Retuning always runs as an event on
+ * the default queue: on the clock master it is posted from the CCP timer event, so it only runs once the blocking
+ * beacon transmit has completed; on the receiving side it is timed from the beacon that announced it to fall half a
+ * period before the first beacon on the new pair. The beacon loss timer only runs on the receiving side, it is first
+ * started by a received beacon.
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <os/os.h>
+#include <hal/hal_spi.h>
+#include <hal/hal_gpio.h>
+#include "bsp/bsp.h"
+
+#include <dw1000/dw1000_regs.h>
+#include <dw1000/dw1000_dev.h>
+#include <dw1000/dw1000_hal.h>
+#include <dw1000/dw1000_mac.h>
+#include <dw1000/dw1000_phy.h>
+
+#if MYNEWT_VAL(DW1000_COEX)
+#include <dw1000/dw1000_ccp.h>
+#include <dw1000/dw1000_coex.h>
+
+static void coex_retune_ev_cb(struct os_event * ev);
+static void coex_lost_ev_cb(struct os_event * ev);
+
+/**
+ * Allocate resources for channel and preamble code coexistence. The pair the device is configured with is taken as
+ * the one in effect.
+ *
+ * @param inst    Pointer to dw1000_dev_instance_t.
+ * @param config  Coexistence configuration.
+ * @return dw1000_coex_instance_t
+ */
+dw1000_coex_instance_t *
+dw1000_coex_init(dw1000_dev_instance_t * inst, dw1000_coex_config_t config){
+    assert(inst);
+
+    if (inst->coex == NULL ){
+        inst->coex = (dw1000_coex_instance_t *) malloc(sizeof(dw1000_coex_instance_t));
+        assert(inst->coex);
+        memset(inst->coex, 0, sizeof(dw1000_coex_instance_t));
+        inst->coex->status.selfmalloc = 1;
+    }
+    dw1000_coex_instance_t * coex = inst->coex;
+
+    coex->parent = inst;
+    coex->config = config;
+    coex->current.channel = inst->config.channel;
+    coex->current.preamble_code = inst->config.rx.preambleCodeIndex;
+    os_callout_init(&coex->coex_callout_retune, os_eventq_dflt_get(), coex_retune_ev_cb, (void *) inst);
+    os_callout_init(&coex->coex_callout_lost, os_eventq_dflt_get(), coex_lost_ev_cb, (void *) inst);
+    coex->status.initialized = 1;
+    return coex;
+}
+
+/**
+ * Free resources. A retune not yet applied is dropped.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @return void
+ */
+void
+dw1000_coex_free(dw1000_dev_instance_t * inst){
+    assert(inst != NULL);
+    assert(inst->coex != NULL);
+    os_callout_stop(&inst->coex->coex_callout_retune);
+    os_callout_stop(&inst->coex->coex_callout_lost);
+    if (inst->coex->status.selfmalloc){
+        free(inst->coex);
+        inst->coex = NULL;
+    }
+    else
+        inst->coex->status.initialized = 0;
+}
+
+/**
+ * Check a pair against the channel plan and the configured PRF.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @param ie    Pair to check.
+ * @return bool true if the device can use it
+ */
+static bool
+coex_valid(dw1000_dev_instance_t * inst, dw1000_coex_ie_t * ie){
+    const uint8_t * codes = dw1000_mac_preamble_codes(inst, ie->channel);
+    for (uint8_t i = 0; codes[i]; i++)
+        if (codes[i] == ie->preamble_code)
+            return true;
+    return false;
+}
+
+/**
+ * Plan the channel and preamble code pair of a PAN. Pairs are enumerated code index first and channel second over the
+ * channels in the mask, so consecutive PAN IDs are spread over the channels before any channel carries a second code.
+ * Channels 4 and 7 overlap 2, 3, 5 in band and are best left out of the mask when enough narrow channels are allowed.
+ *
+ * @param inst    Pointer to dw1000_dev_instance_t.
+ * @param pan_id  PAN ID.
+ * @param ie      Pair planned, epoch and countdown are left alone.
+ * @return bool false if no channel in the mask is usable
+ */
+bool
+dw1000_coex_plan(dw1000_dev_instance_t * inst, uint16_t pan_id, dw1000_coex_ie_t * ie){
+    assert(inst->coex);
+    uint8_t mask = inst->coex->config.channel_mask & DW1000_COEX_CHANNEL_MASK_ALL;
+
+    uint16_t n = 0;
+    for (uint8_t ch = 1; ch < 8; ch++)
+        if (mask & (1 << ch))
+            n += strlen((const char *) dw1000_mac_preamble_codes(inst, ch));
+    if (n == 0)
+        return false;
+
+    uint16_t k = pan_id % n;
+    for (uint8_t i = 0; ; i++)
+        for (uint8_t ch = 1; ch < 8; ch++){
+            if (!(mask & (1 << ch)) || dw1000_mac_preamble_codes(inst, ch)[i] == 0)
+                continue;
+            if (k-- == 0){
+                ie->channel = ch;
+                ie->preamble_code = dw1000_mac_preamble_codes(inst, ch)[i];
+                return true;
+            }
+        }
+}
+
+/**
+ * Announce a new pair from the clock master. It is carried in the next config.countdown beacons, DW1000_COEX_COUNTDOWN
+ * if not configured, and the master retunes after the last of them.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @param ie    Pair to assign.
+ * @return void
+ */
+void
+dw1000_coex_assign(dw1000_dev_instance_t * inst, dw1000_coex_ie_t ie){
+    dw1000_coex_instance_t * coex = inst->coex;
+    assert(coex);
+    assert(coex_valid(inst, &ie));
+
+    os_sr_t sr;
+    OS_ENTER_CRITICAL(sr);
+    ie.epoch = coex->current.epoch + 1;
+    ie.countdown = (coex->config.countdown) ? coex->config.countdown : MYNEWT_VAL(DW1000_COEX_COUNTDOWN);
+    coex->pending = ie;
+    coex->status.pending = 1;
+    OS_EXIT_CRITICAL(sr);
+}
+
+/**
+ * Retune now to a pair received outside the countdown, as in the PAN response. The receiver is left as it was
+ * unless the caller has set status.listen.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @param ie    Pair to apply.
+ * @return void
+ */
+void
+dw1000_coex_apply(dw1000_dev_instance_t * inst, dw1000_coex_ie_t ie){
+    dw1000_coex_instance_t * coex = inst->coex;
+    assert(coex);
+    if (!coex_valid(inst, &ie)){
+        coex->stats.ignored++;
+        return;
+    }
+    os_callout_stop(&coex->coex_callout_retune);
+    coex->pending = ie;
+    coex->status.pending = 1;
+    os_eventq_put(os_eventq_dflt_get(), &coex->coex_callout_retune.c_ev);
+}
+
+/**
+ * Write the information element into the TX buffer of the beacon being built, the announced pair while a countdown
+ * runs and the pair in effect otherwise. The beacon carrying the last count schedules the master's retune. Called from
+ * the CCP timer event, before the beacon transmit is started.
+ *
+ * @param inst    Pointer to dw1000_dev_instance_t.
+ * @param offset  TX buffer offset of the element.
+ * @return uint16_t length written
+ */
+uint16_t
+dw1000_coex_beacon_tx(dw1000_dev_instance_t * inst, uint16_t offset){
+    dw1000_coex_instance_t * coex = inst->coex;
+    dw1000_coex_ie_t ie = coex->current;
+
+    if (coex->status.pending && coex->pending.countdown){
+        ie = coex->pending;
+        if (--coex->pending.countdown == 0)
+            os_eventq_put(os_eventq_dflt_get(), &coex->coex_callout_retune.c_ev);
+    }
+    dw1000_write_tx(inst, (uint8_t *) &ie, offset, sizeof(dw1000_coex_ie_t));
+    return sizeof(dw1000_coex_ie_t);
+}
+
+/**
+ * Restart the beacon loss timer, config.misses beacon periods, DW1000_COEX_MISSES if not configured.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @return void
+ */
+static void
+coex_lost_reset(dw1000_dev_instance_t * inst){
+    dw1000_coex_instance_t * coex = inst->coex;
+    uint8_t misses = (coex->config.misses) ? coex->config.misses : MYNEWT_VAL(DW1000_COEX_MISSES);
+    os_callout_reset(&coex->coex_callout_lost, OS_TICKS_PER_SEC * ((uint64_t) misses * inst->ccp->period) * 1e-6);
+}
+
+/**
+ * Act on the information element of a received beacon. An announced pair is applied half a period after the beacon
+ * that should have been the last on the old pair, each beacon of the countdown retimes it; a pair already in effect on
+ * the master is applied at once, for nodes that missed the countdown. Every beacon restarts the beacon loss timer.
+ *
+ * @param inst    Pointer to dw1000_dev_instance_t.
+ * @param offset  RX buffer offset of the element.
+ * @return void
+ */
+void
+dw1000_coex_beacon_rx(dw1000_dev_instance_t * inst, uint16_t offset){
+    dw1000_coex_instance_t * coex = inst->coex;
+    dw1000_coex_ie_t ie;
+
+    dw1000_read_rx(inst, (uint8_t *) &ie, offset, sizeof(dw1000_coex_ie_t));
+    coex->stats.beacons++;
+    coex->search = 0;
+    coex_lost_reset(inst);
+    if (!coex_valid(inst, &ie)){
+        coex->stats.ignored++;
+        return;
+    }
+    if (ie.countdown == 0){
+        if (ie.epoch != coex->current.epoch || ie.channel != inst->config.channel
+            || ie.preamble_code != inst->config.rx.preambleCodeIndex){
+            coex->status.listen = 1;
+            dw1000_coex_apply(inst, ie);
+        }
+        return;
+    }
+    coex->pending = ie;
+    coex->status.pending = 1;
+    coex->status.listen = 1;
+    os_callout_reset(&coex->coex_callout_retune,
+        OS_TICKS_PER_SEC * ((ie.countdown - 1) * inst->ccp->period + inst->ccp->period / 2) * 1e-6);
+}
+
+/**
+ * Retune to the pending pair. Setting the channel waits on the device semaphore, so a transmit in flight completes on
+ * the old pair.
+ *
+ * @param ev  Pointer to os_events.
+ * @return void
+ */
+static void
+coex_retune_ev_cb(struct os_event * ev){
+    assert(ev != NULL);
+    assert(ev->ev_arg != NULL);
+    dw1000_dev_instance_t * inst = (dw1000_dev_instance_t *)ev->ev_arg;
+    dw1000_coex_instance_t * coex = inst->coex;
+
+    os_sr_t sr;
+    OS_ENTER_CRITICAL(sr);  // The pending pair is written from the interrupt task
+    dw1000_coex_ie_t ie = coex->pending;
+    bool pending = coex->status.pending;
+    bool listen = coex->status.listen;
+    coex->status.pending = 0;
+    coex->status.listen = 0;
+    OS_EXIT_CRITICAL(sr);
+    if (!pending)
+        return;
+
+    if (ie.channel != inst->config.channel || ie.preamble_code != inst->config.rx.preambleCodeIndex){
+        dw1000_mac_set_channel(inst, ie.channel, ie.preamble_code);
+        coex->stats.retunes++;
+    }
+    ie.countdown = 0;
+    coex->current = ie;
+    if (listen)
+        dw1000_restart_rx(inst, inst->control_rx_context);
+}
+
+/**
+ * No beacon for config.misses periods, the countdown of a new pair was missed altogether. Each expiry moves to the
+ * next pair of the plan, the first being the one planned for the PAN ID, and listens there for another config.misses
+ * periods. A retune still pending from a countdown is left to run.
+ *
+ * @param ev  Pointer to os_events.
+ * @return void
+ */
+static void
+coex_lost_ev_cb(struct os_event * ev){
+    assert(ev != NULL);
+    assert(ev->ev_arg != NULL);
+    dw1000_dev_instance_t * inst = (dw1000_dev_instance_t *)ev->ev_arg;
+    dw1000_coex_instance_t * coex = inst->coex;
+
+    coex_lost_reset(inst);
+    if (coex->status.pending)
+        return;
+
+    dw1000_coex_ie_t ie = coex->current;
+    if (!dw1000_coex_plan(inst, inst->PANID + coex->search++, &ie))
+        return;
+    if (ie.channel == inst->config.channel && ie.preamble_code == inst->config.rx.preambleCodeIndex)
+        return;
+    coex->stats.searches++;
+    coex->status.listen = 1;
+    dw1000_coex_apply(inst, ie);
+}
+
+#endif /* DW1000_COEX */
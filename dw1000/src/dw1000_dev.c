@@ -39,6 +39,7 @@
 #include <dw1000/dw1000_regs.h>
 #include <dw1000/dw1000_hal.h>
 #include <dw1000/dw1000_phy.h>
+#include <dw1000/dw1000_mac.h>
 
 
 static int dw1000_find_extension_callbacks_position(dw1000_dev_instance_t *inst, dw1000_extension_id_t id);
@@ -414,6 +415,137 @@ dw1000_dev_enter_sleep_after_tx(dw1000_dev_instance_t * inst, int enable)
     dw1000_write(inst, PMSC_ID, PMSC_CTRL1_OFFSET, (uint8_t*)&reg, sizeof(uint32_t));
 }
 
+/**
+ * Measure the period of the low power oscillator that clocks the sleep counter, in cycles of the XTAL/2 19.2MHz
+ * clock. The LP oscillator runs anywhere from 7 to 13 kHz and drifts with temperature, so it is worth calibrating
+ * again from time to time on a device that sleeps for long periods. The result is kept in inst->lposc_cal.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @return uint16_t XTAL/2 cycles per LP oscillator cycle
+ */
+uint16_t
+dw1000_dev_calibrate_sleep_counter(dw1000_dev_instance_t * inst)
+{
+    os_error_t err = os_mutex_pend(&inst->mutex, OS_WAIT_FOREVER);
+    assert(err == OS_OK);
+
+    // Enable the calibration function, then clear it again
+    dw1000_write_reg(inst, AON_ID, AON_CFG1_OFFSET, AON_CFG1_LPOSC_CAL, sizeof(uint16_t));
+    dw1000_write_reg(inst, AON_ID, AON_CTRL_OFFSET, AON_CTRL_UPL_CFG, sizeof(uint8_t));
+    dw1000_write_reg(inst, AON_ID, AON_CTRL_OFFSET, 0x0, sizeof(uint8_t));
+    dw1000_write_reg(inst, AON_ID, AON_CFG1_OFFSET, 0x0, sizeof(uint16_t));
+    dw1000_write_reg(inst, AON_ID, AON_CTRL_OFFSET, AON_CTRL_UPL_CFG, sizeof(uint8_t));
+    dw1000_write_reg(inst, AON_ID, AON_CTRL_OFFSET, 0x0, sizeof(uint8_t));
+
+    // Read the result through direct AON memory access, the measurement takes about 1ms
+    dw1000_write_reg(inst, AON_ID, AON_CTRL_OFFSET, AON_CTRL_DCA_ENAB, sizeof(uint8_t));
+    os_cputime_delay_usecs(1000);
+    dw1000_write_reg(inst, AON_ID, AON_ADDR_OFFSET, AON_ADDR_LPOSC_CAL_1, sizeof(uint8_t));
+    dw1000_write_reg(inst, AON_ID, AON_CTRL_OFFSET, AON_CTRL_DCA_ENAB | AON_CTRL_DCA_READ, sizeof(uint8_t));
+    uint16_t cal = (uint16_t) dw1000_read_reg(inst, AON_ID, AON_RDAT_OFFSET, sizeof(uint8_t)) << 8;
+    dw1000_write_reg(inst, AON_ID, AON_CTRL_OFFSET, AON_CTRL_DCA_ENAB, sizeof(uint8_t));
+    dw1000_write_reg(inst, AON_ID, AON_ADDR_OFFSET, AON_ADDR_LPOSC_CAL_0, sizeof(uint8_t));
+    dw1000_write_reg(inst, AON_ID, AON_CTRL_OFFSET, AON_CTRL_DCA_ENAB | AON_CTRL_DCA_READ, sizeof(uint8_t));
+    cal |= (uint16_t) dw1000_read_reg(inst, AON_ID, AON_RDAT_OFFSET, sizeof(uint8_t));
+    dw1000_write_reg(inst, AON_ID, AON_CTRL_OFFSET, 0x0, sizeof(uint8_t));
+
+    inst->lposc_cal = cal;
+
+    err = os_mutex_release(&inst->mutex);
+    assert(err == OS_OK);
+    return cal;
+}
+
+/**
+ * Load the sleep counter. The device wakes count * 4096 LP oscillator cycles after entering sleep when configured with
+ * DWT_WAKE_SLPCNT. The AON block has to be written with the system clock on the XTAL, so the clocks are forced and
+ * handed back to the sequencer around the update.
+ *
+ * @param inst   Pointer to dw1000_dev_instance_t.
+ * @param count  Sleep time in units of 4096 LP oscillator cycles.
+ * @return void
+ */
+void
+dw1000_dev_configure_sleep_counter(dw1000_dev_instance_t * inst, uint16_t count)
+{
+    os_error_t err = os_mutex_pend(&inst->mutex, OS_WAIT_FOREVER);
+    assert(err == OS_OK);
+
+    dw1000_phy_sysclk_XTAL(inst);
+
+    // Disable the sleep counter while it is loaded
+    dw1000_write_reg(inst, AON_ID, AON_CFG1_OFFSET, 0x0, sizeof(uint16_t));
+    dw1000_write_reg(inst, AON_ID, AON_CFG0_OFFSET, 0x0, sizeof(uint16_t));
+    dw1000_write_reg(inst, AON_ID, AON_CTRL_OFFSET, AON_CTRL_UPL_CFG, sizeof(uint8_t));
+    dw1000_write_reg(inst, AON_ID, AON_CTRL_OFFSET, 0x0, sizeof(uint8_t));
+
+    dw1000_write_reg(inst, AON_ID, AON_CFG0_OFFSET + AON_CFG0_SLEEP_TIM_OFFSET, count, sizeof(uint16_t));
+    dw1000_write_reg(inst, AON_ID, AON_CTRL_OFFSET, AON_CTRL_UPL_CFG, sizeof(uint8_t));
+    dw1000_write_reg(inst, AON_ID, AON_CTRL_OFFSET, 0x0, sizeof(uint8_t));
+
+    dw1000_write_reg(inst, AON_ID, AON_CFG1_OFFSET, AON_CFG1_SLEEP_CEN, sizeof(uint16_t));
+    dw1000_write_reg(inst, AON_ID, AON_CTRL_OFFSET, AON_CTRL_UPL_CFG, sizeof(uint8_t));
+    dw1000_write_reg(inst, AON_ID, AON_CTRL_OFFSET, 0x0, sizeof(uint8_t));
+
+    dw1000_phy_sysclk_SEQ(inst);
+
+    err = os_mutex_release(&inst->mutex);
+    assert(err == OS_OK);
+}
+
+/**
+ * Sleep on the sleep counter and wake on its own ahead of a point in the current timebase, the next CCP blink or a
+ * TDMA slot, so the host needs neither a timer nor the WAKEUP pin to bring the device back. The wakeup latency,
+ * DW1000_WAKEUP_LATENCY, and the guard are taken off the time left and the remainder is rounded down to whole sleep
+ * counter units, so the device is always back in IDLE at least guard usec before dx_time. One unit is 4096 LP
+ * oscillator cycles, in the order of half a second, so short waits are better spent awake: nothing is done and 0 is
+ * returned when the time left does not cover a unit. The system time restarts from zero on wake up; the return value
+ * lets the caller place dx_time in the new timebase. The sleep mode is the one last set with
+ * dw1000_dev_configure_sleep(), the WAKEUP pin is left enabled so dw1000_dev_wakeup() can still cut the sleep short,
+ * and SYS_MASK_MSLP2INIT in the interrupt mask raises the IRQ line when the device is back up. status.sleeping stays
+ * set until dw1000_dev_wakeup(), which finds the device awake and only restores the antenna delays, as TDMA slot 0
+ * already does. The call waits for a transmit in flight to complete, the transceiver is then turned off. Requires
+ * dw1000_dev_calibrate_sleep_counter().
+ *
+ * @param inst     Pointer to dw1000_dev_instance_t.
+ * @param dx_time  Point to be awake for, in dwt units of the system time.
+ * @param guard    Time to be awake before dx_time, in usec.
+ * @return uint32_t time asleep in usec, 0 if the device was not put to sleep
+ */
+uint32_t
+dw1000_dev_enter_sleep_until(dw1000_dev_instance_t * inst, uint64_t dx_time, uint32_t guard)
+{
+    assert(inst->lposc_cal);
+
+    // The time left is taken once the device is ours, a transmit in flight would otherwise eat into the guard
+    os_error_t err = os_sem_pend(&inst->sem,  OS_TIMEOUT_NEVER); // Block if request pending
+    assert(err == OS_OK);
+
+    uint32_t slept = 0;
+    uint64_t systime = dw1000_read_reg(inst, SYS_TIME_ID, SYS_TIME_OFFSET, SYS_TIME_LEN) & 0x0FFFFFFFFFFUL;
+    uint64_t usecs = (((dx_time - systime) & 0x0FFFFFFFFFFUL) * 10) / 638976;   // dwt units to usec
+    if (usecs > (uint64_t) MYNEWT_VAL(DW1000_WAKEUP_LATENCY) + guard){
+        usecs -= MYNEWT_VAL(DW1000_WAKEUP_LATENCY) + guard;
+
+        // 19.2 XTAL/2 cycles per usec, 4096 LP oscillator cycles per count
+        uint64_t count = (usecs * 192) / ((uint64_t) inst->lposc_cal * 10 * 4096);
+        if (count > UINT16_MAX)
+            count = UINT16_MAX;
+        if (count){
+            dw1000_phy_forcetrxoff(inst);
+            dw1000_dev_configure_sleep_counter(inst, (uint16_t) count);
+            dw1000_dev_configure_sleep(inst, inst->sleep_mode, DWT_WAKE_SLPCNT | DWT_WAKE_WK | DWT_SLP_EN);
+            dw1000_dev_enter_sleep(inst);
+            slept = (uint32_t)((count * inst->lposc_cal * 10 * 4096) / 192);
+        }
+    }
+
+    err = os_sem_release(&inst->sem);
+    assert(err == OS_OK);
+
+    return slept;
+}
+
 /**
  * Assigns callbacks for different services into a linked list.
  *
@@ -0,0 +1,260 @@
+/*
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file dw1000_drift.c
+ * @date 2026
+ * @brief temperature and voltage drift compensation
+ *
+ * @details This is the drift compensation service. Sampling only ever takes the device semaphore without waiting; when
+ * a transmit or a ranging exchange holds it the sample is retried shortly after, so traffic is never held off. A
+ * listening receiver is left running, the sensor conversion does not involve the RF chain. The antenna delays are
+ * written together with the copies in the device instance that the ranging services use to predict TX timestamps.
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <os/os.h>
+#include <hal/hal_spi.h>
+#include <hal/hal_gpio.h>
+#include "bsp/bsp.h"
+
+#include <dw1000/dw1000_regs.h>
+#include <dw1000/dw1000_dev.h>
+#include <dw1000/dw1000_hal.h>
+#include <dw1000/dw1000_mac.h>
+#include <dw1000/dw1000_phy.h>
+#if MYNEWT_VAL(DW1000_REGULATORY)
+#include <dw1000/dw1000_regulatory.h>
+#endif
+
+#if MYNEWT_VAL(DW1000_DRIFT)
+#include <dw1000/dw1000_drift.h>
+
+#define DW1000_DRIFT_TEMP_LSB_Q8    (292)   //!< 1.14 degrees C per temperature reading LSB, in Q8
+#define DW1000_DRIFT_TXPWR_STEP     (500)   //!< TX power fine gain step, milli dB
+#define DW1000_DRIFT_FINE_MASK      (0x1F)  //!< Fine gain field of each TX power byte
+
+static void drift_timer_ev_cb(struct os_event * ev);
+static void drift_apply(dw1000_dev_instance_t * inst);
+
+/**
+ * Allocate resources for drift compensation.
+ *
+ * @param inst    Pointer to dw1000_dev_instance_t.
+ * @param config  Drift compensation coefficients.
+ * @return dw1000_drift_instance_t
+ */
+dw1000_drift_instance_t *
+dw1000_drift_init(dw1000_dev_instance_t * inst, dw1000_drift_config_t config){
+    assert(inst);
+    assert(config.period);
+
+    if (inst->drift == NULL ){
+        inst->drift = (dw1000_drift_instance_t *) malloc(sizeof(dw1000_drift_instance_t));
+        assert(inst->drift);
+        memset(inst->drift, 0, sizeof(dw1000_drift_instance_t));
+        inst->drift->status.selfmalloc = 1;
+    }
+    dw1000_drift_instance_t * drift = inst->drift;
+
+    drift->parent = inst;
+    drift->config = config;
+    os_callout_init(&drift->drift_callout_timer, os_eventq_dflt_get(), drift_timer_ev_cb, (void *) inst);
+    drift->status.initialized = 1;
+    return drift;
+}
+
+/**
+ * Free resources, stopping compensation first.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @return void
+ */
+void
+dw1000_drift_free(dw1000_dev_instance_t * inst){
+    assert(inst != NULL);
+    assert(inst->drift != NULL);
+    if (inst->drift->status.started)
+        dw1000_drift_stop(inst);
+    if (inst->drift->status.selfmalloc){
+        free(inst->drift);
+        inst->drift = NULL;
+    }
+    else
+        inst->drift->status.initialized = 0;
+}
+
+/**
+ * Take the current temperature, antenna delays and TX power as the calibration reference and start sampling. Call
+ * once the device is configured and has reached the temperature it was calibrated at.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @return void
+ */
+void
+dw1000_drift_start(dw1000_dev_instance_t * inst){
+    assert(inst->drift);
+    dw1000_drift_instance_t * drift = inst->drift;
+
+    os_error_t err = os_sem_pend(&inst->sem, OS_TIMEOUT_NEVER);
+    assert(err == OS_OK);
+
+    uint16_t tempvbat = dw1000_phy_read_tempvbat(inst);
+    drift->ref_temp = drift->temp = tempvbat >> 8;
+    drift->vbat = tempvbat & 0xFF;
+    drift->ref_rx_antenna_delay = inst->rx_antenna_delay;
+    drift->ref_tx_antenna_delay = inst->tx_antenna_delay;
+    drift->ref_power = drift->power = (uint32_t) dw1000_read_reg(inst, TX_POWER_ID, 0, sizeof(uint32_t));
+    drift->stats.samples++;
+
+    err = os_sem_release(&inst->sem);
+    assert(err == OS_OK);
+
+    drift->status.started = 1;
+    os_callout_reset(&drift->drift_callout_timer, OS_TICKS_PER_SEC * drift->config.period * 1e-6);
+}
+
+/**
+ * Stop sampling. The corrections last applied stay in place.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @return void
+ */
+void
+dw1000_drift_stop(dw1000_dev_instance_t * inst){
+    assert(inst->drift);
+    os_callout_stop(&inst->drift->drift_callout_timer);
+    inst->drift->status.started = 0;
+}
+
+/**
+ * Latest temperature reading in degrees C.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @return int16_t  Temperature in degrees C * 256.
+ */
+int16_t
+dw1000_drift_temp_q8(dw1000_dev_instance_t * inst){
+    return (inst->drift->temp - inst->otp_temp) * DW1000_DRIFT_TEMP_LSB_Q8 + (23 << 8);
+}
+
+/**
+ * Latest voltage reading in millivolts.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @return uint16_t  Voltage in mV.
+ */
+uint16_t
+dw1000_drift_vbat_mv(dw1000_dev_instance_t * inst){
+    return (int32_t)(inst->drift->vbat - inst->otp_vbat) * 1000 / 173 + 3300;
+}
+
+/**
+ * Sample the sensors and correct, unless the device is busy in which case the sample is retried in 10 ms.
+ *
+ * @param ev  Pointer to os_events.
+ * @return void
+ */
+static void
+drift_timer_ev_cb(struct os_event * ev){
+    assert(ev != NULL);
+    assert(ev->ev_arg != NULL);
+    dw1000_dev_instance_t * inst = (dw1000_dev_instance_t *)ev->ev_arg;
+    dw1000_drift_instance_t * drift = inst->drift;
+
+    if (os_sem_pend(&inst->sem, 0) != OS_OK){
+        drift->stats.deferred++;
+        os_callout_reset(&drift->drift_callout_timer, OS_TICKS_PER_SEC/100);
+        return;
+    }
+
+    uint16_t tempvbat = dw1000_phy_read_tempvbat(inst);
+    drift->temp = tempvbat >> 8;
+    drift->vbat = tempvbat & 0xFF;
+    drift->stats.samples++;
+    drift_apply(inst);
+
+    os_error_t err = os_sem_release(&inst->sem);
+    assert(err == OS_OK);
+    os_callout_reset(&drift->drift_callout_timer, OS_TICKS_PER_SEC * drift->config.period * 1e-6);
+}
+
+/**
+ * Rounded signed division.
+ *
+ * @param num  Numerator.
+ * @param den  Denominator, positive.
+ * @return int32_t
+ */
+static int32_t
+drift_div_round(int64_t num, int32_t den){
+    return (num >= 0) ? (num + den / 2) / den : -((-num + den / 2) / den);
+}
+
+/**
+ * Write the corrections for the latest temperature reading, only registers whose value changes are written. Each
+ * TX power byte has its fine gain moved by the same number of steps, saturating at the ends of the fine range; with the
+ * regulatory engine running, the step is left for it to apply to each frame. Called with inst->sem held.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @return void
+ */
+static void
+drift_apply(dw1000_dev_instance_t * inst){
+    dw1000_drift_instance_t * drift = inst->drift;
+    int32_t dt_q8 = (drift->temp - drift->ref_temp) * DW1000_DRIFT_TEMP_LSB_Q8;
+
+    int32_t delay = drift_div_round((int64_t) dt_q8 * drift->config.antdly_per_c, 1 << 16);
+    uint16_t rx_antenna_delay = drift->ref_rx_antenna_delay + delay;
+    uint16_t tx_antenna_delay = drift->ref_tx_antenna_delay + delay;
+    if (rx_antenna_delay != inst->rx_antenna_delay || tx_antenna_delay != inst->tx_antenna_delay){
+        inst->rx_antenna_delay = rx_antenna_delay;
+        inst->tx_antenna_delay = tx_antenna_delay;
+        dw1000_phy_set_rx_antennadelay(inst, rx_antenna_delay);
+        dw1000_phy_set_tx_antennadelay(inst, tx_antenna_delay);
+        drift->stats.updates++;
+    }
+
+    int32_t steps = drift_div_round((int64_t) dt_q8 * drift->config.txpwr_per_c, DW1000_DRIFT_TXPWR_STEP << 8);
+    drift->txpwr_step = (steps < -DW1000_DRIFT_FINE_MASK) ? -DW1000_DRIFT_FINE_MASK : (steps > DW1000_DRIFT_FINE_MASK) ? DW1000_DRIFT_FINE_MASK : steps;
+#if MYNEWT_VAL(DW1000_REGULATORY)
+    // The regulatory engine sets the power of every frame, the correction is added to its step
+    if (inst->regulatory != NULL)
+        return;
+#endif
+    uint32_t power = 0;
+    for (uint8_t i = 0; i < sizeof(uint32_t); i++){
+        uint8_t level = (drift->ref_power >> (8 * i)) & 0xFF;
+        int32_t fine = (level & DW1000_DRIFT_FINE_MASK) + steps;
+        fine = (fine < 0) ? 0 : (fine > DW1000_DRIFT_FINE_MASK) ? DW1000_DRIFT_FINE_MASK : fine;
+        power |= (uint32_t)((level & ~DW1000_DRIFT_FINE_MASK) | fine) << (8 * i);
+    }
+    if (power != drift->power){
+        drift->power = power;
+        dw1000_write_reg(inst, TX_POWER_ID, 0, power, sizeof(uint32_t));
+        drift->stats.updates++;
+    }
+}
+
+#endif /* DW1000_DRIFT */
@@ -0,0 +1,143 @@
+/*
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file dw1000_dsp.c
+ * @date 2026
+ * @brief fixed point signal processing
+ *
+ * @details Integer filter, polynomial and logarithm kernels. Nothing here touches the device, the functions are
+ * reentrant apart from the filter state they are handed.
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+#include <dw1000/dw1000_dsp.h>
+
+/**
+ * Allocate and clear the state of a cascade of second order sections.
+ *
+ * @param inst       Pointer to dw1000_sos_q31_instance_t, NULL to allocate one.
+ * @param nsections  Number of sections.
+ * @return dw1000_sos_q31_instance_t
+ */
+dw1000_sos_q31_instance_t *
+dw1000_sosfilt_q31_init(dw1000_sos_q31_instance_t * inst, uint16_t nsections){
+    assert(nsections);
+
+    if (inst == NULL){
+        inst = (dw1000_sos_q31_instance_t *) malloc(sizeof(dw1000_sos_q31_instance_t) + nsections * 4 * sizeof(int32_t));
+        assert(inst);
+        memset(inst, 0, sizeof(dw1000_sos_q31_instance_t) + nsections * 4 * sizeof(int32_t));
+        inst->selfmalloc = 1;
+    }else
+        memset(inst->state, 0, nsections * 4 * sizeof(int32_t));
+    inst->nsections = nsections;
+    inst->clk = 0;
+    inst->output = 0;
+    return inst;
+}
+
+/**
+ * Free the filter state.
+ *
+ * @param inst  Pointer to dw1000_sos_q31_instance_t.
+ * @return void
+ */
+void
+dw1000_sosfilt_q31_free(dw1000_sos_q31_instance_t * inst){
+    assert(inst);
+    if (inst->selfmalloc)
+        free(inst);
+}
+
+/**
+ * Filter one sample through the cascade, direct form I. Each section has b0, b1, b2 in b and a0, a1, a2 in a, Q30,
+ * a0 being 1 and not used. The sample and the output share the caller's fixed point format; products are accumulated
+ * in 64 bits and rounded once per section, the feedback state keeps that rounding only.
+ *
+ * @param inst  Pointer to dw1000_sos_q31_instance_t.
+ * @param x     Input sample.
+ * @param b     Numerator coefficients, DW1000_BIQUAD_N per section.
+ * @param a     Denominator coefficients, DW1000_BIQUAD_N per section.
+ * @return int32_t output sample
+ */
+int32_t
+dw1000_sosfilt_q31(dw1000_sos_q31_instance_t * inst, int32_t x, const int32_t * b, const int32_t * a){
+    int32_t * s = inst->state;
+
+    for (uint16_t i = 0; i < inst->nsections; i++, s += 4, b += DW1000_BIQUAD_N, a += DW1000_BIQUAD_N){
+        int64_t acc = (int64_t) b[0] * x + (int64_t) b[1] * s[0] + (int64_t) b[2] * s[1]
+                    - (int64_t) a[1] * s[2] - (int64_t) a[2] * s[3];
+        int32_t y = (int32_t)((acc + (1 << 29)) >> 30);
+        s[1] = s[0];
+        s[0] = x;
+        s[3] = s[2];
+        s[2] = y;
+        x = y;
+    }
+    inst->clk++;
+    inst->output = x;
+    return x;
+}
+
+/**
+ * Evaluate a polynomial by Horner's rule. The argument is Q15 in [-1, 1), so the result keeps the fixed point format
+ * of the coefficients and cannot exceed the sum of their magnitudes.
+ *
+ * @param p  Coefficients, highest power first.
+ * @param u  Argument, Q15.
+ * @param n  Number of coefficients.
+ * @return int32_t p(u) in the format of p
+ */
+int32_t
+dw1000_polyval_q15(const int32_t * p, int16_t u, uint16_t n){
+    assert(n);
+    int32_t acc = p[0];
+    for (uint16_t i = 1; i < n; i++)
+        acc = (int32_t)(((int64_t) acc * u + (1 << 14)) >> 15) + p[i];
+    return acc;
+}
+
+//! log2(1 + i/32) in Q8
+static const uint16_t dsp_log2_q8_lut[33] = {
+    0, 11, 22, 33, 44, 54, 63, 73, 82, 92, 100, 109, 118, 126, 134, 142, 150,
+    157, 165, 172, 179, 186, 193, 200, 207, 213, 220, 226, 232, 238, 244, 250, 256
+};
+
+/**
+ * Base 2 logarithm in Q8 without libm. The integer part is the position of the leading one, the fraction is looked up
+ * from the next 5 bits and linearly interpolated on the 8 bits after them, within 0.005 of the exact value.
+ *
+ * @param x  Argument, not 0.
+ * @return int32_t log2(x) in Q8
+ */
+int32_t
+dw1000_log2_q8(uint64_t x){
+    uint32_t msb = 63 - __builtin_clzll(x);
+    uint32_t frac = ((msb >= 13) ? (uint32_t)(x >> (msb - 13)) : (uint32_t)(x << (13 - msb))) & 0x1FFF;
+    uint32_t idx = frac >> 8;
+    uint32_t w = frac & 0xFF;
+    return (msb << 8) + dsp_log2_q8_lut[idx] + (((dsp_log2_q8_lut[idx + 1] - dsp_log2_q8_lut[idx]) * w + 128) >> 8);
+}
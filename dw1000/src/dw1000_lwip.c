@@ -223,7 +223,7 @@ rx_complete_cb(dw1000_dev_instance_t * inst){
 	uint16_t buf_idx = (inst->lwip->buf_idx++) % inst->lwip->nframes;
 	char *data_buf = inst->lwip->data_buf[ buf_idx];
 
-	dw1000_read_rx(inst, (uint8_t *) data_buf, 0, inst->lwip->buf_len);
+	dw1000_read_rx_frame(inst, (uint8_t *) data_buf, inst->lwip->buf_len);
 	inst->lwip->netif->input((struct pbuf *)data_buf, inst->lwip->netif);
 	os_error_t err = os_sem_release(&inst->lwip->data_sem);
 	assert(err == OS_OK);
@@ -42,15 +42,33 @@
 #include <dw1000/dw1000_hal.h>
 #include <dw1000/dw1000_phy.h>
 #include <dw1000/dw1000_mac.h>
+#include <dw1000/dw1000_ftypes.h>
+#include <dw1000/dw1000_dsp.h>
 
 #if MYNEWT_VAL(CLOCK_CALIBRATION_ENABLED)
 #include <dw1000/dw1000_ccp.h>
 #endif
+#if MYNEWT_VAL(DW1000_CIR)
+#include <dw1000/dw1000_cir.h>
+#endif
+#if MYNEWT_VAL(DW1000_REGULATORY)
+#include <dw1000/dw1000_regulatory.h>
+#endif
 
 
 static void dw1000_interrupt_task(void *arg);
 static void dw1000_interrupt_ev_cb(struct os_event *ev);
 static void dw1000_irq(void *arg);
+static void _dw1000_write_wait4resp_delay(struct _dw1000_dev_instance_t * inst, uint32_t delay);
+static struct _dw1000_dev_status_t _dw1000_start_tx(struct _dw1000_dev_instance_t * inst);
+static uint16_t _dw1000_rx_timeout_sniff(struct _dw1000_dev_instance_t * inst, uint16_t timeout);
+static void _dw1000_rx_recover(struct _dw1000_dev_instance_t * inst);
+static void _dw1000_rx_rearm(struct _dw1000_dev_instance_t * inst);
+static bool _dw1000_rx_seq_duplicate(struct _dw1000_dev_instance_t * inst);
+static bool _dw1000_fctrl_pending(struct _dw1000_dev_instance_t * inst);
+static void _dw1000_mac_framefilter(struct _dw1000_dev_instance_t * inst, uint16_t enable);
+static void _dw1000_rx_pretoc_disarm(struct _dw1000_dev_instance_t * inst);
+static uint64_t _dw1000_sniff_pacs(struct _dw1000_dev_instance_t * inst, uint16_t npacs);
 
 #define NUM_BR 3
 #define NUM_PRF 2
@@ -95,6 +113,39 @@ const uint8_t fs_pll_tune[] =
     FS_PLLTUNE_CH7
 };
 
+//! Recommended preamble codes of each channel at 16 MHz and 64 MHz PRF, 0 terminated
+const uint8_t preamble_codes[8][2][5] =
+{
+    [1] = {{1, 2, 0}, {9, 10, 11, 12, 0}},
+    [2] = {{3, 4, 0}, {9, 10, 11, 12, 0}},
+    [3] = {{5, 6, 0}, {9, 10, 11, 12, 0}},
+    [4] = {{7, 8, 0}, {17, 18, 19, 20, 0}},
+    [5] = {{3, 4, 0}, {9, 10, 11, 12, 0}},
+    [7] = {{7, 8, 0}, {17, 18, 19, 20, 0}}
+};
+
+//! Transmitter calibration - pulse generator delay
+const uint8_t tc_pgdelay[] =
+{
+    TC_PGDELAY_CH1,
+    TC_PGDELAY_CH2,
+    TC_PGDELAY_CH3,
+    TC_PGDELAY_CH4,
+    TC_PGDELAY_CH5,
+    TC_PGDELAY_CH7
+};
+
+//! Reference TX power of each channel at 16 MHz and 64 MHz PRF, smart TX power enabled
+const uint32_t tx_power[][2] =
+{
+    {0x15355575, 0x07274767},
+    {0x15355575, 0x07274767},
+    {0x0F2F4F6F, 0x2B4B6B8B},
+    {0x1F1F3F5F, 0x3A5A7A9A},
+    {0x0E082848, 0x25456585},
+    {0x32527292, 0x5171B1D1}
+};
+
 //! bandwidth configuration
 const uint8_t rx_config[] =
 {
@@ -334,6 +385,8 @@ struct _dw1000_dev_status_t dw1000_mac_init(struct _dw1000_dev_instance_t * inst
         dw1000_mac_framefilter(inst, DWT_FF_BEACON_EN | DWT_FF_DATA_EN );
     }
 #endif
+    if (inst->config.sniff_enable)
+        dw1000_set_sniff_mode(inst, true, config->rx.sniffOnTime, config->rx.sniffOffTime);
     
     return inst->status;
 } 
@@ -368,6 +421,7 @@ struct _dw1000_dev_status_t dw1000_write_tx(struct _dw1000_dev_instance_t * inst
         dw1000_write(inst, TX_BUFFER_ID, txBufferOffset,  txFrameBytes, txFrameLength);
         for (uint8_t i = 0; i< sizeof(inst->fctrl); i++)
             inst->fctrl_array[i] =  txFrameBytes[i];
+        _dw1000_fctrl_pending(inst);
         inst->status.tx_frame_error = 0;
     }
     else
@@ -404,6 +458,7 @@ inline void dw1000_write_tx_fctrl(struct _dw1000_dev_instance_t * inst, uint16_t
     // Write the frame length to the TX frame control register
     uint32_t tx_fctrl_reg = inst->tx_fctrl | (txFrameLength + 2)  | (txBufferOffset << TX_FCTRL_TXBOFFS_SHFT) | ((ranging)?(TX_FCTRL_TR):0);
     inst->status.tx_ranging_frame = ranging;
+    inst->tx_frame_len = txFrameLength;
     dw1000_write_reg(inst, TX_FCTRL_ID, 0, tx_fctrl_reg, sizeof(uint32_t));
  
     err = os_sem_release(&inst->sem); 
@@ -422,8 +477,98 @@ struct _dw1000_dev_status_t dw1000_start_tx(struct _dw1000_dev_instance_t * inst
     os_error_t err = os_sem_pend(&inst->sem,  OS_TIMEOUT_NEVER); // Released by a SYS_STATUS_TXFRS event
     assert(err == OS_OK);
 
+    return _dw1000_start_tx(inst);
+}
+
+/**
+ * Commit a complete radio action in one pass. The frame, frame control, delayed transmit time, wait4resp turn-around, 
+ * frame wait and preamble timeouts are written in order under a single acquisition of inst->sem and inst->mutex, 
+ * followed by the transmit command. This replaces the sequence dw1000_write_tx, dw1000_write_tx_fctrl, 
+ * dw1000_set_delay_start, dw1000_set_wait4resp, dw1000_set_rx_timeout, dw1000_set_preamble_timeout and 
+ * dw1000_start_tx on turnaround critical paths, and skips the SYS_CFG write when RXWTOE is already as required.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @param cmd   Pointer to the command descriptor.
+ * @return dw1000_dev_status_t
+ */
+struct _dw1000_dev_status_t dw1000_start_tx_cmd(struct _dw1000_dev_instance_t * inst, const dw1000_mac_cmd_t * cmd)
+{
+    os_error_t err = os_sem_pend(&inst->sem,  OS_TIMEOUT_NEVER); // Released by a SYS_STATUS_TXFRS event
+    assert(err == OS_OK);
+
+    // Standard PHR carries frames up to 127 bytes including the CRC, the proprietary extended PHR up to 1023
+    inst->status.tx_frame_error = (cmd->frame_len + 2) > ((inst->config.rx.phrMode == DWT_PHRMODE_EXT) ? 1023 : 127);
+    if (inst->status.tx_frame_error){
+        inst->status.start_tx_error = 1;
+        err = os_sem_release(&inst->sem); 
+        assert(err == OS_OK); 
+        return inst->status;
+    }
+
+    err = os_mutex_pend(&inst->mutex, OS_WAIT_FOREVER); // Read modify write critical section enter 
+    assert(err == OS_OK);
+
+    if (cmd->payload){
+        dw1000_write(inst, TX_BUFFER_ID, 0, (uint8_t *) cmd->payload, cmd->frame_len);
+        memcpy(inst->fctrl_array, cmd->payload, sizeof(inst->fctrl));
+        _dw1000_fctrl_pending(inst);
+    }
+    dw1000_write_reg(inst, TX_FCTRL_ID, 0, inst->tx_fctrl | (cmd->frame_len + 2) | ((cmd->ranging)?(TX_FCTRL_TR):0), sizeof(uint32_t));
+    inst->status.tx_ranging_frame = cmd->ranging;
+    inst->tx_frame_len = cmd->frame_len;
+
+    inst->control.delay_start_enabled = (cmd->delay >> 8) > 0;
+    if (inst->control.delay_start_enabled)
+        dw1000_write_reg(inst, DX_TIME_ID, 1, cmd->delay >> 8, DX_TIME_LEN-1);
+
+    inst->control.wait4resp_enabled = cmd->wait4resp;
+    inst->control.wait4resp_delay_enabled = cmd->wait4resp && cmd->wait4resp_delay > 0;
+    inst->control.rx_timeout_enabled = cmd->wait4resp && cmd->rx_timeout > 0;
+    if (cmd->wait4resp){
+        if (inst->control.wait4resp_delay_enabled)
+            _dw1000_write_wait4resp_delay(inst, cmd->wait4resp_delay);
+        if (inst->control.rx_timeout_enabled)
+            dw1000_write_reg(inst, RX_FWTO_ID, RX_FWTO_OFFSET, _dw1000_rx_timeout_sniff(inst, cmd->rx_timeout), sizeof(uint16_t));
+        uint32_t sys_cfg_reg = (inst->control.rx_timeout_enabled) ? (inst->sys_cfg_reg | SYS_CFG_RXWTOE) : (inst->sys_cfg_reg & ~SYS_CFG_RXWTOE);
+        if (sys_cfg_reg != inst->sys_cfg_reg){
+            inst->sys_cfg_reg = sys_cfg_reg;
+            dw1000_write_reg(inst, SYS_CFG_ID, 0, inst->sys_cfg_reg, sizeof(uint32_t));
+        }
+        if (cmd->preamble_timeout != inst->pretoc){
+            inst->pretoc = cmd->preamble_timeout;
+            dw1000_write_reg(inst, DRX_CONF_ID, DRX_PRETOC_OFFSET, inst->pretoc, sizeof(uint16_t));
+        }
+    }
+
+    err = os_mutex_release(&inst->mutex);       // Read modify write critical section leave
+    assert(err == OS_OK);
+
+    return _dw1000_start_tx(inst);
+}
+
+/**
+ * Issue the transmit command for the actions staged in inst->control. The caller holds inst->sem, which is released 
+ * by the SYS_STATUS_TXFRS event or here on a delayed transmit error or a frame refused by the regulatory engine.
+ *
+ * @param inst  pointer to dw1000_dev_instance_t.
+ * @return dw1000_dev_status_t
+ */
+static struct _dw1000_dev_status_t _dw1000_start_tx(struct _dw1000_dev_instance_t * inst)
+{
     inst->status.rx_error = inst->status.rx_timeout_error = 0;
 
+#if MYNEWT_VAL(DW1000_REGULATORY)
+    inst->status.tx_denied = inst->regulatory != NULL && !dw1000_regulatory_admit(inst, inst->tx_frame_len);
+    if (inst->status.tx_denied){
+        inst->status.start_tx_error = 1;
+        os_sem_release(&inst->sem);
+        goto control_reset;
+    }
+#endif
+
+    if (inst->control.wait4resp_enabled && !inst->control.wait4resp_delay_enabled && inst->wait4resp_delay)
+        _dw1000_write_wait4resp_delay(inst, 0); // Clear a turn-around time left over from an earlier exchange
+
     if (inst->control.wait4resp_enabled) // Undocumented ANONMALY::This should not be required
         dw1000_write_reg(inst, SYS_CTRL_ID, SYS_CTRL_OFFSET, (uint8_t)SYS_CTRL_WAIT4RESP, sizeof(uint8_t));
         
@@ -448,6 +593,10 @@ struct _dw1000_dev_status_t dw1000_start_tx(struct _dw1000_dev_instance_t * inst
             */
             inst->sys_ctrl_reg = SYS_CTRL_TRXOFF; // This assumes the bit is in the lowest byte
             dw1000_write_reg(inst, SYS_CTRL_ID, SYS_CTRL_OFFSET, (uint8_t) inst->sys_ctrl_reg, sizeof(uint8_t));
+#if MYNEWT_VAL(DW1000_REGULATORY)
+            if (inst->regulatory != NULL)
+                dw1000_regulatory_refund(inst); // Nothing went on air, the budget charged at admission is given back
+#endif
             os_sem_release(&inst->sem); 
         }
     }else{
@@ -455,6 +604,9 @@ struct _dw1000_dev_status_t dw1000_start_tx(struct _dw1000_dev_instance_t * inst
         inst->status.start_tx_error = 0;
     }
 
+#if MYNEWT_VAL(DW1000_REGULATORY)
+control_reset:
+#endif
     inst->control_tx_context = inst->control;
     inst->control = (dw1000_dev_control_t){
         .wait4resp_enabled=0,
@@ -492,6 +644,28 @@ inline struct _dw1000_dev_status_t dw1000_set_delay_start(struct _dw1000_dev_ins
 }
 
 
+/**
+ * Schedule a receive window around the expected arrival of a frame. The receiver is enabled through DX_TIME and 
+ * SYS_CTRL_RXDLYE one SHR plus DW1000_PHY_RX_TIMEOUT_GUARD ahead of the expected RMARKER, rather than listening from 
+ * now until the frame arrives. The frame wait timeout is then counted from the delayed RX enable. Follow with 
+ * dw1000_start_rx; if the enable time has already passed the receiver is turned on immediately.
+ *
+ * @param inst      Pointer to dw1000_dev_instance_t.
+ * @param rx_time   Expected RMARKER of the inbound frame in device time units.
+ * @param rx_nlen   Length of the expected frame in bytes, excluding the FCS.
+ * @return dw1000_dev_status_t
+ */
+struct _dw1000_dev_status_t dw1000_set_rx_window(struct _dw1000_dev_instance_t * inst, uint64_t rx_time, uint16_t rx_nlen)
+{
+    uint32_t lead = dw1000_phy_SHR_duration(inst) + DW1000_PHY_RX_TIMEOUT_GUARD;
+    uint32_t timeout = lead + dw1000_phy_data_duration(inst, rx_nlen) + DW1000_PHY_RX_TIMEOUT_GUARD;
+
+    dw1000_set_delay_start(inst, (rx_time - ((uint64_t)lead << 16)) & 0xFFFFFFFFFFUL);
+    dw1000_set_rx_timeout(inst, (timeout > 0xFFFF) ? 0xFFFF : timeout);
+    return inst->status;
+}
+
+
 /**
  * This call keeps the transceiver in reception mode to keep on receiving the data.
  *
@@ -596,6 +770,21 @@ inline struct _dw1000_dev_status_t dw1000_set_wait4resp(struct _dw1000_dev_insta
 }
 
 
+/**
+ * Extend a frame wait timeout by one sniff period when sniff mode is enabled, since the preamble may then be detected 
+ * up to one sniff period late.
+ *
+ * @param inst      pointer to dw1000_dev_instance_t.
+ * @param timeout   Frame wait timeout in UWB usec.
+ * @return uint16_t Timeout in UWB usec, saturated to the range of RX_FWTO.
+ */
+static uint16_t _dw1000_rx_timeout_sniff(struct _dw1000_dev_instance_t * inst, uint16_t timeout)
+{
+    if (inst->config.sniff_enable)
+        timeout = (timeout > 0xFFFF - dw1000_sniff_period(inst)) ? 0xFFFF : timeout + dw1000_sniff_period(inst);
+    return timeout;
+}
+
 /**
  * The Receive Frame Wait Timeout period is a 16-bit field. The units for this parameter are roughly 1μs, 
  * (the exact unit is 512 counts of the fundamental 499.2 MHz UWB clock, or 1.026 μs). When employing the frame wait timeout, 
@@ -621,13 +810,16 @@ struct _dw1000_dev_status_t dw1000_set_rx_timeout(struct _dw1000_dev_instance_t
     inst->sys_cfg_reg = dw1000_read_reg(inst, SYS_CFG_ID, 0, sizeof(uint32_t));  
     inst->control.rx_timeout_enabled = timeout > 0;
     if(inst->control.rx_timeout_enabled){  
-        dw1000_write_reg(inst, RX_FWTO_ID, RX_FWTO_OFFSET, timeout, sizeof(uint16_t));
+        dw1000_write_reg(inst, RX_FWTO_ID, RX_FWTO_OFFSET, _dw1000_rx_timeout_sniff(inst, timeout), sizeof(uint16_t));
         inst->sys_cfg_reg |= SYS_CFG_RXWTOE;
         dw1000_write_reg(inst, SYS_CFG_ID, 0, inst->sys_cfg_reg, sizeof(uint32_t));
     }else{
         inst->sys_cfg_reg &= ~SYS_CFG_RXWTOE;
         dw1000_write_reg(inst, SYS_CFG_ID, 0, inst->sys_cfg_reg, sizeof(uint32_t));
     }
+    // The preamble detection timeout belongs to the same exchange, clear it so a stale value cannot abort a later receive
+    inst->pretoc = 0;
+    dw1000_write_reg(inst, DRX_CONF_ID, DRX_PRETOC_OFFSET, 0, sizeof(uint16_t));
           
     err = os_mutex_release(&inst->mutex);       // // Read modify write critical section leave
     assert(err == OS_OK);
@@ -637,6 +829,30 @@ struct _dw1000_dev_status_t dw1000_set_rx_timeout(struct _dw1000_dev_instance_t
     return inst->status;
 } 
 
+/**
+ * The preamble detection timeout turns the receiver off if no preamble has been detected within the given number of PACs 
+ * from the RX enable, raising RXPTO through the rx_timeout_cb path. This lets a failed exchange give up a few PACs after 
+ * the expected preamble instead of waiting out the frame wait timeout. dw1000_set_rx_timeout clears the preamble timeout, 
+ * so call this after it. The timeout covers one exchange only, the interrupt handler disarms it once the receiver has 
+ * reported a frame, an error or a timeout. See dw1000_phy_preamble_timeout for sizing.
+ *
+ * @param inst      pointer to dw1000_dev_instance_t.
+ * @param timeout   Preamble detection timeout in units of PAC size symbols. If set to 0 the timeout is disabled.
+ * @return dw1000_dev_status_t
+ */
+struct _dw1000_dev_status_t dw1000_set_preamble_timeout(struct _dw1000_dev_instance_t * inst, uint16_t timeout)
+{
+    os_error_t err = os_sem_pend(&inst->sem,  OS_TIMEOUT_NEVER); // Block if request pending
+    assert(err == OS_OK);
+
+    inst->pretoc = timeout;
+    dw1000_write_reg(inst, DRX_CONF_ID, DRX_PRETOC_OFFSET, timeout, sizeof(uint16_t));
+
+    err = os_sem_release(&inst->sem);  
+    assert(err == OS_OK);
+    return inst->status;
+}
+
 /**
  * This function synchronizes rx buffer pointers to make sure that the host/IC buffer pointers are aligned before starting RX.
  *
@@ -713,23 +929,239 @@ struct _dw1000_dev_status_t dw1000_mac_framefilter(struct _dw1000_dev_instance_t
     os_error_t err = os_sem_pend(&inst->sem,  OS_TIMEOUT_NEVER); // Block if request pending
     assert(err == OS_OK);
 
+    _dw1000_mac_framefilter(inst, enable);
+
+    err = os_sem_release(&inst->sem);  
+    assert(err == OS_OK);
+
+    return inst->status;
+}
+
+/**
+ * Write the frame filter configuration to SYS_CFG. The caller holds inst->sem.
+ *
+ * @param inst     Pointer to dw1000_dev_instance_t.
+ * @param enable   Frame types as for dw1000_mac_framefilter().
+ * @return void
+ */
+static void _dw1000_mac_framefilter(struct _dw1000_dev_instance_t * inst, uint16_t enable)
+{
+    os_error_t err = os_mutex_pend(&inst->mutex, OS_WAIT_FOREVER); // Read modify write critical section enter
+    assert(err == OS_OK);
+
     inst->sys_cfg_reg = SYS_CFG_MASK & dw1000_read_reg(inst, SYS_CFG_ID, 0, sizeof(uint32_t)) ; // Read sysconfig register
 
+    inst->framefilter = enable;
     inst->config.framefilter_enabled = enable > 0;
     if(inst->config.framefilter_enabled){   // Enable frame filtering and configure frame types
+        if (inst->framefilter_windows)      // An extension window is open, let blinks and reserved types through
+            enable |= DWT_FF_RSVD_EN;
         inst->sys_cfg_reg &= ~(SYS_CFG_FF_ALL_EN);  // Clear all
         inst->sys_cfg_reg |= (enable & SYS_CFG_FF_ALL_EN) | SYS_CFG_FFE;
     }else
         inst->sys_cfg_reg &= ~(SYS_CFG_FFE);
 
     dw1000_write_reg(inst, SYS_CFG_ID,0, inst->sys_cfg_reg, sizeof(uint32_t)); 
-    err = os_sem_release(&inst->sem);  
+    err = os_mutex_release(&inst->mutex);       // Read modify write critical section leave
+    assert(err == OS_OK);
+}
+
+/**
+ * API to open or close the frame filter window of an extension. CCP and PAN beacons, tag blinks and
+ * provisioning frames all use blink or reserved frame types, which the hardware filter drops unless
+ * DWT_FF_RSVD_EN is set. While any extension holds its window open these frame types are passed on top
+ * of the types selected with dw1000_mac_framefilter(); once the last window closes they are dropped again.
+ * SYS_CFG is only rewritten when filtering is enabled and the effective setting changes.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @param id    Extension owning the window.
+ * @param open  true to open the window, false to close it.
+ * @return dw1000_dev_status_t
+ */
+struct _dw1000_dev_status_t dw1000_mac_framefilter_window(struct _dw1000_dev_instance_t * inst, dw1000_extension_id_t id, bool open)
+{
+    os_error_t err = os_sem_pend(&inst->sem,  OS_TIMEOUT_NEVER); // Block if request pending
+    assert(err == OS_OK);
+
+    bool was_open = inst->framefilter_windows != 0;
+    if (open)
+        inst->framefilter_windows |= (1 << id);
+    else
+        inst->framefilter_windows &= ~(1 << id);
+    bool is_open = inst->framefilter_windows != 0;
+
+    if (inst->config.framefilter_enabled && !(inst->framefilter & DWT_FF_RSVD_EN) && was_open != is_open)
+        _dw1000_mac_framefilter(inst, inst->framefilter);
+
+    err = os_sem_release(&inst->sem);
     assert(err == OS_OK);
 
     return inst->status;
 }
 
+/**
+ * API to assign the PAN identifier and short address of the device. Both are written to PANADR in a
+ * single transfer so that the hardware frame filter matches the new identity, and cached in the instance
+ * for use as the source address of outgoing frames.
+ *
+ * @param inst           Pointer to dw1000_dev_instance_t.
+ * @param pan_id         PAN identifier.
+ * @param short_address  16-bit short address.
+ * @return dw1000_dev_status_t
+ */
+struct _dw1000_dev_status_t dw1000_mac_set_address(struct _dw1000_dev_instance_t * inst, uint16_t pan_id, uint16_t short_address)
+{
+    os_error_t err = os_sem_pend(&inst->sem,  OS_TIMEOUT_NEVER); // Block if request pending
+    assert(err == OS_OK);
+    err = os_mutex_pend(&inst->mutex, OS_WAIT_FOREVER);
+    assert(err == OS_OK);
+
+    inst->PANID = pan_id;
+    inst->my_short_address = short_address;
+    dw1000_write_reg(inst, PANADR_ID, PANADR_SHORT_ADDR_OFFSET, ((uint32_t) pan_id << 16) | short_address, sizeof(uint32_t));
+
+    err = os_mutex_release(&inst->mutex);
+    assert(err == OS_OK);
+    err = os_sem_release(&inst->sem);
+    assert(err == OS_OK);
+
+    return inst->status;
+}
+
+/**
+ * Preamble codes recommended for a channel at the configured PRF.
+ *
+ * @param inst     Pointer to dw1000_dev_instance_t.
+ * @param channel  Channel.
+ * @return const uint8_t * 0 terminated list, empty if the channel is not supported
+ */
+const uint8_t * dw1000_mac_preamble_codes(struct _dw1000_dev_instance_t * inst, uint8_t channel)
+{
+    if (channel >= sizeof(preamble_codes)/sizeof(preamble_codes[0]))
+        channel = 0;
+    return preamble_codes[channel][inst->config.prf == DWT_PRF_64M];
+}
 
+/**
+ * Rewrite the channel and preamble code dependent registers. The caller holds inst->sem with the transceiver off.
+ * On a change of channel the TX power is reset to the reference value of the new channel and PRF, the power
+ * configured for the old channel does not carry over; a change of preamble code alone keeps it.
+ *
+ * @param inst           Pointer to dw1000_dev_instance_t.
+ * @param channel        Channel {1, 2, 3, 4, 5, 7}.
+ * @param preamble_code  Preamble code for TX and RX, 1 to 8 at 16 MHz PRF and 9 to 24 at 64 MHz PRF.
+ * @return void
+ */
+void dw1000_mac_retune(struct _dw1000_dev_instance_t * inst, uint8_t channel, uint8_t preamble_code)
+{
+    assert((channel >= 1) && (channel <= 7) && (channel != 6));
+    assert(((inst->config.prf == DWT_PRF_64M) && (preamble_code >= 9) && (preamble_code <= 24))
+           || ((inst->config.prf == DWT_PRF_16M) && (preamble_code >= 1) && (preamble_code <= 8)));
+
+    os_error_t err = os_mutex_pend(&inst->mutex, OS_WAIT_FOREVER); // Read modify write critical section enter
+    assert(err == OS_OK);
+
+    uint8_t bw = ((channel == 4) || (channel == 7)) ? 1 : 0 ; // Select wide or narrow band
+    uint16_t reg16 = lde_replicaCoeff[preamble_code];
+    if(inst->config.dataRate == DWT_BR_110K)
+        reg16 >>= 3; // lde_replicaCoeff must be divided by 8
+
+    if (channel != inst->config.channel){
+        inst->config.txrf.power = tx_power[chan_idx[channel]][inst->config.prf == DWT_PRF_64M];
+        dw1000_write_reg(inst, TX_POWER_ID, 0, inst->config.txrf.power, sizeof(uint32_t));
+#if MYNEWT_VAL(DW1000_REGULATORY)
+        if (inst->regulatory)
+            inst->regulatory->base_power = inst->regulatory->power = inst->config.txrf.power;
+#endif
+    }
+    inst->config.channel = channel;
+    inst->config.rx.preambleCodeIndex = inst->config.tx.preambleCodeIndex = preamble_code;
+    inst->config.txrf.PGdly = tc_pgdelay[chan_idx[channel]];
+
+    dw1000_write_reg(inst, LDE_IF_ID, LDE_REPC_OFFSET, reg16, sizeof(uint16_t));
+    dw1000_write_reg(inst, FS_CTRL_ID, FS_PLLCFG_OFFSET, fs_pll_cfg[chan_idx[channel]], sizeof(uint32_t));
+    dw1000_write_reg(inst, FS_CTRL_ID, FS_PLLTUNE_OFFSET, fs_pll_tune[chan_idx[channel]], sizeof(uint8_t));
+    dw1000_write_reg(inst, RF_CONF_ID, RF_RXCTRLH_OFFSET, rx_config[bw], sizeof(uint8_t));
+    dw1000_write_reg(inst, RF_CONF_ID, RF_TXCTRL_OFFSET, tx_config[chan_idx[channel]], sizeof(uint32_t));
+    dw1000_write_reg(inst, TX_CAL_ID, TC_PGDELAY_OFFSET, inst->config.txrf.PGdly, sizeof(uint8_t));
+
+    uint32_t regval = dw1000_read_reg(inst, CHAN_CTRL_ID, 0, sizeof(uint32_t));
+    regval &= ~(CHAN_CTRL_TX_CHAN_MASK | CHAN_CTRL_RX_CHAN_MASK | CHAN_CTRL_TX_PCOD_MASK | CHAN_CTRL_RX_PCOD_MASK);
+    regval |= (CHAN_CTRL_TX_CHAN_MASK & (channel << CHAN_CTRL_TX_CHAN_SHIFT)) |
+              (CHAN_CTRL_RX_CHAN_MASK & (channel << CHAN_CTRL_RX_CHAN_SHIFT)) |
+              (CHAN_CTRL_TX_PCOD_MASK & (preamble_code << CHAN_CTRL_TX_PCOD_SHIFT)) |
+              (CHAN_CTRL_RX_PCOD_MASK & (preamble_code << CHAN_CTRL_RX_PCOD_SHIFT));
+    dw1000_write_reg(inst, CHAN_CTRL_ID, 0, regval, sizeof(uint32_t));
+
+    err = os_mutex_release(&inst->mutex);       // Read modify write critical section leave
+    assert(err == OS_OK);
+}
+
+/**
+ * API to move the device to another channel and preamble code at the configured PRF and data rate. Only the channel
+ * and code dependent registers are rewritten: the PLL, the RF TX and RX blocks, the pulse generator delay, the TX
+ * power, the LDE replica coefficient and the channel control; frame filtering and the rest of the configuration are
+ * left alone. The call waits for a transmit in flight to complete, the transceiver is then turned off and left off.
+ *
+ * @param inst           Pointer to dw1000_dev_instance_t.
+ * @param channel        Channel {1, 2, 3, 4, 5, 7}.
+ * @param preamble_code  Preamble code for TX and RX, 1 to 8 at 16 MHz PRF and 9 to 24 at 64 MHz PRF.
+ * @return dw1000_dev_status_t
+ */
+struct _dw1000_dev_status_t dw1000_mac_set_channel(struct _dw1000_dev_instance_t * inst, uint8_t channel, uint8_t preamble_code)
+{
+    os_error_t err = os_sem_pend(&inst->sem,  OS_TIMEOUT_NEVER); // Block if request pending
+    assert(err == OS_OK);
+
+    dw1000_phy_forcetrxoff(inst);
+    dw1000_mac_retune(inst, channel, preamble_code);
+
+    err = os_sem_release(&inst->sem);
+    assert(err == OS_OK);
+
+    return inst->status;
+}
+
+/**
+ * Enable the event counters, cleared, or disable them.
+ *
+ * @param inst    Pointer to dw1000_dev_instance_t.
+ * @param enable  true to clear and start counting, false to stop.
+ * @return void
+ */
+void dw1000_mac_config_eventcounters(struct _dw1000_dev_instance_t * inst, bool enable)
+{
+    // Counters are cleared on enable, the clear bit has to be written on its own first
+    dw1000_write_reg(inst, DIG_DIAG_ID, EVC_CTRL_OFFSET, EVC_CLR, sizeof(uint8_t));
+    if (enable)
+        dw1000_write_reg(inst, DIG_DIAG_ID, EVC_CTRL_OFFSET, EVC_EN, sizeof(uint8_t));
+}
+
+/**
+ * Read the event counters, each a 12-bit count that wraps.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @param cnts  Pointer to dw1000_mac_deviceentcnts_t to fill.
+ * @return void
+ */
+void dw1000_mac_read_eventcounters(struct _dw1000_dev_instance_t * inst, dw1000_mac_deviceentcnts_t * cnts)
+{
+    uint16_t evc[12];
+
+    dw1000_read(inst, DIG_DIAG_ID, EVC_PHE_OFFSET, (uint8_t *) evc, sizeof(evc));
+    cnts->PHE = evc[0] & EVC_PHE_MASK;
+    cnts->RSL = evc[1] & EVC_RSE_MASK;
+    cnts->CRCG = evc[2] & EVC_FCG_MASK;
+    cnts->CRCB = evc[3] & EVC_FCE_MASK;
+    cnts->ARFE = evc[4] & EVC_FFR_MASK;
+    cnts->OVER = evc[5] & EVC_OVR_MASK;
+    cnts->SFDTO = evc[6] & EVC_OVR_MASK;
+    cnts->PTO = evc[7] & EVC_PTO_MASK;
+    cnts->RTO = evc[8] & EVC_FWTO_MASK;
+    cnts->TXF = evc[9] & EVC_TXFS_MASK;
+    cnts->HPW = evc[10] & EVC_HPW_MASK;
+    cnts->TXW = evc[11] & EVC_TPW_MASK;
+}
 
 /**
  * This call enables the auto-ACK feature. If the delay (parameter) is 0, the ACK will be sent as-soon-as-possable
@@ -805,6 +1237,30 @@ struct _dw1000_dev_status_t dw1000_set_autoack_delay(struct _dw1000_dev_instance
 }
 
 
+/**
+ * Write the W4R_TIM field of ACK_RESP_T. The field persists across transmissions, the value is recorded so that 
+ * dw1000_start_tx can clear it for a later wait4resp exchange that does not request a delay. 
+ * 
+ * @param inst   Pointer to dw1000_dev_instance_t.
+ * @param delay  (20 bits) - The delay is in UWB microseconds.
+ * @return void
+ */
+static void 
+_dw1000_write_wait4resp_delay(struct _dw1000_dev_instance_t * inst, uint32_t delay)
+{
+    os_error_t err = os_mutex_pend(&inst->mutex, OS_WAIT_FOREVER); // Read modify write critical section enter
+    assert(err == OS_OK);
+
+    uint32_t ack_resp_reg = dw1000_read_reg(inst, ACK_RESP_T_ID, 0, sizeof(uint32_t)) ; // Read ACK_RESP_T_ID register
+    ack_resp_reg &= ~(ACK_RESP_T_W4R_TIM_MASK) ;        // Clear the timer (19:0)
+    ack_resp_reg |= (delay & ACK_RESP_T_W4R_TIM_MASK) ; // In UWB microseconds (e.g. turn the receiver on 20uus after TX)
+    dw1000_write_reg(inst, ACK_RESP_T_ID, 0, ack_resp_reg, sizeof(uint32_t));
+    inst->wait4resp_delay = delay & ACK_RESP_T_W4R_TIM_MASK;
+
+    err = os_mutex_release(&inst->mutex);       // // Read modify write critical section exit
+    assert(err == OS_OK);
+}
+
 /**
  * Wait-for-Response turn-around Time. This 20-bit field is used to configure the turn-around time between TX complete 
  * and RX enable when the wait for response function is being used. This function is enabled by the WAIT4RESP control in 
@@ -823,19 +1279,9 @@ struct _dw1000_dev_status_t dw1000_set_wait4resp_delay(struct _dw1000_dev_instan
     assert(err == OS_OK);
 
     inst->control.wait4resp_delay_enabled = delay > 0;
-    if (inst->control.wait4resp_delay_enabled){
-
-        err = os_mutex_pend(&inst->mutex, OS_WAIT_FOREVER); // Read modify write critical section enter
-        assert(err == OS_OK);
+    if (inst->control.wait4resp_delay_enabled)
+        _dw1000_write_wait4resp_delay(inst, delay);
 
-        uint32_t ack_resp_reg = dw1000_read_reg(inst, ACK_RESP_T_ID, 0, sizeof(uint32_t)) ; // Read ACK_RESP_T_ID register
-        ack_resp_reg &= ~(ACK_RESP_T_W4R_TIM_MASK) ;        // Clear the timer (19:0)
-        ack_resp_reg |= (delay & ACK_RESP_T_W4R_TIM_MASK) ; // In UWB microseconds (e.g. turn the receiver on 20uus after TX)
-        dw1000_write_reg(inst, ACK_RESP_T_ID, 0, ack_resp_reg, sizeof(uint32_t));
-        
-        err = os_mutex_release(&inst->mutex);       // // Read modify write critical section exit
-        assert(err == OS_OK);
-    }
     err = os_sem_release(&inst->sem);  
     assert(err == OS_OK);
     return inst->status;
@@ -874,6 +1320,110 @@ struct _dw1000_dev_status_t dw1000_set_dblrxbuff(struct _dw1000_dev_instance_t *
     return inst->status;
 }
 
+/**
+ * Duration of a number of PACs of preamble at the configured PAC size and PRF.
+ *
+ * @param inst   Pointer to dw1000_dev_instance_t.
+ * @param npacs  Number of PACs.
+ * @return uint64_t Duration in device time units.
+ */
+static uint64_t _dw1000_sniff_pacs(struct _dw1000_dev_instance_t * inst, uint16_t npacs)
+{
+    // Preamble symbol of 993.59 ns at 16 MHz PRF and 1017.63 ns at 64 MHz PRF
+    uint32_t symbol = (inst->config.prf == DWT_PRF_16M) ? 31 * 2048 : 127 * 512;
+    return (uint64_t) npacs * (8 << inst->config.rx.pacLength) * symbol;
+}
+
+/**
+ * This call enables sniff mode. While searching for preamble the receiver is duty cycled, on for ontime + 1 PACs, the 
+ * hardware adds one to SNIFF_ONT, and off for offtime usec, until a preamble is detected; the receiver then stays on 
+ * for the rest of the frame. Sniff mode applies to every receiver enable, dw1000_start_rx, dw1000_restart_rx and 
+ * wait4resp alike. The offtime is limited so that a full sniff period fits inside the preamble, and receive timeouts 
+ * set with dw1000_set_rx_timeout are extended by one sniff period.
+ *
+ * @param inst      Pointer to dw1000_dev_instance_t.
+ * @param enable    1 to enable, 0 to disable sniff mode.
+ * @param ontime    Receiver on time in units of PAC, 1 to 15, one PAC less than the on window. Use 2 or more for 
+ *                  reliable preamble detection.
+ * @param offtime   Receiver off time in usec, 0 to 255.
+ * @return dw1000_dev_status_t
+ */
+struct _dw1000_dev_status_t dw1000_set_sniff_mode(struct _dw1000_dev_instance_t * inst, bool enable, uint8_t ontime, uint8_t offtime)
+{
+    if (enable){
+        uint64_t preamble = (uint64_t) dw1000_phy_SHR_duration(inst) << 16;
+        ontime = (ontime == 0) ? 1 : (ontime > RX_SNIFF_SNIFF_ONT_MASK) ? RX_SNIFF_SNIFF_ONT_MASK : ontime;
+        // Leave the on window, ontime + 1 PACs, plus one PAC of preamble for acquisition after a full off period
+        uint64_t on = _dw1000_sniff_pacs(inst, ontime + 2);
+        uint32_t max_offtime = (preamble > on) ? ((preamble - on) * 10) / 638976 : 0;
+        if (offtime > max_offtime)
+            offtime = max_offtime;
+    }else{
+        ontime = offtime = 0;
+    }
+
+    os_error_t err = os_sem_pend(&inst->sem,  OS_TIMEOUT_NEVER); // Block if request pending
+    assert(err == OS_OK);
+    err = os_mutex_pend(&inst->mutex, OS_WAIT_FOREVER); // Read modify write critical section enter
+    assert(err == OS_OK);
+
+    inst->config.sniff_enable = enable && offtime > 0;
+    inst->config.rx.sniffOnTime = ontime;
+    inst->config.rx.sniffOffTime = offtime;
+    dw1000_write_reg(inst, RX_SNIFF_ID, RX_SNIFF_OFFSET, (ontime & RX_SNIFF_SNIFF_ONT_MASK) | ((offtime << 8) & RX_SNIFF_SNIFF_OFFT_MASK), sizeof(uint16_t));
+
+    // PLL2 on/off sequencing is required for the receiver to power down during the off time
+    uint32_t pmsc_ctrl0 = dw1000_read_reg(inst, PMSC_ID, PMSC_CTRL0_OFFSET, sizeof(uint32_t));
+    if (inst->config.sniff_enable)
+        pmsc_ctrl0 |= PMSC_CTRL0_PLL2_SEQ_EN;
+    else
+        pmsc_ctrl0 &= ~PMSC_CTRL0_PLL2_SEQ_EN;
+    dw1000_write_reg(inst, PMSC_ID, PMSC_CTRL0_OFFSET, pmsc_ctrl0, sizeof(uint32_t));
+
+    err = os_mutex_release(&inst->mutex);       // Read modify write critical section exit
+    assert(err == OS_OK);
+    err = os_sem_release(&inst->sem);  
+    assert(err == OS_OK);
+
+    return inst->status;
+}
+
+/**
+ * Duration of one sniff on/off cycle, ontime + 1 PACs on and offtime usec off. This is the worst case added latency 
+ * for preamble detection.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @return uint16_t Sniff period in UWB usec (1.0256 us, the RX_FWTO unit) rounded up, 0 if sniff mode is disabled.
+ */
+uint16_t dw1000_sniff_period(struct _dw1000_dev_instance_t * inst)
+{
+    if (!inst->config.sniff_enable)
+        return 0;
+    uint64_t dtu = _dw1000_sniff_pacs(inst, inst->config.rx.sniffOnTime + 1) 
+                 + ((uint64_t) inst->config.rx.sniffOffTime * 638976) / 10;
+    return (uint16_t)((dtu + 0xFFFF) >> 16);
+}
+
+
+/**
+ * Copy the leading bytes of the received frame. The part already captured by the interrupt handler in cb_data.header 
+ * is served from memory and only the remainder is read over SPI.
+ *
+ * @param inst      Pointer to dw1000_dev_instance_t.
+ * @param buffer    Destination buffer.
+ * @param length    Number of bytes to copy from the start of the frame.
+ * @return void
+ */
+void dw1000_read_rx_frame(struct _dw1000_dev_instance_t * inst, uint8_t * buffer, uint16_t length)
+{
+    uint16_t cached = (inst->cb_data.datalength < DW1000_MAC_CB_HEADER_LEN) ? inst->cb_data.datalength : DW1000_MAC_CB_HEADER_LEN;
+    if (cached > length)
+        cached = length;
+
+    memcpy(buffer, inst->cb_data.header, cached);
+    if (length > cached)
+        dw1000_read_rx(inst, buffer + cached, cached, length - cached);
+}
 
 /**
  * This function reads the RX signal quality diagnostic data.
@@ -894,6 +1444,23 @@ void dw1000_read_rxdiag(struct _dw1000_dev_instance_t * inst, struct _dw1000_dev
     diag->pacc_cnt =  (dw1000_read_reg(inst, RX_FINFO_ID, 0, sizeof(uint32_t)) & RX_FINFO_RXPACC_MASK) >> RX_FINFO_RXPACC_SHIFT;
 }
 
+/**
+ * Receive diagnostics of the frame being serviced. The interrupt handler only reads them once the callbacks have
+ * returned, so a ranging callback commits its response before any diagnostic register is fetched; a callback that
+ * needs them earlier calls this, after its own time critical work. The registers are read at most once per frame.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @return dw1000_dev_rxdiag_t, NULL unless config.rxdiag_enable
+ */
+struct _dw1000_dev_rxdiag_t * dw1000_mac_rxdiag(struct _dw1000_dev_instance_t * inst)
+{
+    if (inst->cb_data.rxdiag == NULL && inst->config.rxdiag_enable){
+        dw1000_read_rxdiag(inst, &inst->rxdiag);
+        inst->cb_data.rxdiag = &inst->rxdiag;
+    }
+    return inst->cb_data.rxdiag;
+}
+
 
 /**
  * The DW1000 processing of interrupts in a task context instead of the interrupt context such that other interrupts 
@@ -939,6 +1506,7 @@ void dw1000_tasks_init(struct _dw1000_dev_instance_t * inst)
 static void dw1000_irq(void *arg)
 {
     dw1000_dev_instance_t * inst = arg;
+    inst->irq_cputime = os_cputime_get32();
     os_eventq_put(&inst->interrupt_eventq, &inst->interrupt_ev);
 //    dw1000_interrupt_ev_cb(NULL);
 }
@@ -979,9 +1547,38 @@ void dw1000_set_callbacks(struct _dw1000_dev_instance_t * inst,  dw1000_dev_cb_t
     inst->rx_error_cb = rx_error_cb;
 }
 
+/**
+ * Register a callback for the receive events that precede the frame completing: preamble detected (SYS_STATUS_RXPRD), 
+ * SFD detected (SYS_STATUS_RXSFDD) and PHY header decoded (SYS_STATUS_RXPHD). Once the SFD is detected the callback 
+ * data carries the raw RX timestamp, RX_TIME_FP_RAWST. It is taken before the LDE first path correction and the 
+ * receive antenna delay, some 257 ns by default, are applied, so it differs from the timestamp reported at RXFCG by 
+ * hundreds of ns: good enough to schedule a response, not to range with. Once the PHR is decoded the callback data 
+ * also carries the frame length and ranging bit. This lets a service prepare its response, delay and TX buffer, while 
+ * the payload is still on air. Frame control, header and diagnostics are not known yet and are cleared, fctrl and 
+ * header to zero and rxdiag to NULL. The callback runs in the interrupt task and should be brief; an event already 
+ * overtaken by the frame completing is not reported.
+ *
+ * @param inst         Pointer to dw1000_dev_instance_t.
+ * @param events       Any of SYS_STATUS_RXPRD, SYS_STATUS_RXSFDD and SYS_STATUS_RXPHD, 0 to disable.
+ * @param rx_early_cb  Callback, NULL to disable.
+ * @return void
+ */
+void dw1000_set_rx_early_cb(struct _dw1000_dev_instance_t * inst, uint32_t events, dw1000_mac_cb_t rx_early_cb)
+{
+    events = (rx_early_cb) ? events & (SYS_STATUS_RXPRD | SYS_STATUS_RXSFDD | SYS_STATUS_RXPHD) : 0;
+    // The event and mask registers share the bit layout
+    if (inst->rx_early_events & ~events)
+        dw1000_phy_interrupt_mask(inst, inst->rx_early_events & ~events, false);
+    inst->rx_early_cb = rx_early_cb;
+    inst->rx_early_events = events;
+    if (events)
+        dw1000_phy_interrupt_mask(inst, events, true);
+}
+
 
 /**
  * This is the DW1000's general Interrupt Service Routine. It will process/report the following events:
+ *          - RXPRD/RXSFDD/RXPHD (through rx_early_cb callback, when enabled with dw1000_set_rx_early_cb)
  *          - RXFCG (through rx_complete_cb callback)
  *          - TXFRS (through tx_complete_cb callback)
  *          - RXRFTO/RXPTO (through rx_timeout_cb callback)
@@ -1000,6 +1597,31 @@ static void dw1000_interrupt_ev_cb(struct os_event *ev)
     dw1000_dev_instance_t * inst = ev->ev_arg;
 
     inst->sys_status = dw1000_read_reg(inst, SYS_STATUS_ID, 0, sizeof(uint32_t)); // Read status register low 32bits
+    inst->cb_data.status = inst->sys_status;
+
+    // Handle early receive events, only while the frame is still on air
+    while((inst->sys_status & inst->rx_early_events) && !(inst->sys_status & (SYS_STATUS_RXFCG | SYS_STATUS_ALL_RX_ERR | SYS_STATUS_ALL_RX_TO))){
+        dw1000_write_reg(inst, SYS_STATUS_ID, 0, inst->sys_status & inst->rx_early_events, sizeof(uint32_t)); // Clear the events reported
+        inst->cb_data.rx_timestamp = 0;
+        inst->cb_data.datalength = 0;
+        inst->cb_data.rx_flags = 0;
+        inst->cb_data.rxdiag = NULL;
+        memset(inst->cb_data.fctrl, 0, sizeof(inst->cb_data.fctrl));
+        memset(inst->cb_data.header, 0, sizeof(inst->cb_data.header));
+        if (inst->sys_status & (SYS_STATUS_RXSFDD | SYS_STATUS_RXPHD))
+            inst->cb_data.rx_timestamp = dw1000_read_reg(inst, RX_TIME_ID, RX_TIME_FP_RAWST_OFFSET, RX_TIME_RX_STAMP_LEN) & 0x0FFFFFFFFFFUL;
+        if (inst->sys_status & SYS_STATUS_RXPHD){
+            uint16_t finfo = dw1000_read_reg(inst, RX_FINFO_ID, RX_FINFO_OFFSET, sizeof(uint16_t));
+            inst->cb_data.datalength = (finfo & RX_FINFO_RXFL_MASK_1023) - 2;
+            inst->cb_data.rx_flags = (finfo & RX_FINFO_RNG) ? DW1000_MAC_CB_RX_FLAG_RNG : 0;
+        }
+        if (inst->rx_early_cb != NULL)
+            inst->rx_early_cb(inst, &inst->cb_data);
+
+        // Events raised before the clear above keep the IRQ line high without a new edge, pick them up in this pass
+        inst->sys_status = dw1000_read_reg(inst, SYS_STATUS_ID, 0, sizeof(uint32_t));
+        inst->cb_data.status = inst->sys_status;
+    }
 
     // Handle TX confirmation event
     if(inst->sys_status & SYS_STATUS_TXFRS){
@@ -1029,30 +1651,54 @@ static void dw1000_interrupt_ev_cb(struct os_event *ev)
     if(inst->sys_status & SYS_STATUS_RXFCG){
         // printf("SYS_STATUS_RXFCG %08lX\n", inst->sys_status);
         dw1000_write_reg(inst, SYS_STATUS_ID, 0, SYS_STATUS_ALL_RX_GOOD, sizeof(uint32_t));     // Clear all receive status bits
+        _dw1000_rx_pretoc_disarm(inst);
         uint16_t finfo = dw1000_read_reg(inst, RX_FINFO_ID, RX_FINFO_OFFSET, sizeof(uint16_t)); // Read frame info - Only the first two bytes of the register are used here.
         inst->frame_len = (finfo & RX_FINFO_RXFL_MASK_1023) - 2;          // Report frame length - Standard frame length up to 127, extended frame length up to 1023 bytes
         inst->status.rx_ranging_frame = (finfo & RX_FINFO_RNG) !=0; // Report ranging bit
-        inst->fctrl = dw1000_read_reg(inst, RX_BUFFER_ID, MAC_FFORMAT_FCTRL, MAC_FFORMAT_FCTRL_LEN);// Report frame control - First bytes of the received frame.
+
+        // Fetch everything the callbacks need for this frame in one pass, handlers use cb_data rather than the SPI bus
+        inst->cb_data.datalength = inst->frame_len;
+        inst->cb_data.rx_flags = (inst->status.rx_ranging_frame) ? DW1000_MAC_CB_RX_FLAG_RNG : 0;
+        uint16_t header_len = (inst->frame_len < DW1000_MAC_CB_HEADER_LEN) ? inst->frame_len : DW1000_MAC_CB_HEADER_LEN;
+        dw1000_read_rx(inst, inst->cb_data.header, 0, (header_len > MAC_FFORMAT_FCTRL_LEN) ? header_len : MAC_FFORMAT_FCTRL_LEN);
+        memcpy(inst->cb_data.fctrl, inst->cb_data.header, MAC_FFORMAT_FCTRL_LEN);
+        memcpy(inst->fctrl_array, inst->cb_data.header, MAC_FFORMAT_FCTRL_LEN); // Report frame control - First bytes of the received frame.
+        if (_dw1000_fctrl_pending(inst))
+            inst->cb_data.rx_flags |= DW1000_MAC_CB_RX_FLAG_PENDING;
+
+        // Drop a frame already processed before its timestamp, diagnostics, payload or any callback is read
+        if (_dw1000_rx_seq_duplicate(inst))
+            dw1000_restart_rx(inst, inst->control_rx_context);
+        else{
+            // Only the timestamp is needed ahead of a response, diagnostics are read after the callbacks
+            inst->cb_data.rx_timestamp = dw1000_read_rxtime(inst);
+            inst->cb_data.rxdiag = NULL;
         
-        // Because of a previous frame not being received properly, AAT bit can be set upon the proper reception of a frame not requesting for
-        // acknowledgement (ACK frame is not actually sent though). If the AAT bit is set, check ACK request bit in frame control to confirm (this
-        // implementation works only for IEEE802.15.4-2011 compliant frames).
-        // This issue is not documented at the time of writing this code. It should be in next release of DW1000 User Manual (v2.09, from July 2016).
-
-        if((inst->sys_status & SYS_STATUS_AAT) && ((inst->fctrl & MAC_FTYPE_ACK) == 0)){
-            dw1000_write_reg(inst, SYS_STATUS_ID, 0, SYS_STATUS_AAT, sizeof(uint32_t));     // Clear AAT status bit in register
-            inst->sys_status &= ~SYS_STATUS_AAT; // Clear AAT status bit in callback data register copy
+            // Because of a previous frame not being received properly, AAT bit can be set upon the proper reception of a frame not requesting for
+            // acknowledgement (ACK frame is not actually sent though). If the AAT bit is set, check ACK request bit in frame control to confirm (this
+            // implementation works only for IEEE802.15.4-2011 compliant frames).
+            // This issue is not documented at the time of writing this code. It should be in next release of DW1000 User Manual (v2.09, from July 2016).
+
+            if((inst->sys_status & SYS_STATUS_AAT) && ((inst->fctrl & MAC_FTYPE_ACK) == 0)){
+                dw1000_write_reg(inst, SYS_STATUS_ID, 0, SYS_STATUS_AAT, sizeof(uint32_t));     // Clear AAT status bit in register
+                inst->sys_status &= ~SYS_STATUS_AAT; // Clear AAT status bit in callback data register copy
+            }
+
+            // Call the corresponding ranging frame services callback if present
+            if(inst->rng_rx_complete_cb != NULL && inst->status.rx_ranging_frame && (inst->sys_status & SYS_STATUS_LDEDONE))
+                inst->rng_rx_complete_cb(inst);
+            // Call the corresponding non-ranging frame callback if present
+            else if(inst->rx_complete_cb != NULL)
+                inst->rx_complete_cb(inst);
+
+            // Collect RX Frame Quality diagnositics
+            dw1000_mac_rxdiag(inst);
+#if MYNEWT_VAL(DW1000_CIR)
+            // Any response is committed by now, the accumulator holds this frame until the next preamble
+            if (inst->cir != NULL)
+                dw1000_cir_capture(inst);
+#endif
         }
-
-        // Call the corresponding ranging frame services callback if present
-        if(inst->rng_rx_complete_cb != NULL && inst->status.rx_ranging_frame && (inst->sys_status & SYS_STATUS_LDEDONE))
-            inst->rng_rx_complete_cb(inst);
-        // Call the corresponding non-ranging frame callback if present
-        else if(inst->rx_complete_cb != NULL)
-            inst->rx_complete_cb(inst);        
-        // Collect RX Frame Quality diagnositics
-        if(inst->config.rxdiag_enable)  
-            dw1000_read_rxdiag(inst, &inst->rxdiag);
         // Toggle the Host side Receive Buffer Pointer
         if (inst->config.dblbuffon_enabled)
             dw1000_write_reg(inst, SYS_CTRL_ID, SYS_CTRL_HRBT_OFFSET, 1, sizeof(uint8_t));
@@ -1062,12 +1708,10 @@ static void dw1000_interrupt_ev_cb(struct os_event *ev)
     inst->status.rx_timeout_error = (inst->sys_status & SYS_STATUS_ALL_RX_TO) !=0;
     if(inst->status.rx_timeout_error){
         // printf("SYS_STATUS_ALL_RX_TO %08lX\n", inst->sys_status);
-        dw1000_write_reg(inst, SYS_STATUS_ID, 0, SYS_STATUS_ALL_RX_TO, sizeof(uint32_t)); // Clear RX timeout event bits        
-        // Because of an issue with receiver restart after error conditions, an RX reset must be applied 
-        // after any error or timeout event to ensure the next good frame's timestamp is computed correctly.
-        // See section "RX Message timestamp" in DW1000 User Manual.
-        dw1000_phy_forcetrxoff(inst);
-        dw1000_phy_rx_reset(inst);
+        _dw1000_rx_recover(inst);
+        _dw1000_rx_pretoc_disarm(inst);
+        if (inst->config.rx_rearm_enable)
+            _dw1000_rx_rearm(inst);
 
         // Call the corresponding ranging frame services callback if present
         if(inst->rng_rx_timeout_cb != NULL )
@@ -1082,12 +1726,10 @@ static void dw1000_interrupt_ev_cb(struct os_event *ev)
     inst->status.rx_error = (inst->sys_status & SYS_STATUS_ALL_RX_ERR) !=0 ;
     if(inst->status.rx_error){
         // printf("SYS_STATUS_ALL_RX_ERR %08lX\n", inst->sys_status);
-        dw1000_write_reg(inst, SYS_STATUS_ID, 0, SYS_STATUS_ALL_RX_ERR, sizeof(uint32_t)); // Clear RX error event bits
-        // Because of an issue with receiver restart after error conditions, an RX reset must be applied after any error or timeout event to ensure
-        // the next good frame's timestamp is computed correctly.
-        // See section "RX Message timestamp" in DW1000 User Manual.
-        dw1000_phy_forcetrxoff(inst);
-        dw1000_phy_rx_reset(inst);
+        _dw1000_rx_recover(inst);
+        _dw1000_rx_pretoc_disarm(inst);
+        if (inst->config.rx_rearm_enable)
+            _dw1000_rx_rearm(inst);
 
         // Call the corresponding ranging frame services callback if present
         if(inst->rng_rx_error_cb != NULL )
@@ -1100,6 +1742,162 @@ static void dw1000_interrupt_ev_cb(struct os_event *ev)
 }
 
 
+/**
+ * Disarm the preamble detection timeout of the exchange that has just ended, so it cannot abort a later receive started 
+ * by dw1000_start_rx or a re-arm. Costs a register write only when a timeout was armed.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @return void
+ */
+static void _dw1000_rx_pretoc_disarm(struct _dw1000_dev_instance_t * inst)
+{
+    if (inst->pretoc){
+        inst->pretoc = 0;
+        dw1000_write_reg(inst, DRX_CONF_ID, DRX_PRETOC_OFFSET, 0, sizeof(uint16_t));
+    }
+}
+
+/**
+ * Recover the receiver after a timeout or error event. Because of an issue with receiver restart after error conditions, 
+ * an RX reset must be applied after any error or timeout event to ensure the next good frame's timestamp is computed 
+ * correctly, see section "RX Message timestamp" in DW1000 User Manual. This is the minimal form of dw1000_phy_forcetrxoff 
+ * followed by dw1000_phy_rx_reset: the interrupt mask is left alone since the event is already being serviced, and the 
+ * double buffer pointers are aligned from the status register value read on entry rather than a fresh read.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @return void
+ */
+static void _dw1000_rx_recover(struct _dw1000_dev_instance_t * inst)
+{
+    dw1000_write_reg(inst, SYS_CTRL_ID, SYS_CTRL_OFFSET, (uint8_t)SYS_CTRL_TRXOFF, sizeof(uint8_t)); // Disable the radio
+    dw1000_phy_rx_reset(inst);
+    dw1000_write_reg(inst, SYS_STATUS_ID, 0, (SYS_STATUS_ALL_RX_ERR | SYS_STATUS_ALL_RX_TO | SYS_STATUS_ALL_RX_GOOD), sizeof(uint32_t));
+    if (inst->config.dblbuffon_enabled &&
+        ((inst->sys_status & SYS_STATUS_ICRBP) != 0) != ((inst->sys_status & SYS_STATUS_HSRBP) != 0)){
+        dw1000_write_reg(inst, SYS_CTRL_ID, SYS_CTRL_HRBT_OFFSET, 0x01, sizeof(uint8_t)); // Swap the host side buffer to match the IC
+        inst->sys_status ^= SYS_STATUS_HSRBP;
+    }
+    inst->control.wait4resp_enabled = 0;
+}
+
+/**
+ * Put the receiver straight back into reception after _dw1000_rx_recover, for devices that listen continuously 
+ * (config.rx_rearm_enable). The frame wait timeout left enabled by the last exchange is turned off first, and the 
+ * preamble detection timeout has already been disarmed, so the re-armed receive listens without a timeout instead of 
+ * inheriting a stale one; the next dw1000_set_rx_timeout or wait4resp command sets them again. The re-arm is skipped 
+ * while a transmission holds inst->sem. The time from the interrupt to 
+ * the receiver enable is reported in rx_rearm_dead_time and rx_rearm_dead_time_max. Callbacks of a device using this 
+ * should not restart the receiver themselves.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @return void
+ */
+static void _dw1000_rx_rearm(struct _dw1000_dev_instance_t * inst)
+{
+    if (os_sem_pend(&inst->sem, 0) != OS_OK)
+        return;
+
+    inst->status.start_rx_error = 0;
+    if (inst->sys_cfg_reg & SYS_CFG_RXWTOE){
+        os_error_t err = os_mutex_pend(&inst->mutex, OS_WAIT_FOREVER); // Read modify write critical section enter
+        assert(err == OS_OK);
+        inst->sys_cfg_reg &= ~SYS_CFG_RXWTOE;
+        dw1000_write_reg(inst, SYS_CFG_ID, 0, inst->sys_cfg_reg, sizeof(uint32_t));
+        err = os_mutex_release(&inst->mutex);   // Read modify write critical section leave
+        assert(err == OS_OK);
+    }
+    inst->control.rx_timeout_enabled = 0;
+    dw1000_write_reg(inst, SYS_CTRL_ID, SYS_CTRL_OFFSET, SYS_CTRL_RXENAB, sizeof(uint16_t));
+    inst->rx_rearm_dead_time = os_cputime_ticks_to_usecs(os_cputime_get32() - inst->irq_cputime);
+    if (inst->rx_rearm_dead_time > inst->rx_rearm_dead_time_max)
+        inst->rx_rearm_dead_time_max = inst->rx_rearm_dead_time;
+
+    os_error_t err = os_sem_release(&inst->sem); 
+    assert(err == OS_OK); 
+}
+
+/**
+ * Strip the frame pending bit from the reported frame control of IEEE 802.15.4 data frames, so that services keep 
+ * matching inst->fctrl against the values in dw1000_ftypes.h. Blink frames carry a one byte frame control and are 
+ * left untouched.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @return true if the frame pending bit was set.
+ */
+static bool _dw1000_fctrl_pending(struct _dw1000_dev_instance_t * inst)
+{
+    if ((inst->fctrl & MAC_FTYPE_MASK) != MAC_FTYPE_DATA || (inst->fctrl & MAC_FCTRL_FRAME_PENDING) == 0)
+        return false;
+    inst->fctrl &= ~MAC_FCTRL_FRAME_PENDING;
+    return true;
+}
+
+/**
+ * Check a received frame against the receive duplicate cache. The source address and sequence number are taken from
+ * the cached header of the blink and 16-bit address frame formats in dw1000_ftypes.h, other frames are never treated
+ * as duplicates. A frame is a duplicate when its source last sent the same sequence number with the same length and
+ * header; a new frame replaces the source's entry, a new source replaces the oldest entry.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @return true if the frame should be dropped.
+ */
+static bool _dw1000_rx_seq_duplicate(struct _dw1000_dev_instance_t * inst)
+{
+#if MYNEWT_VAL(DW1000_RX_SEQ_CACHE_SIZE) > 0
+    if (inst->config.promiscuous_enable)
+        return false;
+    const uint8_t * header = inst->cb_data.header;
+    uint64_t src_address = 0;
+    uint8_t seq_num;
+
+    if ((header[0] == FCNTL_IEEE_BLINK_CCP_64 || header[0] == FCNTL_IEEE_BLINK_TAG_64 || header[0] == FCNTL_IEEE_BLINK_ANC_64)
+        && inst->frame_len >= sizeof(ieee_blink_frame_t)){
+        seq_num = header[offsetof(ieee_blink_frame_t, seq_num)];
+        memcpy(&src_address, &header[offsetof(ieee_blink_frame_t, long_address)], sizeof(uint64_t));
+    }else if ((inst->fctrl == FCNTL_IEEE_RANGE_16 || inst->fctrl == FCNTL_IEEE_PROVISION_16 || inst->fctrl == FCNTL_IEEE_BULK_16)
+        && inst->frame_len >= sizeof(ieee_std_frame_t)){
+        seq_num = header[offsetof(ieee_std_frame_t, seq_num)];
+        memcpy(&src_address, &header[offsetof(ieee_std_frame_t, src_address)], sizeof(uint16_t));
+    }else
+        return false;
+
+    // Ranging exchanges reuse the sequence number of the request, the header tells the stages apart
+    uint16_t header_len = (inst->frame_len < DW1000_MAC_CB_HEADER_LEN) ? inst->frame_len : DW1000_MAC_CB_HEADER_LEN;
+    uint32_t hash = 2166136261UL ^ inst->frame_len;    // FNV-1a
+    for (uint16_t i = 0; i < header_len; i++)
+        hash = (hash ^ header[i]) * 16777619UL;
+    uint16_t fingerprint = (uint16_t)(hash ^ (hash >> 16));
+
+    dw1000_rx_seq_cache_t * cache = &inst->rx_seq_cache;
+    dw1000_rx_seq_entry_t * entry = NULL;
+    for (uint8_t i = 0; i < MYNEWT_VAL(DW1000_RX_SEQ_CACHE_SIZE); i++){
+        if (cache->entries[i].valid && cache->entries[i].src_address == src_address){
+            entry = &cache->entries[i];
+            break;
+        }
+    }
+    if (entry){
+        if (entry->seq_num == seq_num && entry->fingerprint == fingerprint){
+            cache->duplicates++;
+            return true;
+        }
+    }else{
+        cache->misses++;
+        entry = &cache->entries[cache->idx];
+        if (entry->valid)
+            cache->evictions++;
+        cache->idx = (cache->idx + 1) % MYNEWT_VAL(DW1000_RX_SEQ_CACHE_SIZE);
+    }
+    *entry = (dw1000_rx_seq_entry_t){
+        .src_address = src_address,
+        .fingerprint = fingerprint,
+        .seq_num = seq_num,
+        .valid = 1
+    };
+#endif
+    return false;
+}
+
 /** 
  * This call calculates rssi from last RX in dBm, which needs config.rxdiag_enable to be set.
  *
@@ -1124,8 +1922,103 @@ dw1000_get_rssi(struct _dw1000_dev_instance_t * inst)
     return rssi;
 }
 
+#define DW1000_DB_PER_LOG2_Q14  (49321)    //!< 10 * log10(2) in Q14
+#define DW1000_RX_PWR_A_PRF16_Q8 (29624)    //!< 115.72 dB in Q8, the PRF constant of dw1000_get_rssi
+#define DW1000_RX_PWR_A_PRF64_Q8 (31421)    //!< 122.74 dB in Q8
+
+/**
+ * Scale a base 2 logarithm to decibels and subtract the PRF dependent constant A, saturating to the int16_t range.
+ * With dw1000_log2_q8 the power levels are within 0.035 dB of the libm computation, see test/test_mac.c.
+ *
+ * @param inst     Pointer to dw1000_dev_instance_t.
+ * @param log2_q8  Power ratio as log2 in Q8.
+ * @return int16_t power level in dBm * 256
+ */
+static int16_t
+_dw1000_pwr_q8(struct _dw1000_dev_instance_t * inst, int32_t log2_q8)
+{
+    int32_t db_q8 = (log2_q8 * DW1000_DB_PER_LOG2_Q14 + (1 << 13)) >> 14;
+    db_q8 -= (inst->config.prf == DWT_PRF_16M) ? DW1000_RX_PWR_A_PRF16_Q8 : DW1000_RX_PWR_A_PRF64_Q8;
+    return (db_q8 > INT16_MAX) ? INT16_MAX : (db_q8 <= INT16_MIN) ? INT16_MIN + 1 : db_q8;
+}
+
+/**
+ * Receive power level of the last RX in Q8 dBm, the integer counterpart of dw1000_get_rssi for use in the interrupt
+ * task on parts without an FPU. 10 * log10(C * 2^17 / N^2) - A is formed as log2 terms, C being cir_pwr and N pacc_cnt.
+ * Needs config.rxdiag_enable to be set.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @return int16_t rssi in dBm * 256, INT16_MIN without diagnostics
+ */
+int16_t
+dw1000_get_rssi_q8(struct _dw1000_dev_instance_t * inst)
+{
+    if (!inst->config.rxdiag_enable || inst->rxdiag.cir_pwr == 0 || inst->rxdiag.pacc_cnt == 0)
+        return INT16_MIN;
+
+    return _dw1000_pwr_q8(inst, dw1000_log2_q8(inst->rxdiag.cir_pwr) + (17 << 8) - 2 * dw1000_log2_q8(inst->rxdiag.pacc_cnt));
+}
+
+/**
+ * First path power level of the last RX in Q8 dBm, 10 * log10((F1^2 + F2^2 + F3^2) / N^2) - A with the first path
+ * amplitudes of the receive diagnostics. A first path power well below the receive power marks a weak or blocked direct
+ * path. Needs config.rxdiag_enable to be set.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @return int16_t first path power in dBm * 256, INT16_MIN without diagnostics
+ */
+int16_t
+dw1000_get_fppl_q8(struct _dw1000_dev_instance_t * inst)
+{
+    uint64_t fp_pwr = (uint64_t) inst->rxdiag.fp_amp * inst->rxdiag.fp_amp
+                    + (uint64_t) inst->rxdiag.fp_amp2 * inst->rxdiag.fp_amp2
+                    + (uint64_t) inst->rxdiag.fp_amp3 * inst->rxdiag.fp_amp3;
+
+    if (!inst->config.rxdiag_enable || fp_pwr == 0 || inst->rxdiag.pacc_cnt == 0)
+        return INT16_MIN;
+
+    return _dw1000_pwr_q8(inst, dw1000_log2_q8(fp_pwr) - 2 * dw1000_log2_q8(inst->rxdiag.pacc_cnt));
+}
+
 #if MYNEWT_VAL(ADAPTIVE_TIMESCALE_ENABLED)
 
+#define DW1000_SKEW_Q40_MAX ((int32_t)0x7FFFFFFF) //!< Largest skew offset from unity in Q40, about 1950 ppm
+
+/**
+ * Scale a device timestamp by the clock calibration skew in integer arithmetic. The skew is held as a signed Q40 
+ * offset from unity and time * skew is formed as time + time * (skew - 1). The 40-bit timestamp is split into 20-bit 
+ * halves so that each partial product fits in 64 bits; the result is exact to within one device time unit. The Q40 
+ * value is only rederived when clkcal publishes a new skew, which keeps floating point off the timestamp path, and is
+ * read and updated with interrupts disabled since the readers run in both the interrupt task and application tasks.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @param time  Raw timestamp in device time units.
+ * @return uint64_t Compensated timestamp, not masked to 40 bits.
+ */
+static inline uint64_t 
+_dw1000_apply_skew(struct _dw1000_dev_instance_t * inst, uint64_t time)
+{
+    dw1000_ccp_instance_t * ccp = inst->ccp;
+    os_sr_t sr;
+
+    // The cache is shared by the interrupt task and the tasks reading timestamps, the 64-bit skew must not tear
+    OS_ENTER_CRITICAL(sr);
+    if (memcmp(&ccp->skew, &ccp->clkcal->skew, sizeof(ccp->skew)) != 0){
+        ccp->skew = ccp->clkcal->skew;
+        double scaled = (ccp->skew - 1.0) * (double)(1ULL << 40);
+        int64_t q40 = (int64_t)(scaled + ((scaled >= 0) ? 0.5 : -0.5));     // Rounded to nearest, at most half a unit on the timestamp
+        ccp->skew_q40 = (q40 > DW1000_SKEW_Q40_MAX) ? DW1000_SKEW_Q40_MAX :
+                        (q40 < -DW1000_SKEW_Q40_MAX) ? -DW1000_SKEW_Q40_MAX : (int32_t) q40;
+    }
+    int32_t skew_q40 = ccp->skew_q40;
+    OS_EXIT_CRITICAL(sr);
+
+    int64_t hi = (int64_t)(time >> 20) * skew_q40;
+    int64_t lo = (int64_t)(time & 0xFFFFF) * skew_q40;
+    int64_t offset = hi + (lo >> 20);
+    return time + ((offset + (1LL << 19)) >> 20);
+}
+
 /**
  * With CLOCK_CLAIBRATION enabled all time local clock are adjusted to master clock frequency.The compensated local clock value are offset 
  * from the master clock, but the frequency is adjusted such that any derived values will be the same. CLOCK_CLAIBRATION is usefull for
@@ -1142,7 +2035,7 @@ inline uint64_t dw1000_read_systime(struct _dw1000_dev_instance_t * inst){
     uint64_t time = ((uint64_t) dw1000_read_reg(inst, SYS_TIME_ID, SYS_TIME_OFFSET, SYS_TIME_LEN)) & 0x0FFFFFFFFFFUL;
     
     if (clk->status.valid)
-        time *= inst->ccp->clkcal->skew;
+        time = _dw1000_apply_skew(inst, time);
 
     return time & 0x0FFFFFFFFFFUL;
 }
@@ -1173,7 +2066,7 @@ inline uint32_t dw1000_read_systime_lo(struct _dw1000_dev_instance_t * inst){
     uint32_t time = (uint32_t) dw1000_read_reg(inst, SYS_TIME_ID, SYS_TIME_OFFSET, sizeof(uint32_t));
     
     if (clk->status.valid)
-        time *= inst->ccp->clkcal->skew;
+        time = _dw1000_apply_skew(inst, time);
 
     return time;
 }
@@ -1192,7 +2085,7 @@ inline uint64_t dw1000_read_rxtime(struct _dw1000_dev_instance_t * inst){
 
     uint64_t time = (uint64_t)  dw1000_read_reg(inst, RX_TIME_ID, RX_TIME_RX_STAMP_OFFSET, RX_TIME_RX_STAMP_LEN) & 0x0FFFFFFFFFFUL;
     if (clk->status.valid)
-        time *= inst->ccp->clkcal->skew;
+        time = _dw1000_apply_skew(inst, time);
     return time & 0x0FFFFFFFFFFUL;
 }
 
@@ -1246,7 +2139,7 @@ inline uint32_t dw1000_read_rxtime_lo(struct _dw1000_dev_instance_t * inst){
 
     uint64_t time = (uint32_t) dw1000_read_reg(inst, RX_TIME_ID, RX_TIME_RX_STAMP_OFFSET, sizeof(uint32_t));
     if (clk->status.valid)
-        time *= inst->ccp->clkcal->skew;
+        time = _dw1000_apply_skew(inst, time);
     return time;
 }
 
@@ -1264,7 +2157,7 @@ inline uint64_t dw1000_read_txtime(struct _dw1000_dev_instance_t * inst){
 
     uint64_t time = (uint64_t) dw1000_read_reg(inst, TX_TIME_ID, TX_TIME_TX_STAMP_OFFSET, TX_TIME_TX_STAMP_LEN) & 0x0FFFFFFFFFFUL;
     if (clk->status.valid)
-        time *= inst->ccp->clkcal->skew;
+        time = _dw1000_apply_skew(inst, time);
     return time & 0x0FFFFFFFFFFUL;
 }
 
@@ -1281,7 +2174,7 @@ inline uint32_t dw1000_read_txtime_lo(struct _dw1000_dev_instance_t * inst){
 
     uint32_t time = (uint32_t) dw1000_read_reg(inst, TX_TIME_ID, TX_TIME_TX_STAMP_OFFSET, sizeof(uint32_t));
     if (clk->status.valid)
-        time *= inst->ccp->clkcal->skew;
+        time = _dw1000_apply_skew(inst, time);
     return time;
 }
 
@@ -81,7 +81,7 @@ pan_timer_ev_cb(struct os_event *ev) {
     dw1000_pan_instance_t * pan = inst->pan; 
 
     if(dw1000_pan_blink(inst, DWT_BLOCKING).start_tx_error)
-        os_callout_reset(&pan->pan_callout_timer, OS_TICKS_PER_SEC * (pan->period - MYNEWT_VAL(OS_LATENCY)) * 1e-6);   
+        os_callout_reset(&pan->pan_callout_timer, OS_TICKS_PER_SEC * (pan->period - MYNEWT_VAL(OS_LATENCY) - dw1000_phy_SHR_duration(inst)) * 1e-6);   
 }
 
 /**
@@ -144,6 +144,8 @@ dw1000_pan_init(dw1000_dev_instance_t * inst,  dw1000_pan_config_t * config){
     pan_cbs.tx_error_cb = pan_tx_error_cb;
     
     dw1000_pan_set_ext_callbacks(inst, pan_cbs);
+    // Blinks and PAN responses are reserved frame types, pass them until an identity is assigned
+    dw1000_mac_framefilter_window(inst, DW1000_PAN, true);
 
     dw1000_pan_instance_t * pan = inst->pan; 
     pan_frame_t * frame = pan->frames[(pan->idx)%pan->nframes]; 
@@ -269,20 +271,26 @@ pan_rx_complete_cb(dw1000_dev_instance_t * inst){
     pan_frame_t * frame = pan->frames[(pan->idx)%pan->nframes];
 
     if (inst->frame_len == sizeof(struct _ieee_blink_frame_t)){
-        dw1000_read_rx(inst, frame->array, 0, sizeof(struct _ieee_blink_frame_t));
-        frame->reception_timestamp = dw1000_read_rxtime(inst); 
+        dw1000_read_rx_frame(inst, frame->array, sizeof(struct _ieee_blink_frame_t));
+        frame->reception_timestamp = inst->cb_data.rx_timestamp; 
         int32_t tracking_interval = (int32_t) dw1000_read_reg(inst, RX_TTCKI_ID, 0, sizeof(int32_t));
         int32_t tracking_offset = (int32_t) dw1000_read_reg(inst, RX_TTCKO_ID, 0, sizeof(int32_t)) & RX_TTCKO_RXTOFS_MASK;
         frame->correction_factor = 1.0f + ((float)tracking_offset) / tracking_interval;
     }
     else if (inst->frame_len == sizeof(struct _pan_frame_resp_t)) { 
-        dw1000_read_rx(inst, frame->array, 0, sizeof(struct _pan_frame_resp_t));
+        dw1000_read_rx_frame(inst, frame->array, sizeof(struct _pan_frame_resp_t));
 
         if(frame->long_address == inst->my_long_address){   
             // TAG/ANCHOR side
-            inst->my_short_address = frame->short_address;
-            inst->PANID = frame->pan_id;
+            dw1000_mac_set_address(inst, frame->pan_id, frame->short_address);
+#if MYNEWT_VAL(DW1000_MAC_FILTERING)
+            dw1000_mac_framefilter(inst, DWT_FF_BEACON_EN | DWT_FF_DATA_EN);
+#endif
             inst->slot_id = frame->slot_id;
+#if MYNEWT_VAL(DW1000_COEX)
+            if (inst->coex)
+                dw1000_coex_apply(inst, frame->coex);
+#endif
             pan->status.valid = true;
             dw1000_pan_stop(inst);
             os_sem_release(&pan->sem);
@@ -313,7 +321,7 @@ pan_tx_complete_cb(dw1000_dev_instance_t * inst){
     }
     dw1000_pan_instance_t * pan = inst->pan;
     if (pan->status.timer_enabled && pan->status.valid == false)
-        os_callout_reset(&pan->pan_callout_timer, OS_TICKS_PER_SEC * (pan->period - MYNEWT_VAL(OS_LATENCY)) * 1e-6); 
+        os_callout_reset(&pan->pan_callout_timer, OS_TICKS_PER_SEC * (pan->period - MYNEWT_VAL(OS_LATENCY) - dw1000_phy_SHR_duration(inst)) * 1e-6); 
     os_sem_release(&inst->pan->sem);  
     pan->idx++;
 }
@@ -409,7 +417,11 @@ dw1000_pan_blink(dw1000_dev_instance_t * inst, dw1000_dev_modes_t mode){
     dw1000_write_tx_fctrl(inst, sizeof(ieee_blink_frame_t), 0, true); 
     dw1000_set_wait4resp(inst, true);    
     dw1000_set_delay_start(inst, frame->transmission_timestamp);   
-    dw1000_set_rx_timeout(inst, pan->config->rx_timeout_period); 
+    uint16_t timeout = dw1000_phy_wait4resp_timeout(inst, dw1000_phy_turnaround_time(inst, sizeof(ieee_blink_frame_t)), 
+            sizeof(ieee_blink_frame_t), sizeof(struct _pan_frame_resp_t));
+    dw1000_set_rx_timeout(inst, (pan->config->rx_timeout_period > timeout) ? pan->config->rx_timeout_period : timeout); 
+    if (pan->config->rx_timeout_period < timeout)
+        dw1000_set_preamble_timeout(inst, dw1000_phy_preamble_timeout(inst, dw1000_phy_turnaround_time(inst, sizeof(ieee_blink_frame_t)), sizeof(ieee_blink_frame_t)));
     pan->status.start_tx_error = dw1000_start_tx(inst).start_tx_error;
     if (pan->status.start_tx_error){
         // Half Period Delay Warning occured try for the next epoch
@@ -448,6 +460,7 @@ dw1000_pan_start(dw1000_dev_instance_t * inst, dw1000_dev_modes_t mode){
     pan->status.valid = false;
     pan_frame_t * frame = pan->frames[(pan->idx)%pan->nframes]; 
     frame->transmission_timestamp = dw1000_read_systime(inst); 
+    dw1000_mac_framefilter_window(inst, DW1000_PAN, true);
     pan_timer_init(inst);
 
     printf("{\"utime\":%lu,\"PAN\":\"%s\"}\n", 
@@ -473,6 +486,7 @@ dw1000_pan_stop(dw1000_dev_instance_t * inst){
     dw1000_pan_instance_t * pan = inst->pan;   
     pan->status.timer_enabled = false;
     os_callout_stop(&pan->pan_callout_timer);
+    dw1000_mac_framefilter_window(inst, DW1000_PAN, false);
     printf("{\"utime\":%lu,\"PAN\":\"%s\"}\n", 
             os_cputime_ticks_to_usecs(os_cputime_get32()),
             "Stopped"
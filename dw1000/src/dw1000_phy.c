@@ -277,6 +277,35 @@ float dw1000_phy_read_read_wakeupvbat_SI(struct _dw1000_dev_instance_t * inst)
     return (1.0/173) * (dw1000_phy_read_wakeupvbat(inst) - inst->otp_vbat) + 3.3;
 }
 
+/**
+ * This function samples the temperature and battery voltage SAR now, rather than at the last wakeup. The sensor
+ * biases are turned on, a conversion is started and the latest readings collected once it completes. The conversion
+ * is independent of the radio, but its register accesses contend with TX and RX operations for the SPI; callers are
+ * expected to hold inst->sem. Conversion to SI units is as for the wakeup readings, 1.14 degrees C and 1/173 V per LSB
+ * from the OTP values at 23 degrees C and 3.3 V.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @return uint16_t  Temperature reading in the high byte, voltage reading in the low byte.
+ */
+uint16_t dw1000_phy_read_tempvbat(struct _dw1000_dev_instance_t * inst)
+{
+    dw1000_write_reg(inst, RF_CONF_ID, RF_SENSOR_BIAS_OFFSET, RF_SENSOR_BIAS_TLD, sizeof(uint8_t));
+    dw1000_write_reg(inst, RF_CONF_ID, RF_SENSOR_CTRL_OFFSET, RF_SENSOR_CTRL_BIAS, sizeof(uint8_t));
+    dw1000_write_reg(inst, RF_CONF_ID, RF_SENSOR_CTRL_OFFSET, RF_SENSOR_CTRL_OUT, sizeof(uint8_t));
+
+    // A rising edge on SAR_C starts the conversion
+    dw1000_write_reg(inst, TX_CAL_ID, TC_SARL_SAR_C, 0, sizeof(uint8_t));
+    dw1000_write_reg(inst, TX_CAL_ID, TC_SARL_SAR_C, 1, sizeof(uint8_t));
+    os_cputime_delay_usecs(5);
+
+    // Register block TX_CAL has to be read one byte at a time
+    uint8_t vbat = dw1000_read_reg(inst, TX_CAL_ID, TC_SARL_SAR_LVBAT_OFFSET, sizeof(uint8_t));
+    uint8_t temp = dw1000_read_reg(inst, TX_CAL_ID, TC_SARL_SAR_LTEMP_OFFSET, sizeof(uint8_t));
+    dw1000_write_reg(inst, TX_CAL_ID, TC_SARL_SAR_C, 0, sizeof(uint8_t));
+
+    return (temp << 8) | vbat;
+}
+
 /**
  * This function resets the receiver of the DW1000.
  *
@@ -378,13 +407,201 @@ void dw1000_phy_interrupt_mask(struct _dw1000_dev_instance_t * inst, uint32_t bi
 void dw1000_phy_external_sync(struct _dw1000_dev_instance_t * inst, uint8_t delay, bool enable){
 
     uint16_t reg = dw1000_read_reg(inst, EXT_SYNC_ID, EC_CTRL_OFFSET, sizeof(uint16_t));
+    reg &= ~(EC_CTRL_WAIT_MASK | EC_CTRL_OSTRM); //clear timer value, clear OSTRM
     if (enable) {
-        reg &= EC_CTRL_WAIT_MASK; //clear timer value, clear OSTRM
         reg |= EC_CTRL_OSTRM;
         reg |= ((((uint16_t) delay) & 0xff) << 3); //set new timer value
-
-    }else {
-        reg &= EC_CTRL_WAIT_MASK ; //clear timer value, clear OSTRM
-    }    
+    }
     dw1000_write_reg(inst, EXT_SYNC_ID, EC_CTRL_OFFSET, reg, sizeof(uint16_t));
 }
+
+/**
+ * Preamble symbol duration for the configured PRF, in device time units (1/(128*499.2MHz)).
+ * 993.59ns for 16MHz PRF and 1017.63ns for 64MHz PRF.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @return uint32_t
+ */
+static uint32_t 
+_dw1000_phy_preamble_symbol(struct _dw1000_dev_instance_t * inst)
+{
+    return (inst->config.prf == DWT_PRF_16M) ? 31 * 2048 : 127 * 512;
+}
+
+/**
+ * Data symbol duration for the configured data rate, in device time units.
+ * 8205.13ns for 110kbps, 1025.64ns for 850kbps and 128.21ns for 6.8Mbps.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @return uint32_t
+ */
+static uint32_t 
+_dw1000_phy_data_symbol(struct _dw1000_dev_instance_t * inst)
+{
+    switch (inst->config.dataRate){
+        case DWT_BR_110K: return 0x80000;
+        case DWT_BR_850K: return 0x10000;
+        default: return 0x2000;
+    }
+}
+
+/**
+ * Convert a TX_FCTRL preamble length code into the number of preamble symbols.
+ *
+ * @param plen  DWT_PLEN_64..DWT_PLEN_4096.
+ * @return uint16_t
+ */
+static uint16_t 
+_dw1000_phy_preamble_length(uint8_t plen)
+{
+    switch (plen){
+        case DWT_PLEN_4096: return 4096;
+        case DWT_PLEN_2048: return 2048;
+        case DWT_PLEN_1536: return 1536;
+        case DWT_PLEN_1024: return 1024;
+        case DWT_PLEN_512: return 512;
+        case DWT_PLEN_256: return 256;
+        case DWT_PLEN_128: return 128;
+        default: return 64;
+    }
+}
+
+/**
+ * Convert device time units into UWB usec (0x10000 dtu), rounding up so that the result 
+ * is never shorter than the air time it represents. 
+ *
+ * @param dtu   Duration in device time units.
+ * @return uint32_t
+ */
+static inline uint32_t 
+_dw1000_phy_dtu_to_usec(uint64_t dtu)
+{
+    return (uint32_t)((dtu + 0xFFFF) >> 16);
+}
+
+/**
+ * Synchronisation header (preamble + SFD) duration for the current configuration. The RMARKER, and therefore every
+ * TX and RX timestamp, falls on the first symbol of the PHR, so this is also the offset from the start of 
+ * the frame to the RMARKER. A delayed transmission has to be armed at least this long before the requested RMARKER time.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @return uint32_t Duration in UWB usec.
+ */
+uint32_t 
+dw1000_phy_SHR_duration(struct _dw1000_dev_instance_t * inst)
+{
+    uint16_t nsfd;
+    switch (inst->config.dataRate){
+        case DWT_BR_110K: nsfd = 64; break;
+        case DWT_BR_850K: nsfd = (inst->config.rx.sfdType) ? 16 : 8; break;
+        default: nsfd = 8; break;
+    }
+    uint64_t dtu = (uint64_t)(_dw1000_phy_preamble_length(inst->config.tx.preambleLength) + nsfd) * _dw1000_phy_preamble_symbol(inst);
+    return _dw1000_phy_dtu_to_usec(dtu);
+}
+
+/**
+ * Duration of the PHR and the data portion of a frame, i.e. the time from the RMARKER to the end of the frame. 
+ * The PHR is 21 symbols sent at 850kbps (110kbps for the 110kbps mode). The PSDU carries 48 Reed-Solomon parity bits
+ * for every 330 data bits.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @param nlen  Frame length in bytes, excluding the 2 byte FCS (as passed to dw1000_write_tx_fctrl).
+ * @return uint32_t Duration in UWB usec.
+ */
+uint32_t 
+dw1000_phy_data_duration(struct _dw1000_dev_instance_t * inst, uint16_t nlen)
+{
+    uint32_t nbits = (nlen + 2) * 8;
+    uint32_t nsym = nbits + 48 * ((nbits + 329) / 330);
+    uint64_t dtu = (uint64_t)nsym * _dw1000_phy_data_symbol(inst);
+    dtu += 21 * ((inst->config.dataRate == DWT_BR_110K) ? 0x80000 : 0x10000);
+    return _dw1000_phy_dtu_to_usec(dtu);
+}
+
+/**
+ * Total on-air duration of a frame for the current configuration.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @param nlen  Frame length in bytes, excluding the 2 byte FCS.
+ * @return uint32_t Duration in UWB usec.
+ */
+uint32_t 
+dw1000_phy_frame_duration(struct _dw1000_dev_instance_t * inst, uint16_t nlen)
+{
+    return dw1000_phy_SHR_duration(inst) + dw1000_phy_data_duration(inst, nlen);
+}
+
+/**
+ * Minimum safe delay between the RMARKER of a received frame and the RMARKER of a delayed response. This covers the 
+ * remainder of the inbound frame, the host processing time MYNEWT_VAL(DW1000_TURNAROUND_LATENCY) and the SHR of 
+ * the outbound frame. Use as the floor for tx_holdoff_delay.
+ *
+ * @param inst      Pointer to dw1000_dev_instance_t.
+ * @param rx_nlen   Length of the inbound frame in bytes, excluding the FCS.
+ * @return uint32_t Duration in UWB usec.
+ */
+uint32_t 
+dw1000_phy_turnaround_time(struct _dw1000_dev_instance_t * inst, uint16_t rx_nlen)
+{
+    return dw1000_phy_data_duration(inst, rx_nlen) + MYNEWT_VAL(DW1000_TURNAROUND_LATENCY) + dw1000_phy_SHR_duration(inst);
+}
+
+/**
+ * Receive timeout for a wait4resp exchange. With wait4resp the receiver is enabled at the end of the outbound frame; 
+ * the peer places its RMARKER holdoff after ours and the response completes after its PHR and data.
+ *
+ * @param inst      Pointer to dw1000_dev_instance_t.
+ * @param holdoff   Peer RMARKER to RMARKER holdoff, in UWB usec.
+ * @param tx_nlen   Length of the outbound frame in bytes, excluding the FCS.
+ * @param rx_nlen   Length of the expected response in bytes, excluding the FCS.
+ * @return uint16_t Timeout in UWB usec, saturated to the range of RX_FWTO. 
+ */
+uint16_t 
+dw1000_phy_wait4resp_timeout(struct _dw1000_dev_instance_t * inst, uint32_t holdoff, uint16_t tx_nlen, uint16_t rx_nlen)
+{
+    uint32_t tx_data = dw1000_phy_data_duration(inst, tx_nlen);
+    uint32_t timeout = (holdoff > tx_data) ? holdoff - tx_data : 0;
+    timeout += dw1000_phy_data_duration(inst, rx_nlen) + DW1000_PHY_RX_TIMEOUT_GUARD;
+    return (timeout > 0xFFFF) ? 0xFFFF : timeout;
+}
+
+/**
+ * Turn-around time for a wait4resp exchange that delays the receiver until shortly before the response. The receiver 
+ * is enabled DW1000_PHY_RX_TIMEOUT_GUARD ahead of the response preamble instead of at the end of the outbound frame. 
+ * Timeouts for the delayed receiver are derived by passing holdoff less this delay to dw1000_phy_wait4resp_timeout and 
+ * dw1000_phy_preamble_timeout.
+ *
+ * @param inst      Pointer to dw1000_dev_instance_t.
+ * @param holdoff   Peer RMARKER to RMARKER holdoff, in UWB usec.
+ * @param tx_nlen   Length of the outbound frame in bytes, excluding the FCS.
+ * @return uint32_t Delay in UWB usec, for dw1000_set_wait4resp_delay.
+ */
+uint32_t 
+dw1000_phy_rx_window_delay(struct _dw1000_dev_instance_t * inst, uint32_t holdoff, uint16_t tx_nlen)
+{
+    uint32_t lead = dw1000_phy_data_duration(inst, tx_nlen) + dw1000_phy_SHR_duration(inst) + DW1000_PHY_RX_TIMEOUT_GUARD;
+    uint32_t delay = (holdoff > lead) ? holdoff - lead : 0;
+    return (delay > ACK_RESP_T_W4R_TIM_MASK) ? ACK_RESP_T_W4R_TIM_MASK : delay;
+}
+
+/**
+ * Preamble detection timeout for a wait4resp exchange. The receiver is enabled at the end of the outbound frame and
+ * the response preamble starts one SHR ahead of the peer RMARKER at holdoff. The timeout covers that gap plus 
+ * DW1000_PHY_PRETOC_DETECT PACs of preamble, and one sniff period when sniff mode is enabled.
+ *
+ * @param inst      Pointer to dw1000_dev_instance_t.
+ * @param holdoff   Peer RMARKER to RMARKER holdoff, in UWB usec.
+ * @param tx_nlen   Length of the outbound frame in bytes, excluding the FCS.
+ * @return uint16_t Timeout in units of PAC, for dw1000_set_preamble_timeout.
+ */
+uint16_t 
+dw1000_phy_preamble_timeout(struct _dw1000_dev_instance_t * inst, uint32_t holdoff, uint16_t tx_nlen)
+{
+    uint32_t lead = dw1000_phy_data_duration(inst, tx_nlen) + dw1000_phy_SHR_duration(inst);
+    uint32_t gap = (holdoff > lead) ? holdoff - lead : 0;
+    gap += DW1000_PHY_RX_TIMEOUT_GUARD + dw1000_sniff_period(inst);
+    uint64_t pac = (uint64_t)(8 << inst->config.rx.pacLength) * _dw1000_phy_preamble_symbol(inst);
+    uint64_t npacs = (((uint64_t)gap << 16) + pac - 1) / pac + DW1000_PHY_PRETOC_DETECT;
+    return (npacs > 0xFFFF) ? 0xFFFF : npacs;
+}
@@ -109,6 +109,8 @@ dw1000_provision_init(dw1000_dev_instance_t * inst, dw1000_provision_config_t co
     provision_cbs.rx_error_cb = provision_rx_error_cb;
     provision_cbs.tx_error_cb = provision_tx_error_cb;
     dw1000_provision_set_ext_callbacks(inst, provision_cbs);
+    // Provisioning frames use a reserved frame type, responders must hear requests until provisioning is stopped
+    dw1000_mac_framefilter_window(inst, DW1000_PROVISION, true);
 
     provision->status.provision_status = PROVISION_INVALID;
     os_error_t err = os_sem_init(&inst->provision->sem, 0x1);
@@ -130,6 +132,7 @@ dw1000_provision_free(dw1000_dev_instance_t * inst){
     assert(inst != NULL);
     assert(inst->provision != NULL);
     dw1000_remove_extension_callbacks(inst, DW1000_PROVISION);
+    dw1000_mac_framefilter_window(inst, DW1000_PROVISION, false);
     if (inst->provision->status.selfmalloc){
         if(inst->provision->dev_addr != NULL){
             free(inst->provision->dev_addr);
@@ -219,8 +222,8 @@ provision_rx_complete_cb(dw1000_dev_instance_t* inst){
     dw1000_provision_config_t config = provision->config;
 
     if (inst->fctrl == FCNTL_IEEE_PROVISION_16){
-        dw1000_read_rx(inst, (uint8_t *) &code, offsetof(ieee_rng_request_frame_t,code), sizeof(uint16_t));
-        dw1000_read_rx(inst, (uint8_t *) &dst_address, offsetof(ieee_rng_request_frame_t,dst_address), sizeof(uint16_t));
+        memcpy(&code, &inst->cb_data.header[offsetof(ieee_rng_request_frame_t,code)], sizeof(uint16_t));
+        memcpy(&dst_address, &inst->cb_data.header[offsetof(ieee_rng_request_frame_t,dst_address)], sizeof(uint16_t));
     }else{
         return;
     }
@@ -235,7 +238,7 @@ provision_rx_complete_cb(dw1000_dev_instance_t* inst){
         case DWT_PROVISION_START:
             {
                 if (inst->frame_len >= sizeof(ieee_rng_request_frame_t))
-                    dw1000_read_rx(inst, frame->array, 0, sizeof(ieee_rng_request_frame_t));
+                    dw1000_read_rx_frame(inst, frame->array, sizeof(ieee_rng_request_frame_t));
                 else{
                     if (dw1000_restart_rx(inst, inst->control).start_rx_error)
                         inst->rng_rx_error_cb(inst);
@@ -244,8 +247,11 @@ provision_rx_complete_cb(dw1000_dev_instance_t* inst){
                 uint8_t delay_factor = 1;  //Delay_factor for NODE_0
                 if(inst->slot_id > 0) // if device is of NODE type
                    delay_factor = (inst->slot_id) * 4;  //Increase the delay factor for late response for Anchor provisioning
-                uint64_t request_timestamp = dw1000_read_rxtime(inst);
-                uint64_t response_tx_delay = request_timestamp + ((uint64_t)(config.tx_holdoff_delay*delay_factor) << 16);
+                uint32_t holdoff = dw1000_phy_turnaround_time(inst, sizeof(ieee_rng_request_frame_t));
+                if (config.tx_holdoff_delay > holdoff)
+                    holdoff = config.tx_holdoff_delay;
+                uint64_t request_timestamp = inst->cb_data.rx_timestamp;
+                uint64_t response_tx_delay = request_timestamp + ((uint64_t)(holdoff*delay_factor) << 16);
                 frame->dst_address = frame->src_address;
                 frame->src_address = inst->my_short_address;
                 frame->code = DWT_PROVISION_RESP;
@@ -263,7 +269,7 @@ provision_rx_complete_cb(dw1000_dev_instance_t* inst){
         case DWT_PROVISION_RESP:
             {
                 if (inst->frame_len >= sizeof(ieee_rng_response_frame_t))
-                    dw1000_read_rx(inst, frame->array, 0, sizeof(ieee_rng_response_frame_t));
+                    dw1000_read_rx_frame(inst, frame->array, sizeof(ieee_rng_response_frame_t));
                 else{
                     if (dw1000_restart_rx(inst,inst->control).start_rx_error)
                         inst->rng_rx_error_cb(inst);
@@ -411,7 +417,16 @@ dw1000_provision_request(dw1000_dev_instance_t * inst, dw1000_dev_modes_t mode){
     dw1000_write_tx(inst, frame->array, 0, sizeof(ieee_rng_response_frame_t));
     dw1000_write_tx_fctrl(inst, sizeof(ieee_rng_response_frame_t), 0, true);
     dw1000_set_wait4resp(inst, true);
-    dw1000_set_rx_timeout(inst, provision->config.rx_timeout_period);
+    uint32_t holdoff = dw1000_phy_turnaround_time(inst, sizeof(ieee_rng_request_frame_t));
+    if (provision->config.tx_holdoff_delay > holdoff)
+        holdoff = provision->config.tx_holdoff_delay;
+    // Responders reply in slots of 4 * slot_id holdoffs, size the window for the last slot
+    if (provision->config.max_node_count > 1)
+        holdoff *= 4 * provision->config.max_node_count;
+    uint16_t timeout = dw1000_phy_wait4resp_timeout(inst, holdoff, sizeof(ieee_rng_response_frame_t), sizeof(ieee_rng_response_frame_t));
+    dw1000_set_rx_timeout(inst, (provision->config.rx_timeout_period > timeout) ? provision->config.rx_timeout_period : timeout);
+    if (provision->config.rx_timeout_period < timeout)
+        dw1000_set_preamble_timeout(inst, dw1000_phy_preamble_timeout(inst, holdoff, sizeof(ieee_rng_response_frame_t)));
     provision->status.start_tx_error = dw1000_start_tx(inst).start_tx_error;
     if (provision->status.start_tx_error){
         os_sem_release(&inst->provision->sem);
@@ -439,11 +454,13 @@ dw1000_provision_start(dw1000_dev_instance_t * inst){
     dw1000_provision_instance_t * provision = inst->provision;
     provision->idx = 0x0;
     provision->status.valid = true;
+    dw1000_mac_framefilter_window(inst, DW1000_PROVISION, true);
     provision_timer_init(inst);
 }
 
 /**
- * This function stops the provision process.
+ * This function stops the provision process and closes the frame filter window, provisioning frames are dropped
+ * again until the next dw1000_provision_start().
  *
  * @param inst    Pointer to dw1000_dev_instance_t.
  * @return void
@@ -454,6 +471,7 @@ dw1000_provision_stop(dw1000_dev_instance_t * inst){
     assert(inst->provision != NULL);
     inst->provision->status.valid = false;
     os_callout_stop(&inst->provision->provision_callout_timer);
+    dw1000_mac_framefilter_window(inst, DW1000_PROVISION, false);
 }
 
 /**
@@ -25,12 +25,16 @@
  * @date 2018
  * @brief Regulatory file
  *
- * @details This is the regulatory base class which includes header files.
+ * @details This is the regulatory engine. Energy is accounted in microseconds of airtime at the configured TX power,
+ * scaled by the linear gain of the power step used, in Q8. The millisecond and second windows are fixed windows on
+ * the CPU time base, started by the first frame admitted after the previous window expired. Admission runs in
+ * _dw1000_start_tx with inst->sem held, the cost is a few table lookups and at most one TX_POWER write.
  */
 
 #include <stdio.h>
 #include <string.h>
 #include <assert.h>
+#include <math.h>
 #include <os/os.h>
 #include <hal/hal_spi.h>
 #include <hal/hal_gpio.h>
@@ -38,5 +42,247 @@
 #include <dw1000/dw1000_regs.h>
 #include <dw1000/dw1000_dev.h>
 #include <dw1000/dw1000_hal.h>
-#include <dw1000/dw1000_rng.h>
+#include <dw1000/dw1000_phy.h>
+#include <dw1000/dw1000_regulatory.h>
+#if MYNEWT_VAL(DW1000_DRIFT)
+#include <dw1000/dw1000_drift.h>
+#endif
+
+#if MYNEWT_VAL(DW1000_REGULATORY)
+
+#define DW1000_REGULATORY_FINE_MASK (0x1F)  //!< Fine gain field of each TX power byte
+
+//! Region limits, indexed by dw1000_regulatory_region_t
+static const dw1000_regulatory_limits_t regulatory_limits[DW1000_REGION_MAX] = {
+    [DW1000_REGION_NONE] = { .eirp_max = 0, .channel_mask = 0xBE, .ldc_channel_mask = 0, .ldc_ms_per_s = 0 },
+    [DW1000_REGION_FCC] = { .eirp_max = -10573, .channel_mask = 0xBE, .ldc_channel_mask = 0, .ldc_ms_per_s = 0 },
+    [DW1000_REGION_ETSI] = { .eirp_max = -10573, .channel_mask = 0xBE, .ldc_channel_mask = 0x1E, .ldc_ms_per_s = 50 },
+};
+
+//! Linear power gain of steps DW1000_REGULATORY_STEP_MIN to DW1000_REGULATORY_STEP_MAX, 10^(step/20) in Q8
+static const uint16_t regulatory_gain_q8[DW1000_REGULATORY_STEP_MAX - DW1000_REGULATORY_STEP_MIN + 1] = {
+    64, 72, 81, 91, 102, 114, 128, 144, 162, 181, 203, 228, 256, 287, 322, 362,
+    406, 455, 511, 573, 643, 722, 810, 908, 1019, 1144, 1283, 1440, 1615, 1812, 2033
+};
+
+/**
+ * Allocate resources for the regulatory engine and turn hardware smart TX power off, the engine sets the power of
+ * every frame itself. The TX power configured at this point is taken as the reference of config.eirp_ref.
+ *
+ * @param inst    Pointer to dw1000_dev_instance_t.
+ * @param config  Regulatory configuration.
+ * @return dw1000_regulatory_instance_t
+ */
+dw1000_regulatory_instance_t *
+dw1000_regulatory_init(dw1000_dev_instance_t * inst, dw1000_regulatory_config_t config){
+    assert(inst);
+
+    if (inst->regulatory == NULL ){
+        inst->regulatory = (dw1000_regulatory_instance_t *) malloc(sizeof(dw1000_regulatory_instance_t));
+        assert(inst->regulatory);
+        memset(inst->regulatory, 0, sizeof(dw1000_regulatory_instance_t));
+        inst->regulatory->status.selfmalloc = 1;
+    }
+    dw1000_regulatory_instance_t * regulatory = inst->regulatory;
+    regulatory->parent = inst;
+
+    os_error_t err = os_sem_pend(&inst->sem, OS_TIMEOUT_NEVER);
+    assert(err == OS_OK);
+    regulatory->base_power = regulatory->power = (uint32_t) dw1000_read_reg(inst, TX_POWER_ID, 0, sizeof(uint32_t));
+    inst->sys_cfg_reg |= SYS_CFG_DIS_STXP;
+    dw1000_write_reg(inst, SYS_CFG_ID, 0, inst->sys_cfg_reg, sizeof(uint32_t));
+    err = os_sem_release(&inst->sem);
+    assert(err == OS_OK);
+
+    dw1000_regulatory_config(inst, config);
+    regulatory->status.initialized = 1;
+    return regulatory;
+}
+
+/**
+ * Free resources. The configured TX power is restored and hardware smart TX power turned back on.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @return void
+ */
+void
+dw1000_regulatory_free(dw1000_dev_instance_t * inst){
+    assert(inst != NULL);
+    assert(inst->regulatory != NULL);
+    dw1000_regulatory_instance_t * regulatory = inst->regulatory;
+
+    os_error_t err = os_sem_pend(&inst->sem, OS_TIMEOUT_NEVER);
+    assert(err == OS_OK);
+    dw1000_write_reg(inst, TX_POWER_ID, 0, regulatory->base_power, sizeof(uint32_t));
+    inst->sys_cfg_reg &= ~SYS_CFG_DIS_STXP;
+    dw1000_write_reg(inst, SYS_CFG_ID, 0, inst->sys_cfg_reg, sizeof(uint32_t));
+    err = os_sem_release(&inst->sem);
+    assert(err == OS_OK);
+
+    if (regulatory->status.selfmalloc){
+        free(regulatory);
+        inst->regulatory = NULL;
+    }
+    else
+        regulatory->status.initialized = 0;
+}
+
+/**
+ * Change region or calibration. The energy budget is derived here, in floating point, so that admission is integer
+ * only.
+ *
+ * @param inst    Pointer to dw1000_dev_instance_t.
+ * @param config  Regulatory configuration.
+ * @return void
+ */
+void
+dw1000_regulatory_config(dw1000_dev_instance_t * inst, dw1000_regulatory_config_t config){
+    assert(inst->regulatory);
+    assert(config.region < DW1000_REGION_MAX);
+    dw1000_regulatory_instance_t * regulatory = inst->regulatory;
+
+    if (config.step_max > DW1000_REGULATORY_STEP_MAX)
+        config.step_max = DW1000_REGULATORY_STEP_MAX;
+    regulatory->config = config;
+    regulatory->limits = regulatory_limits[config.region];
+    float budget = 1000.0f * 256.0f * powf(10.0f, (regulatory->limits.eirp_max - config.eirp_ref) / 2560.0f);
+    regulatory->budget_ms = (budget > UINT32_MAX / 4) ? UINT32_MAX / 4 : (uint32_t) budget;
+    regulatory->energy_ms = regulatory->energy_s = regulatory->airtime_s = 0;
+}
+
+/**
+ * Apply a power step to each byte of the configured TX power register, moving the fine gain and saturating at the
+ * ends of its range. A drift compensation step, when running, is added.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @param step  Power step, 0.5 dB.
+ * @return uint32_t TX power register
+ */
+static uint32_t
+regulatory_power(dw1000_dev_instance_t * inst, int8_t step){
+    dw1000_regulatory_instance_t * regulatory = inst->regulatory;
+#if MYNEWT_VAL(DW1000_DRIFT)
+    if (inst->drift != NULL && inst->drift->status.started)
+        step += inst->drift->txpwr_step;
+#endif
+    uint32_t power = 0;
+    for (uint8_t i = 0; i < sizeof(uint32_t); i++){
+        uint8_t level = (regulatory->base_power >> (8 * i)) & 0xFF;
+        int16_t fine = (level & DW1000_REGULATORY_FINE_MASK) + step;
+        fine = (fine < 0) ? 0 : (fine > DW1000_REGULATORY_FINE_MASK) ? DW1000_REGULATORY_FINE_MASK : fine;
+        power |= (uint32_t)((level & ~DW1000_REGULATORY_FINE_MASK) | fine) << (8 * i);
+    }
+    return power;
+}
+
+/**
+ * Check a frame of nlen bytes against the low duty cycle rule and pick the highest power step whose energy fits both
+ * the millisecond and the second budget. The frame is accounted for as sent when a step is found.
+ *
+ * @param inst     Pointer to dw1000_dev_instance_t.
+ * @param nlen     Frame length, excluding the FCS.
+ * @param channel  Channel bit of the current channel.
+ * @param step     Power step chosen, 0.5 dB.
+ * @return true when the frame fits the budgets
+ */
+static bool
+regulatory_budget(dw1000_dev_instance_t * inst, uint16_t nlen, uint8_t channel, int8_t * step){
+    dw1000_regulatory_instance_t * regulatory = inst->regulatory;
+    const dw1000_regulatory_limits_t * limits = &regulatory->limits;
+
+    uint32_t now = os_cputime_ticks_to_usecs(os_cputime_get32());
+    if (now - regulatory->ms_start >= 1000){
+        regulatory->ms_start = now;
+        regulatory->energy_ms = 0;
+    }
+    if (now - regulatory->s_start >= 1000000){
+        regulatory->s_start = now;
+        regulatory->energy_s = 0;
+        regulatory->airtime_s = 0;
+    }
+
+    uint32_t airtime = dw1000_phy_frame_duration(inst, nlen);
+    if ((limits->ldc_channel_mask & channel) && regulatory->airtime_s + airtime > limits->ldc_ms_per_s * 1000){
+        regulatory->stats.denied_duty++;
+        return false;
+    }
+
+    // A frame longer than the window cannot raise the mean over any millisecond above its own density
+    uint32_t airtime_ms = (airtime > 1000) ? 1000 : airtime;
+    for (int8_t i = regulatory->config.step_max; i >= DW1000_REGULATORY_STEP_MIN; i--){
+        uint16_t gain = regulatory_gain_q8[i - DW1000_REGULATORY_STEP_MIN];
+        if (regulatory->energy_ms + airtime_ms * gain <= regulatory->budget_ms
+            && regulatory->energy_s + airtime * gain <= (uint64_t) regulatory->budget_ms * 1000){
+            regulatory->charge_ms = airtime_ms * gain;
+            regulatory->charge_s = airtime * gain;
+            regulatory->charge_airtime = airtime;
+            regulatory->energy_ms += regulatory->charge_ms;
+            regulatory->energy_s += regulatory->charge_s;
+            regulatory->airtime_s += airtime;
+            *step = i;
+            return true;
+        }
+    }
+    regulatory->stats.denied_energy++;
+    return false;
+}
+
+/**
+ * Admit a frame of nlen bytes for transmission. The channel rule is checked first, then the budgets of the region;
+ * the power step chosen is written to TX_POWER when it differs from the frame before.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @param nlen  Frame length, excluding the FCS.
+ * @return true when the frame may be sent
+ */
+bool
+dw1000_regulatory_admit(dw1000_dev_instance_t * inst, uint16_t nlen){
+    dw1000_regulatory_instance_t * regulatory = inst->regulatory;
+    uint8_t channel = 1 << inst->config.channel;
+    int8_t step = 0;
+
+    if (!(regulatory->limits.channel_mask & channel)){
+        regulatory->stats.denied_channel++;
+        return false;
+    }
+    regulatory->charge_ms = regulatory->charge_s = regulatory->charge_airtime = 0;
+    if (regulatory->config.region != DW1000_REGION_NONE && !regulatory_budget(inst, nlen, channel, &step))
+        return false;
+
+    uint32_t power = regulatory_power(inst, step);
+    if (power != regulatory->power){
+        regulatory->power = power;
+        dw1000_write_reg(inst, TX_POWER_ID, 0, power, sizeof(uint32_t));
+    }
+    regulatory->step = step;
+    regulatory->stats.admitted++;
+    if (step > 0)
+        regulatory->stats.boosted++;
+    else if (step < 0)
+        regulatory->stats.derated++;
+    return true;
+}
+
+/**
+ * Give back the energy and airtime charged by the last dw1000_regulatory_admit, for a frame that was admitted but
+ * never went on air, a delayed transmit aborted on HPDWARN or TXPUTE. Called from _dw1000_start_tx with inst->sem
+ * still held, so no other frame has been charged and the windows have not moved since.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @return void
+ */
+void
+dw1000_regulatory_refund(dw1000_dev_instance_t * inst){
+    dw1000_regulatory_instance_t * regulatory = inst->regulatory;
+
+    // dw1000_regulatory_config may have emptied the windows in the meantime
+    regulatory->energy_ms = (regulatory->energy_ms > regulatory->charge_ms) ? regulatory->energy_ms - regulatory->charge_ms : 0;
+    regulatory->energy_s = (regulatory->energy_s > regulatory->charge_s) ? regulatory->energy_s - regulatory->charge_s : 0;
+    regulatory->airtime_s = (regulatory->airtime_s > regulatory->charge_airtime)
+                          ? regulatory->airtime_s - regulatory->charge_airtime : 0;
+    regulatory->charge_ms = regulatory->charge_s = regulatory->charge_airtime = 0;
+    regulatory->stats.refunded++;
+}
+
+#endif /* DW1000_REGULATORY */
 
@@ -53,6 +53,9 @@
 #endif
 
 #include <dsp/polyval.h>
+#if MYNEWT_VAL(DW1000_DSP_FIXEDPOINT)
+#include <dw1000/dw1000_dsp.h>
+#endif
 
 
 /*
@@ -71,12 +74,43 @@ static float rng_bias_poly_PRF64[] ={
 static float rng_bias_poly_PRF16[] ={
      	1.754924e-05, 4.106182e-03, 3.061584e-01, 7.189425e+00, 
      	};
+#if MYNEWT_VAL(DW1000_DSP_FIXEDPOINT)
+/*
+% Fixed point, in u = (Pr - RNG_BIAS_PR_CENTRE) / RNG_BIAS_PR_SCALE
+u = linspace(-1,1,65);
+p=polyfit(u,polyval(rng_bias_poly_PRF64,RNG_BIAS_PR_CENTRE + RNG_BIAS_PR_SCALE * u),3)
+mat2c(p,'rng_bias_poly_PRF64_q16')
+p=polyfit(u,polyval(rng_bias_poly_PRF16,RNG_BIAS_PR_CENTRE + RNG_BIAS_PR_SCALE * u),3)
+mat2c(p,'rng_bias_poly_PRF16_q16')
+% Printed to 10 significant digits, at 7 the PRF64 terms alone are off by up to 5e-5 m
+*/
+#define RNG_BIAS_PR_CENTRE  (-77)       //!< Middle of the received power range of the fit, dBm
+#define RNG_BIAS_PR_SCALE   (64)        //!< Half width of the received power range of the fixed point polynomials, dB
+#define RNG_DB_PER_LOG2_Q14 (98642)     //!< 20 * log10(2) in Q14
+static const int32_t rng_bias_poly_PRF64_q16[] ={
+     	DW1000_Q(3.681749565e+02, 16), DW1000_Q(-1.468889498e+01, 16), DW1000_Q(-5.989930163e+01, 16), DW1000_Q(-8.267755080e-01, 16), 
+     	};
+static const int32_t rng_bias_poly_PRF16_q16[] ={
+     	DW1000_Q(4.600427971e+00, 16), DW1000_Q(2.142517658e-01, 16), DW1000_Q(-8.988989517e-01, 16), DW1000_Q(-5.102590692e-02, 16), 
+     	};
+#endif
 
 static void rng_tx_complete_cb(dw1000_dev_instance_t * inst);
 static void rng_rx_complete_cb(dw1000_dev_instance_t * inst);
 static void rng_rx_timeout_cb(dw1000_dev_instance_t * inst);
 static void rng_rx_error_cb(dw1000_dev_instance_t * inst);
 static void rng_tx_final_cb(dw1000_dev_instance_t * inst);
+static uint32_t rng_tx_holdoff(dw1000_dev_instance_t * inst, uint16_t rx_nlen);
+static uint16_t rng_rx_timeout(dw1000_dev_instance_t * inst, uint16_t tx_nlen, uint16_t rx_nlen);
+static dw1000_dev_status_t rng_start_tx(dw1000_dev_instance_t * inst, twr_frame_t * frame, uint16_t tx_nlen, uint64_t tx_delay, uint16_t rx_nlen);
+#if MYNEWT_VAL(DW1000_RNG_PAYLOAD_LEN) > 0
+static void rng_payload_deliver(dw1000_dev_instance_t * inst, uint16_t code);
+#endif
+#if MYNEWT_VAL(DW1000_RNG_DOWNLINK_SLOTS) > 0
+static dw1000_rng_downlink_t * rng_downlink_peek(dw1000_rng_instance_t * rng, uint16_t dst_address);
+static void rng_downlink_start(dw1000_dev_instance_t * inst, uint64_t rmarker, uint16_t nlen);
+static void rng_downlink_wait(dw1000_dev_instance_t * inst, uint16_t nlen);
+#endif
 
 /**
  * This call initializes the ranging by setting all the required configurations and callbacks.
@@ -114,6 +148,13 @@ dw1000_rng_init(dw1000_dev_instance_t * inst, dw1000_rng_config_t * config, uint
         .delay_start_enabled = 0,
     };
     inst->rng->idx = 0xFFFF;
+#if MYNEWT_VAL(DW1000_DSP_FIXEDPOINT)
+    inst->rng->pr_1m_q8 = (int16_t) roundf(256 * dw1000_rng_path_loss(
+                        MYNEWT_VAL(DW1000_DEVICE_TX_PWR),
+                        MYNEWT_VAL(DW1000_DEVICE_ANT_GAIN),
+                        MYNEWT_VAL(DW1000_DEVICE_FREQ),
+                        1.0f));
+#endif
     inst->rng->status.initialized = 1;
     return inst->rng;
 }
@@ -184,6 +225,301 @@ dw1000_rng_config(dw1000_dev_instance_t * inst, dw1000_rng_config_t * config){
     return inst->status;
 }
 
+/**
+ * Response holdoff for a frame of length rx_nlen. The configured tx_holdoff_delay is used unless it is shorter 
+ * than the PHY allows for the current configuration, a value of zero selects the PHY minimum.
+ *
+ * @param inst      Pointer to dw1000_dev_instance_t.
+ * @param rx_nlen   Length of the frame being responded to, excluding the FCS.
+ * @return uint32_t Holdoff in UWB usec.
+ */
+static uint32_t 
+rng_tx_holdoff(dw1000_dev_instance_t * inst, uint16_t rx_nlen){
+    uint32_t holdoff = dw1000_phy_turnaround_time(inst, rx_nlen);
+    return (inst->rng->config->tx_holdoff_delay > holdoff) ? inst->rng->config->tx_holdoff_delay : holdoff;
+}
+
+/**
+ * Receive timeout after sending a frame of length tx_nlen and expecting a response of length rx_nlen, assuming 
+ * the peer applies rng_tx_holdoff. The configured rx_timeout_period is used if it is longer.
+ *
+ * @param inst      Pointer to dw1000_dev_instance_t.
+ * @param tx_nlen   Length of the outbound frame, excluding the FCS.
+ * @param rx_nlen   Length of the expected response, excluding the FCS.
+ * @return uint16_t Timeout in UWB usec.
+ */
+static uint16_t 
+rng_rx_timeout(dw1000_dev_instance_t * inst, uint16_t tx_nlen, uint16_t rx_nlen){
+    uint16_t timeout = dw1000_phy_wait4resp_timeout(inst, rng_tx_holdoff(inst, tx_nlen), tx_nlen, rx_nlen);
+    return (inst->rng->config->rx_timeout_period > timeout) ? inst->rng->config->rx_timeout_period : timeout;
+}
+
+/**
+ * Transmit a ranging frame as a single radio command. With rx_nlen set the receiver is held off until shortly before 
+ * the expected response preamble and the frame wait and preamble detection timeouts count from there, so that a 
+ * missing response aborts a few PACs after its expected preamble. A longer configured rx_timeout_period keeps the 
+ * receiver on from the end of the outbound frame and disables the preamble timeout.
+ *
+ * @param inst      Pointer to dw1000_dev_instance_t.
+ * @param frame     Frame to transmit.
+ * @param tx_nlen   Length of the outbound frame, excluding the FCS.
+ * @param tx_delay  Delayed transmit time, 0 to transmit immediately.
+ * @param rx_nlen   Length of the expected response, excluding the FCS; 0 when no response is expected.
+ * @return dw1000_dev_status_t
+ */
+static dw1000_dev_status_t 
+rng_start_tx(dw1000_dev_instance_t * inst, twr_frame_t * frame, uint16_t tx_nlen, uint64_t tx_delay, uint16_t rx_nlen){
+    dw1000_rng_instance_t * rng = inst->rng;
+    uint8_t * payload = frame->array;
+#if MYNEWT_VAL(DW1000_RNG_DOWNLINK_SLOTS) > 0
+    // Flag queued downlink data for the peer, frames copied from an inbound frame may still carry the peer's flag
+    rng->downlink_dst = frame->dst_address;
+    rng->status.downlink_promised = rng_downlink_peek(rng, frame->dst_address) != NULL;
+    frame->fctrl = (rng->status.downlink_promised) ? (FCNTL_IEEE_RANGE_16 | MAC_FCTRL_FRAME_PENDING) : FCNTL_IEEE_RANGE_16;
+#endif
+#if MYNEWT_VAL(DW1000_RNG_PAYLOAD_LEN) > 0
+    // The application payload follows the fixed part of the frame, the response may carry the peer's
+    if (rng->payload_len){
+        dw1000_write_tx(inst, rng->payload, tx_nlen, rng->payload_len);
+        dw1000_write_tx(inst, frame->array, 0, tx_nlen);
+        payload = NULL;
+        tx_nlen += rng->payload_len;
+    }
+    if (rx_nlen)
+        rx_nlen += MYNEWT_VAL(DW1000_RNG_PAYLOAD_LEN);
+#endif
+    rng->frame_len = tx_nlen;
+    dw1000_mac_cmd_t cmd = {
+        .payload = payload,
+        .frame_len = tx_nlen,
+        .ranging = true,
+        .delay = tx_delay,
+        .wait4resp = rx_nlen > 0
+    };
+    if (cmd.wait4resp){
+        uint16_t timeout = rng_rx_timeout(inst, tx_nlen, rx_nlen);
+        // A longer configured timeout means the peer is expected to answer late, leave the receiver open
+        if (inst->rng->config->rx_timeout_period < timeout){
+            uint32_t holdoff = rng_tx_holdoff(inst, tx_nlen);
+            cmd.wait4resp_delay = dw1000_phy_rx_window_delay(inst, holdoff, tx_nlen);
+            cmd.rx_timeout = dw1000_phy_wait4resp_timeout(inst, holdoff - cmd.wait4resp_delay, tx_nlen, rx_nlen);
+            cmd.preamble_timeout = dw1000_phy_preamble_timeout(inst, holdoff - cmd.wait4resp_delay, tx_nlen);
+        }else
+            cmd.rx_timeout = timeout;
+    }
+    return dw1000_start_tx_cmd(inst, &cmd);
+}
+
+#if MYNEWT_VAL(DW1000_RNG_PAYLOAD_LEN) > 0
+/**
+ * Attach an application payload to the ranging frames sent by this device, requests, responses and finals alike, 
+ * until it is replaced or detached. The peer receives it through the callback set with dw1000_rng_set_payload_cb, 
+ * so telemetry such as battery or sensor state travels with the exchange instead of in frames of its own. Each 
+ * byte lengthens the frame airtime, the response holdoffs and timeouts account for it.
+ *
+ * @param inst      Pointer to dw1000_dev_instance_t.
+ * @param payload   Payload, copied.
+ * @param len       Payload length, up to DW1000_RNG_PAYLOAD_LEN; 0 to detach.
+ * @return dw1000_rng_status_t, payload_overflow is set if the payload was not attached.
+ */
+dw1000_rng_status_t 
+dw1000_rng_set_payload(dw1000_dev_instance_t * inst, const uint8_t * payload, uint16_t len){
+    dw1000_rng_instance_t * rng = inst->rng;
+
+    rng->status.payload_overflow = len > MYNEWT_VAL(DW1000_RNG_PAYLOAD_LEN);
+    if (rng->status.payload_overflow)
+        return rng->status;
+
+    os_sr_t sr;
+    OS_ENTER_CRITICAL(sr);  // Frames are built in the interrupt task
+    memcpy(rng->payload, payload, len);
+    rng->payload_len = len;
+    OS_EXIT_CRITICAL(sr);
+    return rng->status;
+}
+
+/**
+ * Hand the application payload trailing a received ranging frame to the payload callback. This runs after any 
+ * response has been committed, the payload read does not add to the turnaround.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @param code  Ranging code of the frame.
+ * @return void
+ */
+static void 
+rng_payload_deliver(dw1000_dev_instance_t * inst, uint16_t code){
+    dw1000_rng_instance_t * rng = inst->rng;
+    uint16_t nlen;
+
+    switch(code){
+        case DWT_SS_TWR:
+        case DWT_DS_TWR:
+        case DWT_DS_TWR_EXT:
+            nlen = sizeof(ieee_rng_request_frame_t);
+            break;
+        case DWT_SS_TWR_T1:
+        case DWT_DS_TWR_T1:
+        case DWT_DS_TWR_EXT_T1:
+            nlen = sizeof(ieee_rng_response_frame_t);
+            break;
+        case DWT_SS_TWR_FINAL:
+        case DWT_DS_TWR_T2:
+        case DWT_DS_TWR_FINAL:
+            nlen = sizeof(twr_frame_final_t);
+            break;
+        case DWT_DS_TWR_EXT_T2:
+        case DWT_DS_TWR_EXT_FINAL:
+            nlen = sizeof(twr_frame_t);
+            break;
+        default:
+            return;
+    }
+    if (rng->payload_cb == NULL || inst->frame_len <= nlen || inst->frame_len - nlen > MYNEWT_VAL(DW1000_RNG_PAYLOAD_LEN))
+        return;
+
+    uint8_t payload[MYNEWT_VAL(DW1000_RNG_PAYLOAD_LEN)];
+    uint16_t src_address;
+    memcpy(&src_address, &inst->cb_data.header[offsetof(ieee_rng_request_frame_t,src_address)], sizeof(uint16_t));
+    dw1000_read_rx(inst, payload, nlen, inst->frame_len - nlen);
+    rng->payload_cb(inst, src_address, code, payload, inst->frame_len - nlen);
+}
+#endif
+
+#if MYNEWT_VAL(DW1000_RNG_DOWNLINK_SLOTS) > 0
+/**
+ * Queue a downlink payload for a tag. The payload is delivered right after the next ranging exchange the tag 
+ * initiates with this device; responses to that tag carry the frame pending bit while data is queued, so the tag 
+ * only opens its receiver for the payload when there is one. Delivery latency is thus bounded by the tag's 
+ * ranging rate, payloads for the same tag are delivered in order, one per exchange, on a best effort basis.
+ *
+ * @param inst          Pointer to dw1000_dev_instance_t.
+ * @param dst_address   Short address of the tag.
+ * @param payload       Payload, copied into the queue.
+ * @param len           Payload length, up to DW1000_RNG_DOWNLINK_LEN.
+ * @return dw1000_rng_status_t, downlink_overflow is set if the payload was not queued.
+ */
+dw1000_rng_status_t 
+dw1000_rng_downlink_write(dw1000_dev_instance_t * inst, uint16_t dst_address, const uint8_t * payload, uint16_t len){
+    dw1000_rng_instance_t * rng = inst->rng;
+    dw1000_rng_downlink_t * slot = NULL;
+
+    if (len == 0 || len > MYNEWT_VAL(DW1000_RNG_DOWNLINK_LEN)){
+        rng->status.downlink_overflow = 1;
+        return rng->status;
+    }
+
+    os_sr_t sr;
+    OS_ENTER_CRITICAL(sr);  // The queue is drained from the interrupt task
+    for (uint16_t i = 0; i < MYNEWT_VAL(DW1000_RNG_DOWNLINK_SLOTS); i++)
+        if (rng->downlink[i].len == 0){
+            slot = &rng->downlink[i];
+            slot->dst_address = dst_address;
+            slot->order = rng->downlink_order++;
+            memcpy(slot->payload, payload, len);
+            slot->len = len;
+            break;
+        }
+    OS_EXIT_CRITICAL(sr);
+
+    rng->status.downlink_overflow = (slot == NULL);
+    return rng->status;
+}
+
+/**
+ * Number of downlink payloads queued for a tag.
+ *
+ * @param inst          Pointer to dw1000_dev_instance_t.
+ * @param dst_address   Short address of the tag.
+ * @return uint16_t
+ */
+uint16_t 
+dw1000_rng_downlink_pending(dw1000_dev_instance_t * inst, uint16_t dst_address){
+    uint16_t n = 0;
+    for (uint16_t i = 0; i < MYNEWT_VAL(DW1000_RNG_DOWNLINK_SLOTS); i++)
+        if (inst->rng->downlink[i].len && inst->rng->downlink[i].dst_address == dst_address)
+            n++;
+    return n;
+}
+
+/**
+ * Oldest downlink payload queued for a tag.
+ *
+ * @param rng           Pointer to dw1000_rng_instance_t.
+ * @param dst_address   Short address of the tag.
+ * @return Queue slot, NULL if nothing is queued.
+ */
+static dw1000_rng_downlink_t * 
+rng_downlink_peek(dw1000_rng_instance_t * rng, uint16_t dst_address){
+    dw1000_rng_downlink_t * oldest = NULL;
+    for (uint16_t i = 0; i < MYNEWT_VAL(DW1000_RNG_DOWNLINK_SLOTS); i++){
+        dw1000_rng_downlink_t * slot = &rng->downlink[i];
+        if (slot->len && slot->dst_address == dst_address && (oldest == NULL || (int16_t)(slot->order - oldest->order) < 0))
+            oldest = slot;
+    }
+    return oldest;
+}
+
+/**
+ * Anchor side, send the downlink payload promised by the last response. The frame is sent one response holdoff after 
+ * the last frame of the exchange, which is where the tag expects it, see rng_downlink_wait. The slot is released 
+ * once the transmission is committed.
+ *
+ * @param inst      Pointer to dw1000_dev_instance_t.
+ * @param rmarker   RMARKER of the last frame of the exchange.
+ * @param nlen      Length of the last frame of the exchange, excluding the FCS.
+ * @return void
+ */
+static void 
+rng_downlink_start(dw1000_dev_instance_t * inst, uint64_t rmarker, uint16_t nlen){
+    dw1000_rng_instance_t * rng = inst->rng;
+    if (!rng->status.downlink_promised)
+        return;
+    rng->status.downlink_promised = 0;
+
+    dw1000_rng_downlink_t * slot = rng_downlink_peek(rng, rng->downlink_dst);
+    if (slot == NULL)
+        return;
+
+    ieee_rng_request_frame_t * frame = &rng->downlink_frame;
+    frame->fctrl = (dw1000_rng_downlink_pending(inst, slot->dst_address) > 1) ? (FCNTL_IEEE_RANGE_16 | MAC_FCTRL_FRAME_PENDING) : FCNTL_IEEE_RANGE_16;
+    frame->seq_num = ++rng->downlink_seq;
+    frame->PANID = inst->PANID;
+    frame->dst_address = slot->dst_address;
+    frame->src_address = inst->my_short_address;
+    frame->code = DWT_RNG_DOWNLINK;
+
+    // Payload first, dw1000_write_tx reports the frame control of the last write
+    dw1000_write_tx(inst, slot->payload, sizeof(ieee_rng_request_frame_t), slot->len);
+    dw1000_write_tx(inst, frame->array, 0, sizeof(ieee_rng_request_frame_t));
+    dw1000_mac_cmd_t cmd = {
+        .payload = NULL,
+        .frame_len = sizeof(ieee_rng_request_frame_t) + slot->len,
+        .ranging = true,
+        .delay = rmarker + ((uint64_t)rng_tx_holdoff(inst, nlen) << 16)
+    };
+    if (dw1000_start_tx_cmd(inst, &cmd).start_tx_error)
+        return;     // Too late, the tag times out and the payload waits for the next exchange
+    rng->status.downlink_tx = 1;
+    slot->len = 0;
+}
+
+/**
+ * Tag side, hold the receiver for the downlink payload flagged by the last response. The payload is expected one 
+ * response holdoff after the last frame of the exchange; rng->sem stays held until it arrives or the window times out.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @param nlen  Length of the last frame of the exchange, excluding the FCS.
+ * @return void
+ */
+static void 
+rng_downlink_wait(dw1000_dev_instance_t * inst, uint16_t nlen){
+    dw1000_rng_instance_t * rng = inst->rng;
+    dw1000_set_rx_window(inst, inst->cb_data.rx_timestamp + ((uint64_t)rng_tx_holdoff(inst, nlen) << 16), 
+                        sizeof(ieee_rng_request_frame_t) + MYNEWT_VAL(DW1000_RNG_DOWNLINK_LEN));
+    rng->status.downlink_wait = !dw1000_start_rx(inst).start_rx_error;
+}
+#endif
+
 /**
  * This API initializes range request.
  *
@@ -203,20 +539,17 @@ dw1000_rng_request(dw1000_dev_instance_t * inst, uint16_t dst_address, dw1000_rn
     
     dw1000_rng_instance_t * rng = inst->rng;                            
     twr_frame_t * frame  = inst->rng->frames[(++rng->idx)%rng->nframes];    
-    dw1000_rng_config_t * config = inst->rng->config;
 
     frame->seq_num++;
     frame->code = code;
     frame->src_address = inst->my_short_address;
     frame->dst_address = dst_address;
+    rng->status.quality_valid = 0;
+    if (inst->config.framefilter_enabled)
+        frame->PANID = inst->PANID;     // Responder filters on the PAN assigned by dw1000_mac_set_address
    
-    dw1000_write_tx(inst, frame->array, 0, sizeof(ieee_rng_request_frame_t));
-    dw1000_write_tx_fctrl(inst, sizeof(ieee_rng_request_frame_t), 0, true);     
-    dw1000_set_wait4resp(inst, true);    
-    dw1000_set_rx_timeout(inst, config->rx_timeout_period); 
-    if (rng->control.delay_start_enabled) 
-        dw1000_set_delay_start(inst, rng->delay);
-    if (dw1000_start_tx(inst).start_tx_error){
+    uint64_t tx_delay = (rng->control.delay_start_enabled) ? rng->delay : 0;
+    if (rng_start_tx(inst, frame, sizeof(ieee_rng_request_frame_t), tx_delay, sizeof(ieee_rng_response_frame_t)).start_tx_error){
         if(inst->extension_cb != NULL){
             dw1000_extension_callbacks_t *head = inst->extension_cb;
             if(inst->extension_cb->tx_error_cb != NULL){
@@ -295,6 +628,116 @@ dw1000_rng_bias_correction(dw1000_dev_instance_t * inst, float Pr){
     return bias;
 }
 
+#if MYNEWT_VAL(DW1000_DSP_FIXEDPOINT)
+/**
+ * Fixed point counterpart of dw1000_rng_path_loss for the configured device, from the received power at 1 m worked
+ * out at init. Saturates below -128 dBm, beyond a few km.
+ *
+ * @param inst   Pointer to dw1000_dev_instance_t.
+ * @param R      Range in meters.
+ * @return int16_t received power in dBm * 256
+ */
+int16_t
+dw1000_rng_path_loss_q8(dw1000_dev_instance_t * inst, float R){
+    uint32_t range_mm = (R < 0.001f) ? 1 : (R > 1e6f) ? 1000000000 : (uint32_t)(R * 1000);
+    int32_t db_q8 = (dw1000_log2_q8(range_mm) * RNG_DB_PER_LOG2_Q14 + (1 << 13)) >> 14;
+    int32_t pr_q8 = inst->rng->pr_1m_q8 + (60 << 8) - db_q8;   // 20 * log10(R) = 20 * log10(range_mm) - 60
+    return (pr_q8 <= INT16_MIN) ? INT16_MIN + 1 : pr_q8;
+}
+
+/**
+ * Fixed point counterpart of dw1000_rng_bias_correction. The received power is clamped to the range the polynomials
+ * were rescaled over, RNG_BIAS_PR_CENTRE +/- RNG_BIAS_PR_SCALE dBm.
+ *
+ * @param inst   Pointer to dw1000_dev_instance_t.
+ * @param pr_q8  Received power in dBm * 256.
+ * @return int32_t bias in Q16
+ */
+int32_t
+dw1000_rng_bias_correction_q16(dw1000_dev_instance_t * inst, int16_t pr_q8){
+    int32_t u = ((int32_t) pr_q8 - (RNG_BIAS_PR_CENTRE << 8)) * (1 << 7) / RNG_BIAS_PR_SCALE;
+    u = (u < INT16_MIN) ? INT16_MIN : (u > INT16_MAX) ? INT16_MAX : u;
+    switch(inst->config.prf){
+        case DWT_PRF_16M:
+            return dw1000_polyval_q15(rng_bias_poly_PRF16_q16, u, sizeof(rng_bias_poly_PRF16_q16)/sizeof(int32_t));
+        case DWT_PRF_64M:
+            return dw1000_polyval_q15(rng_bias_poly_PRF64_q16, u, sizeof(rng_bias_poly_PRF64_q16)/sizeof(int32_t));
+        default:
+            assert(0);
+    }
+    return 0;
+}
+#endif
+
+#if MYNEWT_VAL(DW1000_RNG_NLOS_ENABLED)
+/**
+ * Estimate the first path quality of the last frame received from its receive diagnostics, with a model cheap enough
+ * for every ranging frame:
+ *  - the ratio of total received power to first path power, from the Q8 power levels of dw1000_get_rssi_q8 and
+ *    dw1000_get_fppl_q8 so no logarithm is taken in floating point. Line of sight frames have most of their energy in the
+ *    first path, the confidence falls linearly from DW1000_RNG_NLOS_LOS_DB to DW1000_RNG_NLOS_NLOS_DB;
+ *  - the first path amplitude over the noise, a leading edge close to the noise floor is easily early or late;
+ *  - the leading edge check, the peak path lagging far behind the first path is the signature of a blocked direct path.
+ * A frame is classified as non line of sight below half confidence. Needs config.rxdiag_enable.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @return dw1000_rng_quality_t
+ */
+dw1000_rng_quality_t
+dw1000_rng_quality(dw1000_dev_instance_t * inst){
+    dw1000_rng_quality_t quality = {0};
+    const dw1000_dev_rxdiag_t * diag = dw1000_mac_rxdiag(inst);
+
+    quality.variance = MYNEWT_VAL(RANGE_VARIANCE) * 16.0f;
+    quality.nlos = 1;
+    if (diag == NULL || diag->rx_std == 0)
+        return quality;
+    int16_t rssi = dw1000_get_rssi_q8(inst);
+    int16_t fppl = dw1000_get_fppl_q8(inst);
+    if (rssi == INT16_MIN || fppl == INT16_MIN)
+        return quality;
+
+    uint16_t pp_idx = dw1000_read_reg(inst, LDE_IF_ID, LDE_PPINDX_OFFSET, LDE_PPINDX_LEN);
+    quality.fp_ratio = (rssi - fppl) / 256.0f;
+    quality.fp_snr = (float) diag->fp_amp / diag->rx_std;
+    quality.pp_offset = pp_idx - diag->fp_idx / 64.0f;
+
+    float confidence;
+    if (quality.fp_ratio <= MYNEWT_VAL(DW1000_RNG_NLOS_LOS_DB))
+        confidence = 255;
+    else if (quality.fp_ratio >= MYNEWT_VAL(DW1000_RNG_NLOS_NLOS_DB))
+        confidence = 0;
+    else
+        confidence = 255 * (MYNEWT_VAL(DW1000_RNG_NLOS_NLOS_DB) - quality.fp_ratio)
+                    / (MYNEWT_VAL(DW1000_RNG_NLOS_NLOS_DB) - MYNEWT_VAL(DW1000_RNG_NLOS_LOS_DB));
+    if (quality.fp_snr < MYNEWT_VAL(DW1000_RNG_NLOS_SNR_MIN))
+        confidence /= 2;
+    if (quality.pp_offset > MYNEWT_VAL(DW1000_RNG_NLOS_PP_OFFSET))
+        confidence /= 2;
+
+    quality.confidence = (uint8_t) confidence;
+    quality.nlos = quality.confidence < 128;
+    // Deweight rather than drop, a filter downstream sees the variance grow up to 16 fold as the confidence falls
+    quality.variance = MYNEWT_VAL(RANGE_VARIANCE) * 255.0f / ((quality.confidence > 16) ? quality.confidence : 16);
+    return quality;
+}
+#endif
+
+/**
+ * Attach the first path quality of the frame just received to the exchange in progress. Called once the response, if
+ * any, has been committed, so the diagnostics and the classifier stay off the turnaround path.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @return void
+ */
+static void
+rng_quality_update(dw1000_dev_instance_t * inst){
+#if MYNEWT_VAL(DW1000_RNG_NLOS_ENABLED)
+    inst->rng->quality = dw1000_rng_quality(inst);
+    inst->rng->status.quality_valid = 1;
+#endif
+}
+
 #if MYNEWT_VAL(DW1000_RANGE)
 
 /**
@@ -420,9 +863,17 @@ rng_tx_final_cb(dw1000_dev_instance_t * inst){
     frame->cartesian.y = MYNEWT_VAL(LOCAL_COORDINATE_Y);
     frame->cartesian.z = MYNEWT_VAL(LOCAL_COORDINATE_Z);
   
+    float range = dw1000_rng_tof_to_meters(dw1000_rng_twr_to_tof(rng));
 #if MYNEWT_VAL(DW1000_BIAS_CORRECTION_ENABLED)
-    if (inst->config.bias_correction_enable){ 
-        float range = dw1000_rng_tof_to_meters(dw1000_rng_twr_to_tof(rng)); 
+    // The bias polynomial models the line of sight leading edge, it does not apply to a blocked direct path
+#if MYNEWT_VAL(DW1000_RNG_NLOS_ENABLED)
+    if (inst->config.bias_correction_enable && !(rng->status.quality_valid && rng->quality.nlos)){
+#else
+    if (inst->config.bias_correction_enable){
+#endif
+#if MYNEWT_VAL(DW1000_DSP_FIXEDPOINT)
+        float bias = dw1000_rng_bias_correction_q16(inst, dw1000_rng_path_loss_q8(inst, range)) * (2.0f / 65536);
+#else
         float bias = 2 * dw1000_rng_bias_correction(inst, 
                     dw1000_rng_path_loss(
                         MYNEWT_VAL(DW1000_DEVICE_TX_PWR),
@@ -430,12 +881,17 @@ rng_tx_final_cb(dw1000_dev_instance_t * inst){
                         MYNEWT_VAL(DW1000_DEVICE_FREQ),
                         range)
                     );
-        frame->spherical.range = range - bias;
+#endif
+        range -= bias;
     }
-#else
-    frame->spherical.range = dw1000_rng_tof_to_meters(dw1000_rng_twr_to_tof(rng));
 #endif
+    frame->spherical.range = range;
+#if MYNEWT_VAL(DW1000_RNG_NLOS_ENABLED)
+    // Quality of the earlier frame of this exchange, the one just received is only classified once this frame is sent
+    frame->spherical_variance.range = (rng->status.quality_valid) ? rng->quality.variance : MYNEWT_VAL(RANGE_VARIANCE);
+#else
     frame->spherical_variance.range = MYNEWT_VAL(RANGE_VARIANCE);
+#endif
     frame->spherical_variance.azimuth = -1;
     frame->spherical_variance.zenith = -1;
     frame->utime = os_cputime_ticks_to_usecs(os_cputime_get32());//dw1000_read_systime(inst)/128;
@@ -456,8 +912,14 @@ rng_tx_complete_cb(dw1000_dev_instance_t * inst)
 
     if (inst->fctrl == FCNTL_IEEE_RANGE_16){
         // Unlock Semaphore after last transmission
-        if (frame->code == DWT_SS_TWR_FINAL || frame->code == DWT_SS_TWR_T1){
-            os_sem_release(&inst->rng->sem);  
+        if (rng->status.downlink_tx){
+            // The downlink payload follows an exchange that has already completed
+            rng->status.downlink_tx = 0;
+        }
+        else if (frame->code == DWT_SS_TWR_FINAL || frame->code == DWT_SS_TWR_T1){
+            // A tag awaiting a downlink payload releases on its reception or timeout
+            if (!rng->status.downlink_wait)
+                os_sem_release(&inst->rng->sem);  
         }
 #ifdef  DS_TWR_ENABLE
         else{ 
@@ -466,6 +928,11 @@ rng_tx_complete_cb(dw1000_dev_instance_t * inst)
                     os_sem_release(&inst->rng->sem);  
             }
         }
+#endif
+#if MYNEWT_VAL(DW1000_RNG_DOWNLINK_SLOTS) > 0
+        // Double sided exchanges end with the anchor's final, the payload follows it
+        if (frame->code == DWT_DS_TWR_FINAL || frame->code == DWT_DS_TWR_EXT_FINAL)
+            rng_downlink_start(inst, dw1000_read_txtime(inst), rng->frame_len);
 #endif
     }
     if(inst->extension_cb != NULL){
@@ -493,6 +960,7 @@ rng_rx_timeout_cb(dw1000_dev_instance_t * inst){
         inst->extension_cb = head;
     }
     if(inst->fctrl == FCNTL_IEEE_RANGE_16){
+        inst->rng->status.downlink_wait = 0;
         os_error_t err = os_sem_release(&inst->rng->sem);
         assert(err == OS_OK);
     }
@@ -514,6 +982,7 @@ rng_rx_error_cb(dw1000_dev_instance_t * inst){
         inst->extension_cb = head;
     }
     if(inst->fctrl == FCNTL_IEEE_RANGE_16){
+        inst->rng->status.downlink_wait = 0;
         os_error_t err = os_sem_release(&inst->rng->sem);   
         assert(err == OS_OK);
     }
@@ -529,11 +998,10 @@ static void
 rng_rx_complete_cb(dw1000_dev_instance_t * inst)
 {
     uint16_t code, dst_address; 
-    dw1000_rng_config_t * config = inst->rng->config;
     dw1000_dev_control_t control = inst->control_rx_context;
     if (inst->fctrl == FCNTL_IEEE_RANGE_16){
-        dw1000_read_rx(inst, (uint8_t *) &code, offsetof(ieee_rng_request_frame_t,code), sizeof(uint16_t));
-        dw1000_read_rx(inst, (uint8_t *) &dst_address, offsetof(ieee_rng_request_frame_t,dst_address), sizeof(uint16_t));
+        memcpy(&code, &inst->cb_data.header[offsetof(ieee_rng_request_frame_t,code)], sizeof(uint16_t));
+        memcpy(&dst_address, &inst->cb_data.header[offsetof(ieee_rng_request_frame_t,dst_address)], sizeof(uint16_t));
     }else if(inst->extension_cb != NULL){
         dw1000_extension_callbacks_t *head = inst->extension_cb;
         if(inst->extension_cb->rx_complete_cb != NULL){
@@ -573,12 +1041,12 @@ rng_rx_complete_cb(dw1000_dev_instance_t * inst)
                         dw1000_rng_instance_t * rng = inst->rng; 
                         twr_frame_t * frame = rng->frames[(++rng->idx)%rng->nframes];
                         if (inst->frame_len >= sizeof(ieee_rng_request_frame_t))
-                            dw1000_read_rx(inst, frame->array, 0, sizeof(ieee_rng_request_frame_t));
+                            dw1000_read_rx_frame(inst, frame->array, sizeof(ieee_rng_request_frame_t));
                         else 
                             break; 
                     
-                        uint64_t request_timestamp = dw1000_read_rxtime(inst);  
-                        uint64_t response_tx_delay = request_timestamp + ((uint64_t)config->tx_holdoff_delay << 16);
+                        uint64_t request_timestamp = inst->cb_data.rx_timestamp;  
+                        uint64_t response_tx_delay = request_timestamp + ((uint64_t)rng_tx_holdoff(inst, inst->frame_len) << 16);
                         uint64_t response_timestamp = (response_tx_delay & 0xFFFFFFFE00UL) + inst->tx_antenna_delay;
         
                         frame->reception_timestamp = request_timestamp;
@@ -587,14 +1055,9 @@ rng_rx_complete_cb(dw1000_dev_instance_t * inst)
                         frame->src_address = inst->my_short_address;
                         frame->code = DWT_SS_TWR_T1;
 
-                        dw1000_write_tx(inst, frame->array, 0, sizeof(ieee_rng_response_frame_t));
-                        dw1000_write_tx_fctrl(inst, sizeof(ieee_rng_response_frame_t), 0, true); 
-                        dw1000_set_wait4resp(inst, true);    
-                        dw1000_set_delay_start(inst, response_tx_delay);
-                        dw1000_set_rx_timeout(inst, config->rx_timeout_period); 
-
-                        if (dw1000_start_tx(inst).start_tx_error)
+                        if (rng_start_tx(inst, frame, sizeof(ieee_rng_response_frame_t), response_tx_delay, sizeof(twr_frame_final_t)).start_tx_error)
                             os_sem_release(&rng->sem);  
+                        rng_quality_update(inst);
                         break;
                     }
                 case DWT_SS_TWR_T1:
@@ -604,7 +1067,7 @@ rng_rx_complete_cb(dw1000_dev_instance_t * inst)
                         dw1000_rng_instance_t * rng = inst->rng; 
                         twr_frame_t * frame = rng->frames[(rng->idx)%rng->nframes];
                         if (inst->frame_len >= sizeof(ieee_rng_response_frame_t))
-                            dw1000_read_rx(inst, frame->array, 0, sizeof(ieee_rng_response_frame_t));
+                            dw1000_read_rx_frame(inst, frame->array, sizeof(ieee_rng_response_frame_t));
                         else 
                             break;
 
@@ -613,12 +1076,21 @@ rng_rx_complete_cb(dw1000_dev_instance_t * inst)
                         frame->dst_address = frame->src_address;
                         frame->src_address = inst->my_short_address;
                         frame->code = DWT_SS_TWR_FINAL;
+
+                        // Keep the receiver on for the downlink payload flagged by the response
+                        uint16_t rx_nlen = 0;
+#if MYNEWT_VAL(DW1000_RNG_DOWNLINK_SLOTS) > 0
+                        if (inst->cb_data.rx_flags & DW1000_MAC_CB_RX_FLAG_PENDING)
+                            rx_nlen = sizeof(ieee_rng_request_frame_t) + MYNEWT_VAL(DW1000_RNG_DOWNLINK_LEN);
+#endif
+                        rng->status.downlink_wait = rx_nlen > 0;
                     
                         // Transmit timestamp final report
-                        dw1000_write_tx(inst, frame->array, 0, sizeof(twr_frame_final_t));
-                        dw1000_write_tx_fctrl(inst, sizeof(twr_frame_final_t), 0, true);
-                        if (dw1000_start_tx(inst).start_tx_error)
+                        if (rng_start_tx(inst, frame, sizeof(twr_frame_final_t), 0, rx_nlen).start_tx_error){
+                            rng->status.downlink_wait = 0;
                             os_sem_release(&rng->sem);  
+                        }
+                        rng_quality_update(inst);
                         if(inst->extension_cb != NULL){
                             dw1000_extension_callbacks_t *head = inst->extension_cb;
                             if(inst->extension_cb->rx_complete_cb != NULL){
@@ -636,7 +1108,11 @@ rng_rx_complete_cb(dw1000_dev_instance_t * inst)
                         dw1000_rng_instance_t * rng = inst->rng; 
                         twr_frame_t * frame = rng->frames[(rng->idx)%rng->nframes];
                         if (inst->frame_len >= sizeof(twr_frame_final_t))
-                            dw1000_read_rx(inst, frame->array, 0, sizeof(twr_frame_final_t));
+                            dw1000_read_rx_frame(inst, frame->array, sizeof(twr_frame_final_t));
+#if MYNEWT_VAL(DW1000_RNG_DOWNLINK_SLOTS) > 0
+                        rng_downlink_start(inst, inst->cb_data.rx_timestamp, inst->frame_len);
+#endif
+                        rng_quality_update(inst);
                         os_sem_release(&rng->sem);
                         if (inst->rng_complete_cb) {
                             inst->rng_complete_cb(inst);
@@ -665,12 +1141,12 @@ rng_rx_complete_cb(dw1000_dev_instance_t * inst)
                             dw1000_rng_instance_t * rng = inst->rng; 
                             twr_frame_t * frame = rng->frames[(++rng->idx)%rng->nframes];
                             if (inst->frame_len >= sizeof(ieee_rng_request_frame_t))
-                                dw1000_read_rx(inst, frame->array, 0, sizeof(ieee_rng_request_frame_t));
+                                dw1000_read_rx_frame(inst, frame->array, sizeof(ieee_rng_request_frame_t));
                             else 
                                 break; 
 
-                            uint64_t request_timestamp = dw1000_read_rxtime(inst);
-                            uint64_t response_tx_delay = request_timestamp + ((uint64_t)config->tx_holdoff_delay << 16);
+                            uint64_t request_timestamp = inst->cb_data.rx_timestamp;
+                            uint64_t response_tx_delay = request_timestamp + ((uint64_t)rng_tx_holdoff(inst, inst->frame_len) << 16);
                             uint64_t response_timestamp = (response_tx_delay & 0xFFFFFFFE00UL) + inst->tx_antenna_delay;
             
                             frame->reception_timestamp =  request_timestamp;
@@ -679,14 +1155,9 @@ rng_rx_complete_cb(dw1000_dev_instance_t * inst)
                             frame->src_address = inst->my_short_address;
                             frame->code = DWT_DS_TWR_T1;
 
-                            dw1000_write_tx(inst, frame->array, 0, sizeof(ieee_rng_response_frame_t));
-                            dw1000_write_tx_fctrl(inst, sizeof(ieee_rng_response_frame_t), 0, true); 
-                            dw1000_set_wait4resp(inst, true);    
-                            dw1000_set_delay_start(inst, response_tx_delay);   
-                            dw1000_set_rx_timeout(inst, config->rx_timeout_period); 
-
-                            if (dw1000_start_tx(inst).start_tx_error)
+                            if (rng_start_tx(inst, frame, sizeof(ieee_rng_response_frame_t), response_tx_delay, sizeof(twr_frame_final_t)).start_tx_error)
                                 os_sem_release(&rng->sem);
+                            rng_quality_update(inst);
                             break;
                         }
                     case DWT_DS_TWR_T1:
@@ -699,7 +1170,7 @@ rng_rx_complete_cb(dw1000_dev_instance_t * inst)
                             twr_frame_t * next_frame = rng->frames[(++rng->idx)%rng->nframes];
 
                             if (inst->frame_len >= sizeof(ieee_rng_response_frame_t))
-                                dw1000_read_rx(inst, frame->array, 0, sizeof(ieee_rng_response_frame_t));
+                                dw1000_read_rx_frame(inst, frame->array, sizeof(ieee_rng_response_frame_t));
                             else 
                                 break;
 
@@ -718,20 +1189,14 @@ rng_rx_complete_cb(dw1000_dev_instance_t * inst)
                             frame->seq_num = seq_num + 1;
                             frame->code = DWT_DS_TWR_T2;
 
-                            uint64_t request_timestamp = dw1000_read_rxtime(inst);  
-                            uint64_t response_tx_delay = request_timestamp + ((uint64_t)config->tx_holdoff_delay << 16);
+                            uint64_t request_timestamp = inst->cb_data.rx_timestamp;  
+                            uint64_t response_tx_delay = request_timestamp + ((uint64_t)rng_tx_holdoff(inst, inst->frame_len) << 16);
                             uint64_t response_timestamp = (response_tx_delay & 0xFFFFFFFE00UL) + inst->tx_antenna_delay;
                             
                             frame->reception_timestamp = request_timestamp;
                             frame->transmission_timestamp = response_timestamp;
 
-                            dw1000_write_tx(inst, frame->array, 0, sizeof(twr_frame_final_t));
-                            dw1000_write_tx_fctrl(inst, sizeof(twr_frame_final_t), 0, true);
-                            dw1000_set_wait4resp(inst, true);
-                            dw1000_set_delay_start(inst, response_tx_delay);
-                            dw1000_set_rx_timeout(inst, config->rx_timeout_period);
-                        
-                            if (dw1000_start_tx(inst).start_tx_error){
+                            if (rng_start_tx(inst, frame, sizeof(twr_frame_final_t), response_tx_delay, sizeof(twr_frame_final_t)).start_tx_error){
                                 if(inst->extension_cb != NULL){
                                     dw1000_extension_callbacks_t *head = inst->extension_cb;
                                     if(inst->extension_cb->tx_error_cb != NULL){
@@ -741,6 +1206,7 @@ rng_rx_complete_cb(dw1000_dev_instance_t * inst)
                                 }
                                 os_sem_release(&rng->sem);  
 							}
+                            rng_quality_update(inst);
                             break; 
                         }
 
@@ -753,7 +1219,7 @@ rng_rx_complete_cb(dw1000_dev_instance_t * inst)
                             twr_frame_t * frame = rng->frames[(rng->idx)%rng->nframes];
 
                             if (inst->frame_len >= sizeof(twr_frame_final_t))
-                                dw1000_read_rx(inst,  frame->array, 0, sizeof(twr_frame_final_t));
+                                dw1000_read_rx_frame(inst, frame->array, sizeof(twr_frame_final_t));
                             else 
                                 break;
 
@@ -767,11 +1233,9 @@ rng_rx_complete_cb(dw1000_dev_instance_t * inst)
                             frame->code = DWT_DS_TWR_FINAL;
 
                             // Transmit timestamp final report
-                            dw1000_write_tx(inst, frame->array, 0, sizeof(twr_frame_final_t));
-                            dw1000_write_tx_fctrl(inst, sizeof(twr_frame_final_t), 0, true); 
-
-                            if (dw1000_start_tx(inst).start_tx_error)
+                            if (rng_start_tx(inst, frame, sizeof(twr_frame_final_t), 0, 0).start_tx_error)
                                 os_sem_release(&rng->sem);  
+                            rng_quality_update(inst);
                             
                             if (inst->rng_complete_cb) {
                                 inst->rng_complete_cb(inst);
@@ -786,7 +1250,12 @@ rng_rx_complete_cb(dw1000_dev_instance_t * inst)
                             dw1000_rng_instance_t * rng = inst->rng; 
                             twr_frame_t * frame = rng->frames[(rng->idx)%rng->nframes];
                             if (inst->frame_len >= sizeof(twr_frame_final_t))
-                                dw1000_read_rx(inst, frame->array, 0, sizeof(twr_frame_final_t));
+                                dw1000_read_rx_frame(inst, frame->array, sizeof(twr_frame_final_t));
+#if MYNEWT_VAL(DW1000_RNG_DOWNLINK_SLOTS) > 0
+                            if (inst->cb_data.rx_flags & DW1000_MAC_CB_RX_FLAG_PENDING)
+                                rng_downlink_wait(inst, inst->frame_len);
+#endif
+                            rng_quality_update(inst);
                             if(inst->extension_cb != NULL){
                                 dw1000_extension_callbacks_t *head = inst->extension_cb;
                                 if(inst->extension_cb->rx_complete_cb != NULL){
@@ -794,7 +1263,8 @@ rng_rx_complete_cb(dw1000_dev_instance_t * inst)
                                 }
                                 inst->extension_cb = head;
                             }  
-                            os_sem_release(&rng->sem);
+                            if (!rng->status.downlink_wait)
+                                os_sem_release(&rng->sem);
                             if (inst->rng_complete_cb) {
                                 inst->rng_complete_cb(inst);
                             }
@@ -814,12 +1284,12 @@ rng_rx_complete_cb(dw1000_dev_instance_t * inst)
                             dw1000_rng_instance_t * rng = inst->rng; 
                             twr_frame_t * frame = rng->frames[(++rng->idx)%rng->nframes];
                             if (inst->frame_len >= sizeof(ieee_rng_request_frame_t))
-                                dw1000_read_rx(inst, frame->array, 0, sizeof(ieee_rng_request_frame_t));
+                                dw1000_read_rx_frame(inst, frame->array, sizeof(ieee_rng_request_frame_t));
                             else 
                                 break; 
 
-                            uint64_t request_timestamp = dw1000_read_rxtime(inst);  
-                            uint64_t response_tx_delay = request_timestamp + ((uint64_t)config->tx_holdoff_delay << 16); 
+                            uint64_t request_timestamp = inst->cb_data.rx_timestamp;  
+                            uint64_t response_tx_delay = request_timestamp + ((uint64_t)rng_tx_holdoff(inst, inst->frame_len) << 16); 
                             uint64_t response_timestamp = (response_tx_delay & 0xFFFFFFFE00UL) + inst->tx_antenna_delay;
             
                             frame->reception_timestamp = request_timestamp;
@@ -829,14 +1299,9 @@ rng_rx_complete_cb(dw1000_dev_instance_t * inst)
                             frame->src_address = inst->my_short_address;
                             frame->code = DWT_DS_TWR_EXT_T1;
 
-                            dw1000_write_tx(inst, frame->array, 0, sizeof(ieee_rng_response_frame_t));
-                            dw1000_write_tx_fctrl(inst, sizeof(ieee_rng_response_frame_t), 0, true); 
-                            dw1000_set_wait4resp(inst, true);    
-                            dw1000_set_delay_start(inst, response_tx_delay);   
-                            dw1000_set_rx_timeout(inst, config->rx_timeout_period); 
-
-                            if (dw1000_start_tx(inst).start_tx_error)
+                            if (rng_start_tx(inst, frame, sizeof(ieee_rng_response_frame_t), response_tx_delay, sizeof(twr_frame_t)).start_tx_error)
                                 os_sem_release(&rng->sem);  
+                            rng_quality_update(inst);
                             break;
                         }
                     case DWT_DS_TWR_EXT_T1:
@@ -848,7 +1313,7 @@ rng_rx_complete_cb(dw1000_dev_instance_t * inst)
                             twr_frame_t * next_frame = rng->frames[(rng->idx)%rng->nframes];
 
                             if (inst->frame_len >= sizeof(ieee_rng_response_frame_t))
-                                dw1000_read_rx(inst, frame->array, 0, sizeof(ieee_rng_response_frame_t));
+                                dw1000_read_rx_frame(inst, frame->array, sizeof(ieee_rng_response_frame_t));
                             else 
                                 break;
 
@@ -865,8 +1330,8 @@ rng_rx_complete_cb(dw1000_dev_instance_t * inst)
                             frame->seq_num = seq_num + 1;
                             frame->code = DWT_DS_TWR_EXT_T2;
 
-                            uint64_t request_timestamp = dw1000_read_rxtime(inst);  
-                            uint64_t response_tx_delay = request_timestamp + ((uint64_t)config->tx_holdoff_delay << 16); 
+                            uint64_t request_timestamp = inst->cb_data.rx_timestamp;  
+                            uint64_t response_tx_delay = request_timestamp + ((uint64_t)rng_tx_holdoff(inst, inst->frame_len) << 16); 
                             uint64_t response_timestamp = (response_tx_delay & 0xFFFFFFFE00UL) + inst->tx_antenna_delay;
                             
                             frame->reception_timestamp = request_timestamp;
@@ -876,14 +1341,9 @@ rng_rx_complete_cb(dw1000_dev_instance_t * inst)
                             if (inst->rng_tx_final_cb != NULL)
                                 inst->rng_tx_final_cb(inst);
 
-                            dw1000_write_tx(inst, frame->array, 0, sizeof(twr_frame_t));
-                            dw1000_write_tx_fctrl(inst, sizeof(twr_frame_t), 0, true); 
-                            dw1000_set_wait4resp(inst, true);    
-                            dw1000_set_delay_start(inst, response_tx_delay);   
-                            dw1000_set_rx_timeout(inst, config->rx_timeout_period); 
-                        
-                            if (dw1000_start_tx(inst).start_tx_error)
+                            if (rng_start_tx(inst, frame, sizeof(twr_frame_t), response_tx_delay, sizeof(twr_frame_t)).start_tx_error)
                                 os_sem_release(&rng->sem);  
+                            rng_quality_update(inst);
 
                             break; 
                         }
@@ -896,7 +1356,7 @@ rng_rx_complete_cb(dw1000_dev_instance_t * inst)
                             twr_frame_t * frame = rng->frames[(rng->idx)%rng->nframes];
 
                             if (inst->frame_len >= sizeof(twr_frame_t))
-                                dw1000_read_rx(inst, frame->array, 0, sizeof(twr_frame_t));
+                                dw1000_read_rx_frame(inst, frame->array, sizeof(twr_frame_t));
                             else 
                                 break;
 
@@ -914,11 +1374,9 @@ rng_rx_complete_cb(dw1000_dev_instance_t * inst)
                                 inst->rng_tx_final_cb(inst);
 
                             // Transmit timestamp final report
-                            dw1000_write_tx(inst, frame->array, 0, sizeof(twr_frame_t));
-                            dw1000_write_tx_fctrl(inst, sizeof(twr_frame_t), 0, true); 
-
-                            if (dw1000_start_tx(inst).start_tx_error)
+                            if (rng_start_tx(inst, frame, sizeof(twr_frame_t), 0, 0).start_tx_error)
                                 os_sem_release(&rng->sem);
+                            rng_quality_update(inst);
 
                             if (inst->rng_complete_cb) {
                                 inst->rng_complete_cb(inst);
@@ -932,8 +1390,14 @@ rng_rx_complete_cb(dw1000_dev_instance_t * inst)
                             dw1000_rng_instance_t * rng = inst->rng; 
                             twr_frame_t * frame = inst->rng->frames[(rng->idx)%rng->nframes];
                             if (inst->frame_len >= sizeof(twr_frame_t))
-                                dw1000_read_rx(inst, frame->array, 0, sizeof(twr_frame_t));
-                            os_sem_release(&rng->sem);
+                                dw1000_read_rx_frame(inst, frame->array, sizeof(twr_frame_t));
+#if MYNEWT_VAL(DW1000_RNG_DOWNLINK_SLOTS) > 0
+                            if (inst->cb_data.rx_flags & DW1000_MAC_CB_RX_FLAG_PENDING)
+                                rng_downlink_wait(inst, inst->frame_len);
+#endif
+                            rng_quality_update(inst);
+                            if (!rng->status.downlink_wait)
+                                os_sem_release(&rng->sem);
 
                             if (inst->rng_complete_cb) {
                                 inst->rng_complete_cb(inst);
@@ -952,6 +1416,26 @@ rng_rx_complete_cb(dw1000_dev_instance_t * inst)
                 }
             break;
 #endif //DS_TWR_EXT_ENABLE
+#if MYNEWT_VAL(DW1000_RNG_DOWNLINK_SLOTS) > 0
+        case DWT_RNG_DOWNLINK:
+            {
+                // This code executes on the tag, receiving the payload flagged by the frame pending bit of the last response
+                dw1000_rng_instance_t * rng = inst->rng;
+                uint16_t len = inst->frame_len - sizeof(ieee_rng_request_frame_t);
+                if (inst->frame_len > sizeof(ieee_rng_request_frame_t) && len <= MYNEWT_VAL(DW1000_RNG_DOWNLINK_LEN) && rng->downlink_cb){
+                    uint8_t payload[MYNEWT_VAL(DW1000_RNG_DOWNLINK_LEN)];
+                    uint16_t src_address;
+                    memcpy(&src_address, &inst->cb_data.header[offsetof(ieee_rng_request_frame_t,src_address)], sizeof(uint16_t));
+                    dw1000_read_rx(inst, payload, sizeof(ieee_rng_request_frame_t), len);
+                    rng->downlink_cb(inst, src_address, payload, len);
+                }
+                if (rng->status.downlink_wait){
+                    rng->status.downlink_wait = 0;
+                    os_sem_release(&rng->sem);
+                }
+                break;
+            }
+#endif
         default: 
             // Use this callback to extend interface and ranging services
             if(inst->extension_cb != NULL){
@@ -962,6 +1446,9 @@ rng_rx_complete_cb(dw1000_dev_instance_t * inst)
             }
             break;
     }  
+#if MYNEWT_VAL(DW1000_RNG_PAYLOAD_LEN) > 0
+    rng_payload_deliver(inst, code);
+#endif
 }
 
 
@@ -0,0 +1,273 @@
+/*
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file dw1000_sniffer.c
+ * @date 2026
+ * @brief sniffer
+ *
+ * @details This is the sniffer role. dw1000_sniffer_start displaces the device receive callbacks and configuration,
+ * dw1000_sniffer_stop restores them. The interrupt task only copies each frame into the record queue, the SPI reads
+ * being the frame itself and the diagnostics; records are written out from the default event queue so a slow output
+ * channel never holds off the receiver. Frames arriving while the queue is full are counted and reported in the
+ * overruns field of the next record.
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <os/os.h>
+#include <hal/hal_spi.h>
+#include <hal/hal_gpio.h>
+#include "bsp/bsp.h"
+
+#include <dw1000/dw1000_regs.h>
+#include <dw1000/dw1000_dev.h>
+#include <dw1000/dw1000_hal.h>
+#include <dw1000/dw1000_mac.h>
+#include <dw1000/dw1000_phy.h>
+
+#if MYNEWT_VAL(DW1000_SNIFFER)
+#include <dw1000/dw1000_sniffer.h>
+
+static void sniffer_rx_complete_cb(dw1000_dev_instance_t * inst);
+static void sniffer_rx_error_cb(dw1000_dev_instance_t * inst);
+static void sniffer_postprocess(struct os_event * ev);
+
+/**
+ * Allocate resources for the sniffer role.
+ *
+ * @param inst       Pointer to dw1000_dev_instance_t.
+ * @param output_cb  Record output callback.
+ * @return dw1000_sniffer_instance_t
+ */
+dw1000_sniffer_instance_t *
+dw1000_sniffer_init(dw1000_dev_instance_t * inst, dw1000_sniffer_output_cb_t * output_cb){
+    assert(inst);
+    assert(output_cb);
+
+    if (inst->sniffer == NULL ){
+        inst->sniffer = (dw1000_sniffer_instance_t *) malloc(sizeof(dw1000_sniffer_instance_t));
+        assert(inst->sniffer);
+        memset(inst->sniffer, 0, sizeof(dw1000_sniffer_instance_t));
+        inst->sniffer->status.selfmalloc = 1;
+    }
+    dw1000_sniffer_instance_t * sniffer = inst->sniffer;
+
+    sniffer->parent = inst;
+    sniffer->output_cb = output_cb;
+    os_callout_init(&sniffer->sniffer_callout_postprocess, os_eventq_dflt_get(), sniffer_postprocess, (void *) inst);
+    sniffer->status.initialized = 1;
+    return sniffer;
+}
+
+/**
+ * Free resources, stopping the capture first.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @return void
+ */
+void
+dw1000_sniffer_free(dw1000_dev_instance_t * inst){
+    assert(inst != NULL);
+    assert(inst->sniffer != NULL);
+    if (inst->sniffer->status.started)
+        dw1000_sniffer_stop(inst);
+    os_callout_stop(&inst->sniffer->sniffer_callout_postprocess);
+    if (inst->sniffer->status.selfmalloc){
+        free(inst->sniffer);
+        inst->sniffer = NULL;
+    }
+    else
+        inst->sniffer->status.initialized = 0;
+}
+
+/**
+ * Start capturing. Frame filtering is turned off, double buffering, diagnostics and receiver re-arming after errors
+ * are turned on, and the receiver is enabled without a timeout. The receive callbacks of the device, ranging
+ * included, are displaced until dw1000_sniffer_stop, so the device takes no part in any exchange while sniffing. The
+ * call waits for a transmit in flight to complete.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @return dw1000_dev_status_t
+ */
+dw1000_dev_status_t
+dw1000_sniffer_start(dw1000_dev_instance_t * inst){
+    assert(inst->sniffer);
+    dw1000_sniffer_instance_t * sniffer = inst->sniffer;
+    if (sniffer->status.started)
+        return inst->status;
+
+    // Swap under the device semaphore, a transmit in flight completes with the callbacks it was started with
+    os_error_t err = os_sem_pend(&inst->sem,  OS_TIMEOUT_NEVER); // Block if request pending
+    assert(err == OS_OK);
+
+    dw1000_phy_forcetrxoff(inst);
+
+    sniffer->config = inst->config;
+    sniffer->framefilter = inst->framefilter;
+    sniffer->rx_complete_cb = inst->rx_complete_cb;
+    sniffer->rx_error_cb = inst->rx_error_cb;
+    sniffer->rng_rx_complete_cb = inst->rng_rx_complete_cb;
+    sniffer->rng_rx_error_cb = inst->rng_rx_error_cb;
+
+    // Ranging and non-ranging frames alike, each error reported once
+    inst->rx_complete_cb = inst->rng_rx_complete_cb = sniffer_rx_complete_cb;
+    inst->rng_rx_error_cb = sniffer_rx_error_cb;
+    inst->rx_error_cb = NULL;
+    sniffer->head = sniffer->tail = sniffer->overruns = 0;
+    sniffer->status.started = 1;
+
+    inst->config.rxdiag_enable = 1;
+    inst->config.rx_rearm_enable = 1;
+    inst->config.promiscuous_enable = 1;
+
+    err = os_sem_release(&inst->sem);
+    assert(err == OS_OK);
+
+    dw1000_mac_framefilter(inst, 0);
+    dw1000_set_dblrxbuff(inst, true);
+    dw1000_set_rx_timeout(inst, 0);
+    return dw1000_start_rx(inst);
+}
+
+/**
+ * Stop capturing and restore the configuration and callbacks displaced by dw1000_sniffer_start. Records still queued
+ * are written out by the postprocess. The call waits for a transmit in flight to complete.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @return dw1000_dev_status_t
+ */
+dw1000_dev_status_t
+dw1000_sniffer_stop(dw1000_dev_instance_t * inst){
+    assert(inst->sniffer);
+    dw1000_sniffer_instance_t * sniffer = inst->sniffer;
+    if (!sniffer->status.started)
+        return inst->status;
+
+    os_error_t err = os_sem_pend(&inst->sem,  OS_TIMEOUT_NEVER); // Block if request pending
+    assert(err == OS_OK);
+
+    dw1000_phy_forcetrxoff(inst);
+    sniffer->status.started = 0;
+
+    inst->rx_complete_cb = sniffer->rx_complete_cb;
+    inst->rx_error_cb = sniffer->rx_error_cb;
+    inst->rng_rx_complete_cb = sniffer->rng_rx_complete_cb;
+    inst->rng_rx_error_cb = sniffer->rng_rx_error_cb;
+
+    inst->config.rxdiag_enable = sniffer->config.rxdiag_enable;
+    inst->config.rx_rearm_enable = sniffer->config.rx_rearm_enable;
+    inst->config.promiscuous_enable = sniffer->config.promiscuous_enable;
+
+    err = os_sem_release(&inst->sem);
+    assert(err == OS_OK);
+
+    dw1000_set_dblrxbuff(inst, sniffer->config.dblbuffon_enabled);
+    dw1000_mac_framefilter(inst, (sniffer->config.framefilter_enabled) ? sniffer->framefilter : 0);
+    return inst->status;
+}
+
+/**
+ * Capture a received frame into the record queue. With double buffering the receiver carries on into the other
+ * buffer by itself, the interrupt handler hands this buffer back once the callback returns.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @return void
+ */
+static void
+sniffer_rx_complete_cb(dw1000_dev_instance_t * inst){
+    dw1000_sniffer_instance_t * sniffer = inst->sniffer;
+    uint16_t head = sniffer->head;
+
+    if ((uint16_t)(head - sniffer->tail) >= MYNEWT_VAL(DW1000_SNIFFER_RECORDS)){
+        sniffer->overruns++;
+        sniffer->stats.overruns++;
+        return;
+    }
+
+    dw1000_sniffer_slot_t * slot = &sniffer->slots[head % MYNEWT_VAL(DW1000_SNIFFER_RECORDS)];
+    dw1000_sniffer_record_t * record = &slot->record;
+    uint16_t len = inst->frame_len + 2;   // Capture the FCS as well
+    uint16_t caplen = (len > MYNEWT_VAL(DW1000_SNIFFER_FRAME_LEN)) ? MYNEWT_VAL(DW1000_SNIFFER_FRAME_LEN) : len;
+
+    record->sync = DW1000_SNIFFER_SYNC;
+    record->caplen = caplen;
+    record->len = len;
+    for (uint8_t i = 0; i < sizeof(record->rx_timestamp); i++)
+        record->rx_timestamp[i] = (inst->cb_data.rx_timestamp >> (8 * i)) & 0xFF;
+    record->channel = inst->config.channel;
+    record->prf = inst->config.prf;
+    record->flags = inst->cb_data.rx_flags;
+    record->overruns = sniffer->overruns;
+    const dw1000_dev_rxdiag_t * diag = dw1000_mac_rxdiag(inst);
+    if (diag){
+        record->fp_idx = diag->fp_idx;
+        record->fp_amp = diag->fp_amp;
+        record->fp_amp2 = diag->fp_amp2;
+        record->fp_amp3 = diag->fp_amp3;
+        record->rx_std = diag->rx_std;
+        record->cir_pwr = diag->cir_pwr;
+        record->pacc_cnt = diag->pacc_cnt;
+    }
+    dw1000_read_rx(inst, slot->frame, 0, caplen);
+
+    sniffer->overruns = 0;
+    sniffer->stats.frames++;
+    if (caplen < len)
+        sniffer->stats.truncated++;
+    sniffer->head = head + 1;
+    os_eventq_put(os_eventq_dflt_get(), &sniffer->sniffer_callout_postprocess.c_ev);
+}
+
+/**
+ * Count receive errors, the interrupt handler has already re-armed the receiver.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @return void
+ */
+static void
+sniffer_rx_error_cb(dw1000_dev_instance_t * inst){
+    inst->sniffer->stats.rx_errors++;
+}
+
+/**
+ * Write the queued records to the output callback.
+ *
+ * @param ev    Pointer to os_events.
+ * @return void
+ */
+static void
+sniffer_postprocess(struct os_event * ev){
+    assert(ev != NULL);
+    assert(ev->ev_arg != NULL);
+    dw1000_dev_instance_t * inst = (dw1000_dev_instance_t *)ev->ev_arg;
+    dw1000_sniffer_instance_t * sniffer = inst->sniffer;
+
+    while (sniffer->tail != sniffer->head){
+        dw1000_sniffer_slot_t * slot = &sniffer->slots[sniffer->tail % MYNEWT_VAL(DW1000_SNIFFER_RECORDS)];
+        sniffer->output_cb(inst, (const uint8_t *) slot, sizeof(dw1000_sniffer_record_t) + slot->record.caplen);
+        sniffer->tail++;
+    }
+}
+
+#endif /* DW1000_SNIFFER */
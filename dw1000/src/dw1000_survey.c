@@ -0,0 +1,409 @@
+/*
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file dw1000_survey.c
+ * @date 2026
+ * @brief channel survey
+ *
+ * @details The survey holds the device semaphore from start to end, so it never overlaps a transmit and other users
+ * wait for at most the configured budget. Interrupts are masked while it runs and the receiver re-enables itself after
+ * errors; each noise sample also restarts a receiver left idle by a good frame. The survey sleeps between samples
+ * rather than running as timer events: CCP and the other services block on the device semaphore from the default
+ * queue, and would otherwise hold off the events that end the survey.
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <os/os.h>
+#include <hal/hal_spi.h>
+#include <hal/hal_gpio.h>
+#include "bsp/bsp.h"
+
+#include <dw1000/dw1000_regs.h>
+#include <dw1000/dw1000_dev.h>
+#include <dw1000/dw1000_hal.h>
+#include <dw1000/dw1000_mac.h>
+#include <dw1000/dw1000_phy.h>
+#include <dw1000/dw1000_dsp.h>
+
+#if MYNEWT_VAL(DW1000_SURVEY)
+#include <dw1000/dw1000_survey.h>
+#if MYNEWT_VAL(DW1000_COEX)
+#include <dw1000/dw1000_coex.h>
+#endif
+#if MYNEWT_VAL(DW1000_REGULATORY)
+#include <dw1000/dw1000_regulatory.h>
+#endif
+
+#define SURVEY_EDV2_OFFSET      (40)    //!< EDV2 reading with no input noise
+#define SURVEY_SCF_Q8           (320)   //!< Channels 1 to 4 scale factor of 1.3335, in dB Q8
+#define SURVEY_DB_PER_LOG2_Q8   (771)   //!< 10 * log10(2) in Q8
+
+static void survey_timer_ev_cb(struct os_event * ev);
+static void survey_postprocess(struct os_event * ev);
+static void survey_task(void * arg);
+
+static struct os_eventq survey_eventq;     //!< Error monitor and triggered surveys, shared by all instances
+static struct os_task survey_task_str;
+static os_stack_t survey_task_stack[DW1000_DEV_TASK_STACK_SZ]
+    __attribute__((aligned(OS_STACK_ALIGNMENT)));
+
+/**
+ * Allocate resources for the channel survey.
+ *
+ * @param inst    Pointer to dw1000_dev_instance_t.
+ * @param config  Survey configuration.
+ * @return dw1000_survey_instance_t
+ */
+dw1000_survey_instance_t *
+dw1000_survey_init(dw1000_dev_instance_t * inst, dw1000_survey_config_t config){
+    assert(inst);
+    assert(config.budget);
+
+    if (inst->survey == NULL ){
+        inst->survey = (dw1000_survey_instance_t *) malloc(sizeof(dw1000_survey_instance_t));
+        assert(inst->survey);
+        memset(inst->survey, 0, sizeof(dw1000_survey_instance_t));
+        inst->survey->status.selfmalloc = 1;
+    }
+    dw1000_survey_instance_t * survey = inst->survey;
+
+    survey->parent = inst;
+    survey->config = config;
+    if (!os_eventq_inited(&survey_eventq)){
+        os_eventq_init(&survey_eventq);
+        os_task_init(&survey_task_str, "dw1000_survey",
+                     survey_task,
+                     NULL,
+                     MYNEWT_VAL(DW1000_SURVEY_TASK_PRIO), OS_WAIT_FOREVER,
+                     survey_task_stack,
+                     DW1000_DEV_TASK_STACK_SZ);
+    }
+    os_callout_init(&survey->survey_callout_timer, &survey_eventq, survey_timer_ev_cb, (void *) inst);
+    if (!survey->config.postprocess)
+        os_callout_init(&survey->survey_callout_postprocess, os_eventq_dflt_get(), survey_postprocess, (void *) inst);
+    survey->status.initialized = 1;
+    return survey;
+}
+
+/**
+ * Free resources. A survey in progress must be allowed to complete first.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @return void
+ */
+void
+dw1000_survey_free(dw1000_dev_instance_t * inst){
+    assert(inst != NULL);
+    assert(inst->survey != NULL);
+    assert(inst->survey->status.busy == 0);
+    dw1000_survey_monitor_stop(inst);
+    if (inst->survey->status.selfmalloc){
+        free(inst->survey);
+        inst->survey = NULL;
+    }
+    else
+        inst->survey->status.initialized = 0;
+}
+
+/**
+ * Overrides the default postprocess, which moves to the best pair found.
+ *
+ * @param inst                Pointer to dw1000_dev_instance_t.
+ * @param survey_postprocess  Pointer to os_event_fn, called with the results ranked.
+ * @return void
+ */
+void
+dw1000_survey_set_postprocess(dw1000_dev_instance_t * inst, os_event_fn * survey_postprocess){
+    os_callout_init(&inst->survey->survey_callout_postprocess, os_eventq_dflt_get(), survey_postprocess, (void *) inst);
+    inst->survey->config.postprocess = true;
+}
+
+/**
+ * Input noise level of the receiver as it listens, from the AGC noise estimate (EDV2 - 40) * 10^EDG1 * SCF.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @return int16_t noise in dB Q8, relative to an arbitrary but fixed reference
+ */
+int16_t
+dw1000_survey_noise(dw1000_dev_instance_t * inst){
+    uint32_t reg = dw1000_read_reg(inst, AGC_CTRL_ID, AGC_STAT1_OFFSET, AGC_STAT1_LEN);
+    int32_t edg1 = (reg & AGC_STAT1_EDG1_MASK) >> AGC_STAT1_EDG1_SHIFT;
+    int32_t edv2 = (reg & AGC_STAT1_EDG2_MASK) >> AGC_STAT1_EDG2_SHIFT;
+
+    int32_t noise = (edv2 > SURVEY_EDV2_OFFSET) ? (dw1000_log2_q8(edv2 - SURVEY_EDV2_OFFSET) * SURVEY_DB_PER_LOG2_Q8) >> 8 : 0;
+    noise += (edg1 * 10) << 8;
+    if (inst->config.channel <= 4)
+        noise += SURVEY_SCF_Q8;
+    return (noise > INT16_MAX) ? INT16_MAX : noise;
+}
+
+/**
+ * Rank the results, fewest errors and frames first then lowest noise.
+ *
+ * @param survey  Pointer to dw1000_survey_instance_t.
+ * @return void
+ */
+static void
+survey_rank(dw1000_survey_instance_t * survey){
+    for (uint8_t i = 1; i < survey->nresults; i++){
+        dw1000_survey_result_t r = survey->results[i];
+        uint32_t load = r.false_preambles + r.phr_errors + r.rs_errors + r.crc_errors + r.frames;
+        int8_t j = i - 1;
+        for (; j >= 0; j--){
+            dw1000_survey_result_t * q = &survey->results[j];
+            uint32_t qload = q->false_preambles + q->phr_errors + q->rs_errors + q->crc_errors + q->frames;
+            if (qload < load || (qload == load && q->noise <= r.noise))
+                break;
+            survey->results[j + 1] = *q;
+        }
+        survey->results[j + 1] = r;
+    }
+}
+
+/**
+ * Errors counted on the pair in use, modulo the 12-bit counter width.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @return uint16_t
+ */
+static uint16_t
+survey_errors(dw1000_dev_instance_t * inst){
+    dw1000_mac_deviceentcnts_t cnts;
+    dw1000_mac_read_eventcounters(inst, &cnts);
+    return (cnts.PHE + cnts.RSL + cnts.CRCB + cnts.SFDTO) & EVC_PHE_MASK;
+}
+
+/**
+ * Survey every pair in config.channel_mask, then rank them and post the postprocess. The call blocks for the budget,
+ * holding the device throughout, and leaves it on the pair it was using, listening if it was before. Call it from a
+ * task that can afford to block, not from an event on the default queue.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @return void
+ */
+void
+dw1000_survey_start(dw1000_dev_instance_t * inst){
+    dw1000_survey_instance_t * survey = inst->survey;
+    assert(survey);
+    assert(survey->status.busy == 0);
+
+    survey->nresults = 0;
+    for (uint8_t ch = 1; ch < 8; ch++){
+        if (!(survey->config.channel_mask & (1 << ch)))
+            continue;
+        for (const uint8_t * code = dw1000_mac_preamble_codes(inst, ch); *code; code++){
+            assert(survey->nresults < DW1000_SURVEY_NRESULTS);
+            survey->results[survey->nresults++] = (dw1000_survey_result_t){.channel = ch, .preamble_code = *code};
+        }
+    }
+    assert(survey->nresults);
+    survey->dwell = OS_TICKS_PER_SEC * (survey->config.budget / (survey->nresults * DW1000_SURVEY_NSAMPLES)) * 1e-6;
+    survey->dwell = (survey->dwell) ? survey->dwell : 1;
+
+    os_callout_stop(&survey->survey_callout_timer);
+    os_error_t err = os_sem_pend(&inst->sem, OS_TIMEOUT_NEVER);
+    assert(err == OS_OK);
+
+    survey->status.busy = 1;
+    survey->status.valid = 0;
+    survey->status.listen = (dw1000_read_reg(inst, SYS_STATE_ID, 0, sizeof(uint32_t)) & SYS_STATE_RX_STATE_MASK) != 0;
+    uint8_t channel = inst->config.channel;
+    uint8_t preamble_code = inst->config.rx.preambleCodeIndex;
+    uint32_t power = inst->config.txrf.power;
+    uint32_t mask = dw1000_read_reg(inst, SYS_MASK_ID, 0, sizeof(uint32_t));
+
+    dw1000_write_reg(inst, SYS_MASK_ID, 0, 0, sizeof(uint32_t));
+    dw1000_phy_forcetrxoff(inst);
+    // Receiver re-enabled by hardware after errors, never timed out
+    dw1000_write_reg(inst, SYS_CFG_ID, 0, (inst->sys_cfg_reg | SYS_CFG_RXAUTR) & ~SYS_CFG_RXWTOE, sizeof(uint32_t));
+
+    for (uint8_t i = 0; i < survey->nresults; i++){
+        dw1000_survey_result_t * result = &survey->results[i];
+        dw1000_mac_retune(inst, result->channel, result->preamble_code);
+        dw1000_mac_config_eventcounters(inst, true);
+        dw1000_write_reg(inst, SYS_CTRL_ID, SYS_CTRL_OFFSET, SYS_CTRL_RXENAB, sizeof(uint16_t));
+
+        int32_t noise = 0;
+        for (uint8_t sample = 0; sample < DW1000_SURVEY_NSAMPLES; sample++){
+            os_time_delay(survey->dwell);
+            noise += dw1000_survey_noise(inst);
+            // A good frame leaves the receiver idle, errors do not
+            if ((dw1000_read_reg(inst, SYS_STATE_ID, 0, sizeof(uint32_t)) & SYS_STATE_RX_STATE_MASK) == 0){
+                dw1000_write_reg(inst, SYS_STATUS_ID, 0, SYS_STATUS_ALL_RX_GOOD, sizeof(uint32_t));
+                dw1000_write_reg(inst, SYS_CTRL_ID, SYS_CTRL_OFFSET, SYS_CTRL_RXENAB, sizeof(uint16_t));
+            }
+        }
+        dw1000_phy_forcetrxoff(inst);
+
+        dw1000_mac_deviceentcnts_t cnts;
+        dw1000_mac_read_eventcounters(inst, &cnts);
+        result->noise = noise / DW1000_SURVEY_NSAMPLES;
+        result->false_preambles = cnts.SFDTO;
+        result->phr_errors = cnts.PHE;
+        result->rs_errors = cnts.RSL;
+        result->crc_errors = cnts.CRCB;
+        result->frames = cnts.CRCG;
+    }
+
+    dw1000_mac_retune(inst, channel, preamble_code);
+    // Back on the home channel with the TX power it was configured with, not the reference value
+    inst->config.txrf.power = power;
+    dw1000_phy_config_txrf(inst, &inst->config.txrf);
+#if MYNEWT_VAL(DW1000_REGULATORY)
+    if (inst->regulatory)
+        inst->regulatory->base_power = inst->regulatory->power = power;
+#endif
+    dw1000_write_reg(inst, SYS_CFG_ID, 0, inst->sys_cfg_reg, sizeof(uint32_t));
+    dw1000_write_reg(inst, SYS_STATUS_ID, 0, SYS_STATUS_ALL_RX_GOOD | SYS_STATUS_ALL_RX_ERR | SYS_STATUS_ALL_RX_TO, sizeof(uint32_t));
+    dw1000_write_reg(inst, SYS_MASK_ID, 0, mask, sizeof(uint32_t));
+    dw1000_mac_config_eventcounters(inst, true);
+    survey->errors = 0;
+
+    survey_rank(survey);
+    survey->stats.surveys++;
+    survey->status.valid = 1;
+    survey->status.busy = 0;
+
+    err = os_sem_release(&inst->sem);
+    assert(err == OS_OK);
+    if (survey->status.listen)
+        dw1000_restart_rx(inst, inst->control_rx_context);
+    if (survey->status.monitoring)
+        os_callout_reset(&survey->survey_callout_timer, OS_TICKS_PER_SEC * survey->config.period * 1e-6);
+    os_eventq_put(os_eventq_dflt_get(), &survey->survey_callout_postprocess.c_ev);
+}
+
+/**
+ * Survey task, runs the error monitor and the surveys it triggers.
+ *
+ * @param arg  Unused.
+ * @return void
+ */
+static void
+survey_task(void * arg){
+    while (1) {
+        os_eventq_run(&survey_eventq);
+    }
+}
+
+/**
+ * Error monitor, surveys when the threshold is crossed. Runs on the survey task, which the survey blocks for its
+ * budget.
+ *
+ * @param ev  Pointer to os_events.
+ * @return void
+ */
+static void
+survey_timer_ev_cb(struct os_event * ev){
+    assert(ev != NULL);
+    assert(ev->ev_arg != NULL);
+    dw1000_dev_instance_t * inst = (dw1000_dev_instance_t *)ev->ev_arg;
+    dw1000_survey_instance_t * survey = inst->survey;
+
+    uint16_t errors = survey_errors(inst);
+    uint16_t delta = (errors - survey->errors) & EVC_PHE_MASK;
+    survey->errors = errors;
+    if (delta > survey->config.threshold){
+        survey->stats.triggers++;
+        dw1000_survey_start(inst);
+    }else
+        os_callout_reset(&survey->survey_callout_timer, OS_TICKS_PER_SEC * survey->config.period * 1e-6);
+}
+
+/**
+ * Watch the error counters on the pair in use and survey when more than config.threshold errors are counted in a
+ * config.period.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @return void
+ */
+void
+dw1000_survey_monitor_start(dw1000_dev_instance_t * inst){
+    dw1000_survey_instance_t * survey = inst->survey;
+    assert(survey);
+    assert(survey->config.period);
+
+    survey->status.monitoring = 1;
+    if (survey->status.busy)
+        return;     // Resumed once the survey completes
+    survey->errors = survey_errors(inst);
+    os_callout_reset(&survey->survey_callout_timer, OS_TICKS_PER_SEC * survey->config.period * 1e-6);
+}
+
+/**
+ * Stop watching the error counters. A survey in progress runs to completion.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @return void
+ */
+void
+dw1000_survey_monitor_stop(dw1000_dev_instance_t * inst){
+    dw1000_survey_instance_t * survey = inst->survey;
+    assert(survey);
+
+    survey->status.monitoring = 0;
+    if (!survey->status.busy)
+        os_callout_stop(&survey->survey_callout_timer);
+}
+
+/**
+ * Default postprocess: move to the best pair when it is strictly quieter than the one in use. With the coexistence
+ * service running the move is announced to the PAN, otherwise the device retunes alone.
+ *
+ * @param ev  Pointer to os_events.
+ * @return void
+ */
+static void
+survey_postprocess(struct os_event * ev){
+    assert(ev != NULL);
+    assert(ev->ev_arg != NULL);
+    dw1000_dev_instance_t * inst = (dw1000_dev_instance_t *)ev->ev_arg;
+    dw1000_survey_instance_t * survey = inst->survey;
+    dw1000_survey_result_t * best = &survey->results[0];
+
+    if (best->channel == inst->config.channel && best->preamble_code == inst->config.rx.preambleCodeIndex)
+        return;
+    uint32_t load = best->false_preambles + best->phr_errors + best->rs_errors + best->crc_errors + best->frames;
+    for (uint8_t i = 1; i < survey->nresults; i++){
+        dw1000_survey_result_t * r = &survey->results[i];
+        if (r->channel == inst->config.channel && r->preamble_code == inst->config.rx.preambleCodeIndex){
+            if (load == r->false_preambles + r->phr_errors + r->rs_errors + r->crc_errors + r->frames)
+                return;
+            break;
+        }
+    }
+    survey->stats.switches++;
+#if MYNEWT_VAL(DW1000_COEX)
+    if (inst->coex){
+        dw1000_coex_assign(inst, (dw1000_coex_ie_t){.channel = best->channel, .preamble_code = best->preamble_code});
+        return;
+    }
+#endif
+    dw1000_mac_set_channel(inst, best->channel, best->preamble_code);
+    if (survey->status.listen)
+        dw1000_restart_rx(inst, inst->control_rx_context);
+}
+
+#endif /* DW1000_SURVEY */
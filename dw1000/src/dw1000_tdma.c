@@ -45,6 +45,7 @@
 
 #include <dw1000/dw1000_dev.h>
 #include <dw1000/dw1000_hal.h>
+#include <dw1000/dw1000_mac.h>
 
 #if MYNEWT_VAL(DW1000_CCP_ENABLED)
 #include <dw1000/dw1000_ccp.h>
@@ -236,9 +237,12 @@ tdma_superframe_event_cb(struct os_event * ev){
     dw1000_ccp_instance_t * ccp = (void *)clkcal->ccp; 
     dw1000_dev_instance_t * inst = ccp->parent;
     tdma_instance_t * tdma = inst->tdma;
-    uint32_t cputime = os_cputime_get32() - os_cputime_usecs_to_ticks(MYNEWT_VAL(OS_LATENCY));
+    // The superframe epoch is the CCP RMARKER, the event fires after the PHR and payload of the CCP frame
+    uint32_t cputime = os_cputime_get32() - os_cputime_usecs_to_ticks(MYNEWT_VAL(OS_LATENCY)) 
+        - os_cputime_usecs_to_ticks(dw1000_dwt_usecs_to_usecs(dw1000_phy_data_duration(inst, sizeof(ccp_frame_t))));
     
     tdma->status.awaiting_superframe = 0;
+    dw1000_mac_framefilter_window(inst, DW1000_CCP, false);   // Superframe found, drop blinks until the next slot 0
     hal_timer_start_at(&tdma->slot[0]->timer, cputime + os_cputime_usecs_to_ticks(dw1000_dwt_usecs_to_usecs(tdma->period)));
     for (uint16_t i = 1; i < tdma->nslots; i++) {
         if (tdma->slot[i]){
@@ -277,6 +281,7 @@ slot0_event_cb(struct os_event * ev){
     }
  
     tdma->status.awaiting_superframe = 1; 
+    dw1000_mac_framefilter_window(inst, DW1000_CCP, true);    // Let the CCP blink through the frame filter
     dw1000_set_delay_start(inst, 0);
     dw1000_set_rx_timeout(inst, 0);
     if(dw1000_start_rx(inst).start_rx_error){
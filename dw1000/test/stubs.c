@@ -0,0 +1,176 @@
+/*
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file stubs.c
+ * @brief Host stand-ins for the kernel, HAL and util calls of the driver sources under test
+ *
+ * @details The tests are single threaded. A semaphore pend without tokens fails instead of blocking, so a test that
+ * expects to block has a bug. Events put on a queue are held until os_eventq_run.
+ *
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <os/os.h>
+#include <hal/hal_gpio.h>
+#include <crc/crc16.h>
+
+static struct os_eventq g_evq_dflt;
+
+os_error_t
+os_sem_init(struct os_sem * sem, uint16_t tokens){
+    sem->sem_tokens = tokens;
+    return OS_OK;
+}
+
+os_error_t
+os_sem_pend(struct os_sem * sem, uint32_t timeout){
+    if (sem->sem_tokens == 0)
+        return OS_TIMEOUT;
+    sem->sem_tokens--;
+    return OS_OK;
+}
+
+os_error_t
+os_sem_release(struct os_sem * sem){
+    sem->sem_tokens++;
+    return OS_OK;
+}
+
+uint16_t
+os_sem_get_count(struct os_sem * sem){
+    return sem->sem_tokens;
+}
+
+os_error_t
+os_mutex_init(struct os_mutex * mu){
+    mu->mu_level = 0;
+    return OS_OK;
+}
+
+os_error_t
+os_mutex_pend(struct os_mutex * mu, uint32_t timeout){
+    mu->mu_level++;
+    return OS_OK;
+}
+
+os_error_t
+os_mutex_release(struct os_mutex * mu){
+    mu->mu_level--;
+    return OS_OK;
+}
+
+void
+os_eventq_init(struct os_eventq * evq){
+    memset(evq, 0, sizeof(*evq));
+}
+
+int
+os_eventq_inited(const struct os_eventq * evq){
+    return 1;
+}
+
+void
+os_eventq_put(struct os_eventq * evq, struct os_event * ev){
+    if (ev->ev_queued || evq->count == sizeof(evq->events) / sizeof(evq->events[0]))
+        return;
+    ev->ev_queued = 1;
+    evq->events[evq->count++] = ev;
+}
+
+void
+os_eventq_run(struct os_eventq * evq){
+    if (evq->count == 0)
+        return;
+    struct os_event * ev = evq->events[0];
+    memmove(&evq->events[0], &evq->events[1], --evq->count * sizeof(evq->events[0]));
+    ev->ev_queued = 0;
+    ev->ev_cb(ev);
+}
+
+struct os_eventq *
+os_eventq_dflt_get(void){
+    return &g_evq_dflt;
+}
+
+void
+os_callout_init(struct os_callout * c, struct os_eventq * evq, os_event_fn * ev_cb, void * ev_arg){
+    memset(c, 0, sizeof(*c));
+    c->c_ev.ev_cb = ev_cb;
+    c->c_ev.ev_arg = ev_arg;
+    c->c_evq = evq;
+}
+
+int
+os_task_init(struct os_task * t, const char * name, os_task_func_t * func, void * arg, uint8_t prio,
+        os_time_t sanity_itvl, os_stack_t * stack_bottom, uint16_t stack_size){
+    t->t_name = name;
+    return 0;
+}
+
+uint32_t
+os_cputime_get32(void){
+    return 0;
+}
+
+uint32_t
+os_cputime_ticks_to_usecs(uint32_t ticks){
+    return ticks;
+}
+
+uint32_t
+os_cputime_usecs_to_ticks(uint32_t usecs){
+    return usecs;
+}
+
+int
+hal_gpio_irq_init(int pin, hal_gpio_irq_handler_t handler, void * arg, int trig, int pull){
+    return 0;
+}
+
+void
+hal_gpio_irq_enable(int pin){
+}
+
+void
+hal_gpio_irq_disable(int pin){
+}
+
+void
+hal_gpio_irq_release(int pin){
+}
+
+/**
+ * CRC16-CCITT as in util/crc, polynomial 0x1021, most significant bit first, no final xor.
+ */
+uint16_t
+crc16_ccitt(uint16_t initial_crc, const void * buf, int len){
+    const uint8_t * ptr = (const uint8_t *) buf;
+    uint16_t crc = initial_crc;
+
+    while (len-- > 0){
+        crc ^= (uint16_t) *ptr++ << 8;
+        for (int i = 0; i < 8; i++)
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+    return crc;
+}
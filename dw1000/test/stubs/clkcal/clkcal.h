@@ -0,0 +1,38 @@
+/*
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef _CLKCAL_H_
+#define _CLKCAL_H_
+
+#include <stdint.h>
+
+//! Clock calibration status
+typedef struct _clkcal_status_t{
+    uint16_t valid:1;               //!< Skew available
+}clkcal_status_t;
+
+//! Clock calibration instance, only the skew the timestamp readers apply
+typedef struct _clkcal_instance_t{
+    clkcal_status_t status;         //!< Clock calibration status
+    double skew;                    //!< Local clock rate over the master clock rate
+}clkcal_instance_t;
+
+#endif /* _CLKCAL_H_ */
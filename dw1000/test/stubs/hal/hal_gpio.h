@@ -0,0 +1,35 @@
+/*
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef _HAL_GPIO_H_
+#define _HAL_GPIO_H_
+
+typedef void (* hal_gpio_irq_handler_t)(void * arg);
+
+#define HAL_GPIO_TRIG_RISING    (1)
+#define HAL_GPIO_PULL_UP        (1)
+
+int hal_gpio_irq_init(int pin, hal_gpio_irq_handler_t handler, void * arg, int trig, int pull);
+void hal_gpio_irq_enable(int pin);
+void hal_gpio_irq_disable(int pin);
+void hal_gpio_irq_release(int pin);
+
+#endif /* _HAL_GPIO_H_ */
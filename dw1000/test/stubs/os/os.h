@@ -0,0 +1,111 @@
+/*
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file os.h
+ * @brief Host test stand-in for the Mynewt kernel
+ *
+ * @details Only the types and calls the driver sources under test use. Semaphores count tokens and never block,
+ * events are queued for the test to run; see stubs.c.
+ *
+ */
+
+#ifndef _OS_H_
+#define _OS_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "syscfg/syscfg.h"
+
+typedef uint32_t os_time_t;
+typedef uint8_t os_stack_t;
+typedef uint32_t os_sr_t;
+typedef int os_error_t;
+
+#define OS_OK               (0)
+#define OS_TIMEOUT          (6)
+#define OS_TIMEOUT_NEVER    (UINT32_MAX)
+#define OS_WAIT_FOREVER     (OS_TIMEOUT_NEVER)
+#define OS_STACK_ALIGNMENT  (8)
+#define OS_STACK_ALIGN(x)   (x)
+
+#define OS_ENTER_CRITICAL(sr) do { (sr) = 0; } while (0)
+#define OS_EXIT_CRITICAL(sr) do { (void)(sr); } while (0)
+
+struct os_event;
+typedef void os_event_fn(struct os_event * ev);
+
+struct os_event {
+    uint8_t ev_queued;
+    os_event_fn * ev_cb;
+    void * ev_arg;
+};
+
+struct os_eventq {
+    struct os_event * events[8];
+    uint8_t count;
+};
+
+struct os_callout {
+    struct os_event c_ev;
+    struct os_eventq * c_evq;
+};
+
+struct os_sem {
+    uint16_t sem_tokens;
+};
+
+struct os_mutex {
+    uint16_t mu_level;
+};
+
+struct os_task {
+    const char * t_name;
+};
+
+typedef void os_task_func_t(void * arg);
+
+os_error_t os_sem_init(struct os_sem * sem, uint16_t tokens);
+os_error_t os_sem_pend(struct os_sem * sem, uint32_t timeout);
+os_error_t os_sem_release(struct os_sem * sem);
+uint16_t os_sem_get_count(struct os_sem * sem);
+
+os_error_t os_mutex_init(struct os_mutex * mu);
+os_error_t os_mutex_pend(struct os_mutex * mu, uint32_t timeout);
+os_error_t os_mutex_release(struct os_mutex * mu);
+
+void os_eventq_init(struct os_eventq * evq);
+int os_eventq_inited(const struct os_eventq * evq);
+void os_eventq_put(struct os_eventq * evq, struct os_event * ev);
+void os_eventq_run(struct os_eventq * evq);
+struct os_eventq * os_eventq_dflt_get(void);
+
+void os_callout_init(struct os_callout * c, struct os_eventq * evq, os_event_fn * ev_cb, void * ev_arg);
+
+int os_task_init(struct os_task * t, const char * name, os_task_func_t * func, void * arg, uint8_t prio,
+        os_time_t sanity_itvl, os_stack_t * stack_bottom, uint16_t stack_size);
+
+uint32_t os_cputime_get32(void);
+uint32_t os_cputime_ticks_to_usecs(uint32_t ticks);
+uint32_t os_cputime_usecs_to_ticks(uint32_t usecs);
+
+#endif /* _OS_H_ */
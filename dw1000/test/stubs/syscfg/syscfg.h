@@ -0,0 +1,59 @@
+/*
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file syscfg.h
+ * @brief Host test configuration
+ *
+ * @details Stands in for the newt generated syscfg. The services under test are enabled, the rest of the driver is
+ * configured out so the stubs stay small.
+ *
+ */
+
+#ifndef _SYSCFG_H_
+#define _SYSCFG_H_
+
+#define MYNEWT_VAL(x) MYNEWT_VAL_##x
+
+#define MYNEWT_VAL_ADAPTIVE_TIMESCALE_ENABLED 1
+#define MYNEWT_VAL_CLOCK_CALIBRATION_ENABLED 1
+#define MYNEWT_VAL_DW1000_CCP_ENABLED 1
+#define MYNEWT_VAL_DW1000_CCP_EXT_SYNC 0
+#define MYNEWT_VAL_FS_XTALT_AUTOTUNE_ENABLED 0
+#define MYNEWT_VAL_DW1000_DSP_FIXEDPOINT 1
+#define MYNEWT_VAL_DW1000_BULK 1
+#define MYNEWT_VAL_DW1000_CIR 0
+#define MYNEWT_VAL_DW1000_CIR_MAX_TAPS 0
+#define MYNEWT_VAL_DW1000_COEX 0
+#define MYNEWT_VAL_DW1000_DRIFT 0
+#define MYNEWT_VAL_DW1000_LWIP 0
+#define MYNEWT_VAL_DW1000_MAC_FILTERING 0
+#define MYNEWT_VAL_DW1000_PAN 0
+#define MYNEWT_VAL_DW1000_PROVISION 0
+#define MYNEWT_VAL_DW1000_RANGE 0
+#define MYNEWT_VAL_DW1000_REGULATORY 0
+#define MYNEWT_VAL_DW1000_RX_SEQ_CACHE_SIZE 0
+#define MYNEWT_VAL_DW1000_SNIFFER 0
+#define MYNEWT_VAL_DW1000_SURVEY 0
+#define MYNEWT_VAL_DW1000_DEV_TASK_PRIO 5
+#define MYNEWT_VAL_DW1000_DEV_TASK_STACK_SZ 256
+
+#endif /* _SYSCFG_H_ */
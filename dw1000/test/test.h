@@ -0,0 +1,84 @@
+/*
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file test.h
+ * @brief Host test helpers
+ *
+ * @details Failed assertions are reported with their location and counted, test_report() turns the count into the
+ * exit status. The pseudo random source is fixed so every run checks the same inputs.
+ *
+ */
+
+#ifndef _TEST_H_
+#define _TEST_H_
+
+#include <stdio.h>
+#include <stdint.h>
+
+static int test_failures;
+
+#define TEST_ASSERT(cond, ...) do { \
+    if (!(cond)){ \
+        fprintf(stderr, "%s:%d: %s: ", __FILE__, __LINE__, #cond); \
+        fprintf(stderr, __VA_ARGS__); \
+        fputc('\n', stderr); \
+        test_failures++; \
+    } \
+} while (0)
+
+/**
+ * xorshift64* pseudo random numbers, the same sequence on every host.
+ *
+ * @return uint64_t
+ */
+static inline uint64_t
+test_rand64(void){
+    static uint64_t state = 0x9E3779B97F4A7C15ULL;
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return state * 0x2545F4914F6CDD1DULL;
+}
+
+/**
+ * Uniform pseudo random number in [lo, hi).
+ *
+ * @return double
+ */
+static inline double
+test_uniform(double lo, double hi){
+    return lo + (hi - lo) * (double)(test_rand64() >> 11) / (double)(1ULL << 53);
+}
+
+/**
+ * Report the outcome of the test program.
+ *
+ * @param name  Name of the test program.
+ * @return int  Exit status, 0 when every assertion held.
+ */
+static inline int
+test_report(const char * name){
+    printf("%s: %s\n", name, test_failures ? "FAIL" : "PASS");
+    return test_failures ? 1 : 0;
+}
+
+#endif /* _TEST_H_ */
@@ -0,0 +1,485 @@
+/*
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file test_bulk.c
+ * @brief Host test of the bulk transfer window and SACK state machine
+ *
+ * @details Two device instances run dw1000_bulk.c over a fake air link. Frames committed with dw1000_start_tx_cmd are
+ * queued; air_run completes each transmission on the sender and delivers the frame to the other instance through its
+ * rx_complete_cb, and times out an instance whose frame waits for a response that never arrives. A fault hook drops,
+ * corrupts or repeats frames in flight.
+ *
+ */
+
+#include <string.h>
+#include "../src/dw1000_bulk.c"
+#include "test.h"
+
+#define AIR_QUEUE_LEN   (64)
+#define CHUNK_LEN       (64)
+#define BLOB_LEN        (1000)
+#define NCHUNKS         ((BLOB_LEN + CHUNK_LEN - 1) / CHUNK_LEN)
+
+typedef enum _air_action_t{
+    AIR_DELIVER,
+    AIR_DROP,
+    AIR_CORRUPT,            //!< Flip a payload bit, the frame FCS is assumed to have passed
+    AIR_REPEAT,             //!< Deliver twice
+}air_action_t;
+
+typedef struct _air_frame_t{
+    dw1000_dev_instance_t * src;
+    uint8_t buf[1024];
+    uint16_t len;
+    uint16_t rx_timeout;    //!< The sender times out when the frame is not answered, 0 for none
+}air_frame_t;
+
+typedef air_action_t air_fault_t(const air_frame_t * frame);
+
+static dw1000_dev_instance_t g_dev[2];
+static dw1000_extension_callbacks_t g_ext_cbs[2];
+static uint8_t g_txbuf[2][1024];
+static uint8_t g_rxbuf[2][1024];
+static uint32_t g_tx_frames[2];
+static bool g_waiting[2];           //!< Receiver on for a response, with a timeout
+static uint32_t g_postprocess[2];
+static air_frame_t g_air[AIR_QUEUE_LEN];
+static uint32_t g_air_count;
+static air_fault_t * g_fault;
+static int32_t g_tx_fail;           //!< dw1000_start_tx_cmd calls let through before one fails, -1 for none
+
+static uint8_t g_blob[BLOB_LEN];
+static uint8_t g_rx_blob[BLOB_LEN];
+
+#define IDX(inst) ((inst) == &g_dev[0] ? 0 : 1)
+#define SENDER (&g_dev[0])
+#define RECEIVER (&g_dev[1])
+
+void
+dw1000_add_extension_callbacks(dw1000_dev_instance_t * inst, dw1000_extension_callbacks_t callbacks){
+    g_ext_cbs[IDX(inst)] = callbacks;
+    inst->extension_cb = &g_ext_cbs[IDX(inst)];
+}
+
+void
+dw1000_remove_extension_callbacks(dw1000_dev_instance_t * inst, dw1000_extension_id_t id){
+    inst->extension_cb = NULL;
+}
+
+dw1000_dev_status_t
+dw1000_start_tx_cmd(dw1000_dev_instance_t * inst, const dw1000_mac_cmd_t * cmd){
+    dw1000_dev_status_t status = inst->status;
+
+    if (g_tx_fail >= 0 && g_tx_fail-- == 0){
+        status.start_tx_error = 1;
+        return status;
+    }
+    if (cmd->payload)
+        memcpy(g_txbuf[IDX(inst)], cmd->payload, cmd->frame_len);
+    assert(g_air_count < AIR_QUEUE_LEN);
+    air_frame_t * frame = &g_air[g_air_count++];
+    frame->src = inst;
+    frame->len = cmd->frame_len;
+    frame->rx_timeout = cmd->wait4resp ? cmd->rx_timeout : 0;
+    memcpy(frame->buf, g_txbuf[IDX(inst)], cmd->frame_len);
+    g_tx_frames[IDX(inst)]++;
+    return status;
+}
+
+dw1000_dev_status_t
+dw1000_write_tx(dw1000_dev_instance_t * inst, uint8_t * txFrameBytes, uint16_t txBufferOffset, uint16_t txFrameLength){
+    memcpy(&g_txbuf[IDX(inst)][txBufferOffset], txFrameBytes, txFrameLength);
+    return inst->status;
+}
+
+dw1000_dev_status_t
+dw1000_read(dw1000_dev_instance_t * inst, uint16_t reg, uint16_t subaddress, uint8_t * buffer, uint16_t length){
+    assert(reg == RX_BUFFER_ID);
+    memcpy(buffer, &g_rxbuf[IDX(inst)][subaddress], length);
+    return inst->status;
+}
+
+void
+dw1000_read_rx_frame(dw1000_dev_instance_t * inst, uint8_t * buffer, uint16_t length){
+    memcpy(buffer, g_rxbuf[IDX(inst)], length);
+}
+
+uint64_t
+dw1000_read_txtime(dw1000_dev_instance_t * inst){
+    return 0;
+}
+
+dw1000_dev_status_t
+dw1000_restart_rx(dw1000_dev_instance_t * inst, dw1000_dev_control_t control){
+    return inst->status;
+}
+
+uint32_t dw1000_phy_SHR_duration(dw1000_dev_instance_t * inst){ return 100; }
+uint32_t dw1000_phy_data_duration(dw1000_dev_instance_t * inst, uint16_t nlen){ return nlen; }
+uint32_t dw1000_phy_turnaround_time(dw1000_dev_instance_t * inst, uint16_t rx_nlen){ return 200 + rx_nlen; }
+uint16_t dw1000_phy_wait4resp_timeout(dw1000_dev_instance_t * inst, uint32_t holdoff, uint16_t tx_nlen, uint16_t rx_nlen){ return holdoff + 100; }
+uint32_t dw1000_phy_rx_window_delay(dw1000_dev_instance_t * inst, uint32_t holdoff, uint16_t tx_nlen){ return holdoff / 2; }
+uint16_t dw1000_phy_preamble_timeout(dw1000_dev_instance_t * inst, uint32_t holdoff, uint16_t tx_nlen){ return 8; }
+
+/**
+ * Put a frame on the air: hand it to the receiver and run its rx_complete_cb as the interrupt handler would.
+ */
+static void
+air_deliver(dw1000_dev_instance_t * dst, const air_frame_t * frame){
+    memcpy(g_rxbuf[IDX(dst)], frame->buf, frame->len);
+    dst->frame_len = frame->len;
+    memcpy(dst->fctrl_array, frame->buf, sizeof(dst->fctrl_array));
+    memcpy(dst->cb_data.header, frame->buf, (frame->len < DW1000_MAC_CB_HEADER_LEN) ? frame->len : DW1000_MAC_CB_HEADER_LEN);
+    dst->cb_data.datalength = frame->len;
+    dst->cb_data.rx_timestamp = 0;
+    g_waiting[IDX(dst)] = false;
+    dst->extension_cb->rx_complete_cb(dst);
+}
+
+/**
+ * Is a frame from inst waiting to go on the air.
+ */
+static bool
+air_queued(dw1000_dev_instance_t * inst){
+    for (uint32_t i = 0; i < g_air_count; i++)
+        if (g_air[i].src == inst)
+            return true;
+    return false;
+}
+
+/**
+ * Run the air link until no frame is left in flight. An instance waiting for a response times out once nothing from
+ * its peer is left to deliver.
+ */
+static void
+air_run(void){
+    while (g_air_count){
+        air_frame_t frame = g_air[0];
+        memmove(&g_air[0], &g_air[1], --g_air_count * sizeof(air_frame_t));
+        dw1000_dev_instance_t * src = frame.src;
+        dw1000_dev_instance_t * dst = (src == SENDER) ? RECEIVER : SENDER;
+
+        memcpy(src->fctrl_array, frame.buf, sizeof(src->fctrl_array));
+        src->extension_cb->tx_complete_cb(src);
+        g_waiting[IDX(src)] = frame.rx_timeout != 0;
+
+        air_action_t action = (g_fault) ? g_fault(&frame) : AIR_DELIVER;
+        switch (action){
+            case AIR_DROP:
+                break;
+            case AIR_CORRUPT:
+                frame.buf[frame.len - 1] ^= 0x01;
+                air_deliver(dst, &frame);
+                break;
+            case AIR_REPEAT:
+                air_deliver(dst, &frame);
+                air_deliver(dst, &frame);
+                break;
+            default:
+                air_deliver(dst, &frame);
+                break;
+        }
+        for (int i = 0; i < 2; i++){
+            if (g_waiting[i] && !air_queued(&g_dev[1 - i])){
+                g_waiting[i] = false;
+                g_dev[i].fctrl = FCNTL_IEEE_BULK_16;
+                g_dev[i].extension_cb->rx_timeout_cb(&g_dev[i]);
+            }
+        }
+    }
+}
+
+static uint8_t
+frame_code(const air_frame_t * frame){
+    return frame->buf[offsetof(bulk_data_frame_t, code)];
+}
+
+static uint16_t
+frame_chunk(const air_frame_t * frame){
+    uint16_t chunk;
+    memcpy(&chunk, &frame->buf[offsetof(bulk_data_frame_t, chunk)], sizeof(chunk));
+    return chunk;
+}
+
+static bool
+is_data(const air_frame_t * frame){
+    return frame->src == SENDER && (frame_code(frame) == DWT_BULK_DATA || frame_code(frame) == DWT_BULK_DATA_LAST);
+}
+
+static void
+test_rx_cb(dw1000_dev_instance_t * inst, uint8_t xfer_id, uint32_t offset, const uint8_t * payload, uint16_t len){
+    assert(offset + len <= BLOB_LEN);
+    memcpy(&g_rx_blob[offset], payload, len);
+}
+
+static void
+test_postprocess(struct os_event * ev){
+    g_postprocess[IDX((dw1000_dev_instance_t *) ev->ev_arg)]++;
+}
+
+/**
+ * Fresh sender and receiver, window of 8 chunks, 3 retries.
+ */
+static void
+setup(air_fault_t * fault){
+    dw1000_bulk_config_t config = {
+        .chunk_len = CHUNK_LEN,
+        .window = 8,
+        .max_retries = 3,
+    };
+
+    for (int i = 0; i < 2; i++){
+        if (g_dev[i].bulk)
+            dw1000_bulk_free(&g_dev[i]);
+        memset(&g_dev[i], 0, sizeof(g_dev[i]));
+        g_dev[i].my_short_address = 0x1000 + i;
+        g_dev[i].PANID = 0xDECA;
+        dw1000_bulk_init(&g_dev[i], config);
+        dw1000_bulk_set_postprocess(&g_dev[i], test_postprocess);
+        g_tx_frames[i] = g_postprocess[i] = 0;
+    }
+    dw1000_bulk_set_rx_cb(RECEIVER, test_rx_cb);
+    os_eventq_init(os_eventq_dflt_get());
+
+    for (int i = 0; i < BLOB_LEN; i++)
+        g_blob[i] = test_rand64();
+    memset(g_rx_blob, 0, sizeof(g_rx_blob));
+    g_air_count = 0;
+    g_waiting[0] = g_waiting[1] = false;
+    g_tx_fail = -1;
+    g_fault = fault;
+}
+
+/**
+ * Run windows until the transfer completes, is suspended or max_windows ran.
+ *
+ * @return uint32_t Number of windows run.
+ */
+static uint32_t
+run_transfer(uint32_t max_windows){
+    uint32_t n = 0;
+    dw1000_bulk_status_t status = {0};
+
+    dw1000_bulk_write(SENDER, RECEIVER->my_short_address, 7, g_blob, BLOB_LEN);
+    while (n < max_windows){
+        status = dw1000_bulk_window(SENDER, DWT_NONBLOCKING);
+        if (status.tx_complete || status.suspended)
+            break;
+        n++;
+        air_run();
+        TEST_ASSERT(os_sem_get_count(&SENDER->bulk->sem) == 1, "window %u left in flight", n);
+    }
+    while (os_eventq_dflt_get()->count)
+        os_eventq_run(os_eventq_dflt_get());
+    return n;
+}
+
+static void
+check_complete(void){
+    TEST_ASSERT(SENDER->bulk->status.tx_complete, "sender not complete");
+    TEST_ASSERT(RECEIVER->bulk->status.rx_complete, "receiver not complete");
+    TEST_ASSERT(memcmp(g_blob, g_rx_blob, BLOB_LEN) == 0, "blob differs");
+    TEST_ASSERT(RECEIVER->bulk->stats.rx_chunks == NCHUNKS, "%u chunks delivered", RECEIVER->bulk->stats.rx_chunks);
+    TEST_ASSERT(g_postprocess[0] == 1 && g_postprocess[1] == 1, "postprocess %u %u", g_postprocess[0], g_postprocess[1]);
+}
+
+/**
+ * Clean link: a query, then two full windows each ended by a SACK.
+ */
+static void
+test_bulk_clean(void){
+    setup(NULL);
+    uint32_t windows = run_transfer(20);
+
+    check_complete();
+    TEST_ASSERT(windows == 3, "%u windows", windows);
+    TEST_ASSERT(SENDER->bulk->stats.tx_chunks == NCHUNKS, "%u chunks sent", SENDER->bulk->stats.tx_chunks);
+    TEST_ASSERT(SENDER->bulk->stats.tx_windows == 3, "%u SACKs", SENDER->bulk->stats.tx_windows);
+    TEST_ASSERT(SENDER->bulk->stats.sack_timeouts == 0, "%u timeouts", SENDER->bulk->stats.sack_timeouts);
+}
+
+static air_action_t
+fault_lose_chunks(const air_frame_t * frame){
+    static uint32_t lost;
+    if (frame == NULL)
+        return lost = 0;
+    uint16_t chunk = frame_chunk(frame);
+    if (is_data(frame) && (chunk == 2 || chunk == 5 || chunk == 11) && !(lost & (1UL << chunk))){
+        lost |= 1UL << chunk;
+        return AIR_DROP;
+    }
+    return AIR_DELIVER;
+}
+
+/**
+ * Chunks lost inside a window are reported missing by the SACK and only they are sent again.
+ */
+static void
+test_bulk_lost_chunks(void){
+    fault_lose_chunks(NULL);
+    setup(fault_lose_chunks);
+    run_transfer(20);
+
+    check_complete();
+    TEST_ASSERT(SENDER->bulk->stats.tx_chunks == NCHUNKS + 3, "%u chunks sent", SENDER->bulk->stats.tx_chunks);
+    TEST_ASSERT(SENDER->bulk->stats.sack_timeouts == 0, "%u timeouts", SENDER->bulk->stats.sack_timeouts);
+}
+
+static air_action_t
+fault_corrupt_chunk(const air_frame_t * frame){
+    static bool done;
+    if (frame == NULL)
+        return done = false;
+    if (is_data(frame) && frame_chunk(frame) == 4 && !done){
+        done = true;
+        return AIR_CORRUPT;
+    }
+    return AIR_DELIVER;
+}
+
+/**
+ * A chunk whose payload fails its CRC is dropped undelivered and sent again.
+ */
+static void
+test_bulk_crc(void){
+    fault_corrupt_chunk(NULL);
+    setup(fault_corrupt_chunk);
+    run_transfer(20);
+
+    check_complete();
+    TEST_ASSERT(RECEIVER->bulk->stats.rx_crc_errors == 1, "%u CRC errors", RECEIVER->bulk->stats.rx_crc_errors);
+    TEST_ASSERT(SENDER->bulk->stats.tx_chunks == NCHUNKS + 1, "%u chunks sent", SENDER->bulk->stats.tx_chunks);
+}
+
+static air_action_t
+fault_repeat_chunk(const air_frame_t * frame){
+    return (is_data(frame) && frame_chunk(frame) == 3) ? AIR_REPEAT : AIR_DELIVER;
+}
+
+/**
+ * A chunk received twice is delivered once.
+ */
+static void
+test_bulk_duplicate(void){
+    setup(fault_repeat_chunk);
+    run_transfer(20);
+
+    check_complete();
+    TEST_ASSERT(RECEIVER->bulk->stats.rx_duplicates == 1, "%u duplicates", RECEIVER->bulk->stats.rx_duplicates);
+}
+
+static air_action_t
+fault_lose_sack(const air_frame_t * frame){
+    static uint32_t sacks;
+    if (frame == NULL)
+        return sacks = 0;
+    if (frame->src == RECEIVER && frame_code(frame) == DWT_BULK_SACK && ++sacks == 2)
+        return AIR_DROP;
+    return AIR_DELIVER;
+}
+
+/**
+ * A lost SACK times the window out; the sender queries the receiver state instead of sending the window again.
+ */
+static void
+test_bulk_lost_sack(void){
+    fault_lose_sack(NULL);
+    setup(fault_lose_sack);
+    uint32_t windows = run_transfer(20);
+
+    check_complete();
+    TEST_ASSERT(windows == 4, "%u windows", windows);
+    TEST_ASSERT(SENDER->bulk->stats.sack_timeouts == 1, "%u timeouts", SENDER->bulk->stats.sack_timeouts);
+    TEST_ASSERT(SENDER->bulk->stats.tx_chunks == NCHUNKS, "%u chunks sent", SENDER->bulk->stats.tx_chunks);
+}
+
+static air_action_t
+fault_deaf_receiver(const air_frame_t * frame){
+    return (frame->src == SENDER) ? AIR_DROP : AIR_DELIVER;
+}
+
+/**
+ * max_retries unanswered windows suspend the transfer until dw1000_bulk_resume, which picks it up again.
+ */
+static void
+test_bulk_suspend(void){
+    setup(fault_deaf_receiver);
+    uint32_t windows = run_transfer(20);
+
+    TEST_ASSERT(windows == 3, "%u windows", windows);
+    TEST_ASSERT(SENDER->bulk->status.suspended, "not suspended");
+    TEST_ASSERT(SENDER->bulk->stats.sack_timeouts == 3, "%u timeouts", SENDER->bulk->stats.sack_timeouts);
+
+    uint32_t sent = g_tx_frames[0];
+    dw1000_bulk_window(SENDER, DWT_NONBLOCKING);
+    TEST_ASSERT(g_tx_frames[0] == sent, "suspended transfer sent a frame");
+
+    g_fault = NULL;
+    dw1000_bulk_resume(SENDER);
+    while (!SENDER->bulk->status.tx_complete && windows++ < 20){
+        dw1000_bulk_window(SENDER, DWT_NONBLOCKING);
+        air_run();
+    }
+    while (os_eventq_dflt_get()->count)
+        os_eventq_run(os_eventq_dflt_get());
+    check_complete();
+}
+
+/**
+ * A chunk that fails to start ends the window. Nothing went out when it is the first, past that the next window
+ * learns from the receiver what made it through.
+ */
+static void
+test_bulk_start_tx_error(void){
+    setup(NULL);
+    dw1000_bulk_write(SENDER, RECEIVER->my_short_address, 7, g_blob, BLOB_LEN);
+    dw1000_bulk_window(SENDER, DWT_NONBLOCKING);    // Query
+    air_run();
+
+    g_tx_fail = 0;
+    dw1000_bulk_status_t status = dw1000_bulk_window(SENDER, DWT_NONBLOCKING);
+    TEST_ASSERT(status.start_tx_error, "start_tx_error not reported");
+    TEST_ASSERT(!status.resync, "resync without a chunk sent");
+    TEST_ASSERT(os_sem_get_count(&SENDER->bulk->sem) == 1, "window left in flight");
+
+    g_tx_fail = 1;
+    dw1000_bulk_window(SENDER, DWT_NONBLOCKING);
+    air_run();
+    TEST_ASSERT(SENDER->bulk->status.start_tx_error, "start_tx_error not reported");
+    TEST_ASSERT(SENDER->bulk->status.resync, "no resync after a chunk went out");
+    TEST_ASSERT(os_sem_get_count(&SENDER->bulk->sem) == 1, "window left in flight");
+
+    run_transfer(20);
+    check_complete();
+}
+
+int
+main(void){
+    test_bulk_clean();
+    test_bulk_lost_chunks();
+    test_bulk_crc();
+    test_bulk_duplicate();
+    test_bulk_lost_sack();
+    test_bulk_suspend();
+    test_bulk_start_tx_error();
+    return test_report("test_bulk");
+}
@@ -0,0 +1,211 @@
+/*
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file test_dsp.c
+ * @brief Host test of the fixed point kernels in dw1000_dsp.c
+ *
+ * @details The kernels are run with the coefficient tables of the clock and range services and compared with the
+ * floating point path they replace under DW1000_DSP_FIXEDPOINT. The tables are static in dw1000_ccp.c and
+ * dw1000_rng.c, they are repeated here and have to be kept in step.
+ *
+ */
+
+#include <math.h>
+#include <dw1000/dw1000_dsp.h>
+#include "test.h"
+
+// dw1000_ccp.c, xtal trim loop
+static const int32_t g_fs_xtalt_b_q30[] ={
+     	DW1000_Q(2.160326e-04, 30), DW1000_Q(9.661246e-05, 30), DW1000_Q(2.160326e-04, 30),
+     	DW1000_Q(1.000000e+00, 30), DW1000_Q(-1.302658e+00, 30), DW1000_Q(1.000000e+00, 30),
+     	DW1000_Q(1.000000e+00, 30), DW1000_Q(-1.593398e+00, 30), DW1000_Q(1.000000e+00, 30),
+     	};
+static const int32_t g_fs_xtalt_a_q30[] ={
+     	DW1000_Q(1.000000e+00, 30), DW1000_Q(-1.555858e+00, 30), DW1000_Q(6.083635e-01, 30),
+     	DW1000_Q(1.000000e+00, 30), DW1000_Q(-1.661260e+00, 30), DW1000_Q(7.136943e-01, 30),
+     	DW1000_Q(1.000000e+00, 30), DW1000_Q(-1.836731e+00, 30), DW1000_Q(8.911796e-01, 30),
+     	};
+static const float g_fs_xtalt_b[] ={
+     	2.160326e-04, 9.661246e-05, 2.160326e-04,
+     	1.000000e+00, -1.302658e+00, 1.000000e+00,
+     	1.000000e+00, -1.593398e+00, 1.000000e+00,
+     	};
+static const float g_fs_xtalt_a[] ={
+     	1.000000e+00, -1.555858e+00, 6.083635e-01,
+     	1.000000e+00, -1.661260e+00, 7.136943e-01,
+     	1.000000e+00, -1.836731e+00, 8.911796e-01,
+     	};
+#define FS_XTALT_PPM_SCALE 64
+static const int32_t g_fs_xtalt_poly_q16[] ={
+     	DW1000_Q(3.252948e-03 * FS_XTALT_PPM_SCALE * FS_XTALT_PPM_SCALE, 16), DW1000_Q(-6.641957e-01 * FS_XTALT_PPM_SCALE, 16), DW1000_Q(1.699287e+01, 16),
+     	};
+static const double g_fs_xtalt_poly[] ={
+     	3.252948e-03, -6.641957e-01, 1.699287e+01,
+     	};
+
+// dw1000_rng.c, range bias
+#define RNG_BIAS_PR_CENTRE  (-77)
+#define RNG_BIAS_PR_SCALE   (64)
+static const double rng_bias_poly_PRF64[] ={
+     	1.404476e-03, 3.208478e-01, 2.349322e+01, 5.470342e+02,
+     	};
+static const double rng_bias_poly_PRF16[] ={
+     	1.754924e-05, 4.106182e-03, 3.061584e-01, 7.189425e+00,
+     	};
+static const int32_t rng_bias_poly_PRF64_q16[] ={
+     	DW1000_Q(3.681749565e+02, 16), DW1000_Q(-1.468889498e+01, 16), DW1000_Q(-5.989930163e+01, 16), DW1000_Q(-8.267755080e-01, 16),
+     	};
+static const int32_t rng_bias_poly_PRF16_q16[] ={
+     	DW1000_Q(4.600427971e+00, 16), DW1000_Q(2.142517658e-01, 16), DW1000_Q(-8.988989517e-01, 16), DW1000_Q(-5.102590692e-02, 16),
+     	};
+
+#define NSECTIONS (sizeof(g_fs_xtalt_b_q30)/sizeof(int32_t)/DW1000_BIQUAD_N)
+
+/**
+ * Polynomial in double precision, highest power first, as lib/dsp polyval.
+ */
+static double
+polyval(const double * p, double x, uint16_t n){
+    double acc = p[0];
+    for (uint16_t i = 1; i < n; i++)
+        acc = acc * x + p[i];
+    return acc;
+}
+
+/**
+ * Gaussian pseudo random number, Box-Muller.
+ */
+static double
+test_gauss(double mean, double sigma){
+    double u1 = test_uniform(1e-12, 1.0);
+    double u2 = test_uniform(0.0, 1.0);
+    return mean + sigma * sqrt(-2 * log(u1)) * cos(2 * M_PI * u2);
+}
+
+/**
+ * The xtal offset filter on 5000 noisy samples of ppm in Q16, as dw1000_ccp.c feeds it, against direct form I
+ * sections in double precision on the same samples.
+ */
+static void
+test_sosfilt_xtalt(void){
+    double state[NSECTIONS][4] = {{0}};
+    double max_err = 0;
+    dw1000_sos_q31_instance_t * sos = dw1000_sosfilt_q31_init(NULL, NSECTIONS);
+
+    for (uint32_t i = 0; i < 5000; i++){
+        double ppm = test_gauss((i < 2500) ? 5.0 : -12.0, 2.0);
+        int32_t x_q16 = (int32_t) lround(ppm * 65536);
+        int32_t y_q16 = dw1000_sosfilt_q31(sos, x_q16, g_fs_xtalt_b_q30, g_fs_xtalt_a_q30);
+
+        double x = x_q16 / 65536.0;
+        for (uint16_t k = 0; k < NSECTIONS; k++){
+            const float * b = &g_fs_xtalt_b[k * DW1000_BIQUAD_N];
+            const float * a = &g_fs_xtalt_a[k * DW1000_BIQUAD_N];
+            double * s = state[k];
+            double y = b[0] * x + b[1] * s[0] + b[2] * s[1] - a[1] * s[2] - a[2] * s[3];
+            s[1] = s[0];
+            s[0] = x;
+            s[3] = s[2];
+            s[2] = y;
+            x = y;
+        }
+        double err = fabs(y_q16 / 65536.0 - x);
+        if (err > max_err)
+            max_err = err;
+    }
+    printf("sosfilt_q31: max error %.5f ppm\n", max_err);
+    TEST_ASSERT(max_err <= 0.01, "%.5f ppm", max_err);
+    TEST_ASSERT(sos->clk == 5000, "%u samples", sos->clk);
+    dw1000_sosfilt_q31_free(sos);
+}
+
+/**
+ * Xtal trim codes over -40..40 ppm in steps of 0.01 ppm, worked out as dw1000_ccp.c does in each path. The two may
+ * only part on a rounding boundary of the trim polynomial.
+ */
+static void
+test_polyval_trim(void){
+    const uint16_t n = sizeof(g_fs_xtalt_poly_q16)/sizeof(int32_t);
+    uint32_t differ = 0;
+
+    for (int32_t i = -4000; i <= 4000; i++){
+        int32_t offset_q16 = (int32_t) lround(i * 0.01 * 65536);
+        int32_t u = offset_q16 / (FS_XTALT_PPM_SCALE << 1);
+        u = (u < INT16_MIN) ? INT16_MIN : (u > INT16_MAX) ? INT16_MAX : u;
+        int32_t trim_q16 = dw1000_polyval_q15(g_fs_xtalt_poly_q16, u, n) - g_fs_xtalt_poly_q16[n - 1];
+        int8_t trim_code = (int8_t)((trim_q16 + (1 << 15)) >> 16);
+
+        int8_t ref = (int8_t) roundf(polyval(g_fs_xtalt_poly, offset_q16 / 65536.0, n) - polyval(g_fs_xtalt_poly, 0, n));
+        TEST_ASSERT(abs(trim_code - ref) <= 1, "%d against %d at %.2f ppm", trim_code, ref, i * 0.01);
+        differ += trim_code != ref;
+    }
+    printf("polyval_q15 trim: %u of 8001 codes differ\n", differ);
+    TEST_ASSERT(differ <= 3, "%u codes", differ);
+}
+
+/**
+ * Range bias over -127..-14 dBm in steps of 1/256 dB, the argument formed as dw1000_rng_bias_correction_q16 does,
+ * against the bias polynomials of both PRFs in double precision. Single precision cannot serve as the reference, the
+ * PRF64 terms cancel to within 1e-4 m of its rounding.
+ */
+static void
+test_polyval_bias(void){
+    double max_err = 0;
+
+    for (int32_t pr_q8 = -127 * 256; pr_q8 <= -14 * 256; pr_q8++){
+        int32_t u = (pr_q8 - (RNG_BIAS_PR_CENTRE << 8)) * (1 << 7) / RNG_BIAS_PR_SCALE;
+        u = (u < INT16_MIN) ? INT16_MIN : (u > INT16_MAX) ? INT16_MAX : u;
+        double err16 = fabs(dw1000_polyval_q15(rng_bias_poly_PRF16_q16, u, 4) / 65536.0
+                     - polyval(rng_bias_poly_PRF16, pr_q8 / 256.0, 4));
+        double err64 = fabs(dw1000_polyval_q15(rng_bias_poly_PRF64_q16, u, 4) / 65536.0
+                     - polyval(rng_bias_poly_PRF64, pr_q8 / 256.0, 4));
+        max_err = fmax(max_err, fmax(err16, err64));
+    }
+    printf("polyval_q15 bias: max error %.2e m\n", max_err);
+    TEST_ASSERT(max_err <= 5e-5, "%.2e m", max_err);
+}
+
+/**
+ * log2 in Q8 against libm over powers of two and random arguments up to 2^48.
+ */
+static void
+test_log2_q8(void){
+    double max_err = 0;
+
+    for (uint32_t i = 0; i < 100000; i++){
+        uint64_t x = (i < 48) ? 1ULL << i : 1 + (test_rand64() >> (16 + i % 48));
+        double err = fabs(dw1000_log2_q8(x) / 256.0 - log2((double) x));
+        if (err > max_err)
+            max_err = err;
+    }
+    printf("log2_q8: max error %.4f\n", max_err);
+    TEST_ASSERT(max_err <= 0.005, "%.4f", max_err);
+}
+
+int
+main(void){
+    test_sosfilt_xtalt();
+    test_polyval_trim();
+    test_polyval_bias();
+    test_log2_q8();
+    return test_report("test_dsp");
+}
@@ -0,0 +1,149 @@
+/*
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file test_mac.c
+ * @brief Host test of the fixed point arithmetic in dw1000_mac.c
+ *
+ * @details The MAC is built against a fake register file: dw1000_read_reg returns g_reg, the rest of the device
+ * access is dropped. The results are compared with the floating point computation they replace.
+ *
+ */
+
+#include <math.h>
+#include "../src/dw1000_mac.c"
+#include "test.h"
+
+static uint64_t g_reg;      //!< Value returned by every register read
+
+uint64_t
+dw1000_read_reg(dw1000_dev_instance_t * inst, uint16_t reg, uint16_t subaddress, size_t nsize){
+    return (nsize < sizeof(uint64_t)) ? g_reg & ((1ULL << (nsize * 8)) - 1) : g_reg;
+}
+
+void
+dw1000_write_reg(dw1000_dev_instance_t * inst, uint16_t reg, uint16_t subaddress, uint64_t val, size_t nsize){
+}
+
+dw1000_dev_status_t
+dw1000_read(dw1000_dev_instance_t * inst, uint16_t reg, uint16_t subaddress, uint8_t * buffer, uint16_t length){
+    memset(buffer, 0, length);
+    return inst->status;
+}
+
+dw1000_dev_status_t
+dw1000_write(dw1000_dev_instance_t * inst, uint16_t reg, uint16_t subaddress, uint8_t * buffer, uint16_t length){
+    return inst->status;
+}
+
+void dw1000_phy_sysclk_ACC(struct _dw1000_dev_instance_t * inst, uint8_t mode){}
+void dw1000_phy_config_lde(struct _dw1000_dev_instance_t * inst, int prfIndex){}
+void dw1000_phy_rx_reset(struct _dw1000_dev_instance_t * inst){}
+void dw1000_phy_forcetrxoff(struct _dw1000_dev_instance_t * inst){}
+void dw1000_phy_interrupt_mask(struct _dw1000_dev_instance_t * inst, uint32_t bitmask, uint8_t enable){}
+uint32_t dw1000_phy_SHR_duration(struct _dw1000_dev_instance_t * inst){ return 0; }
+uint32_t dw1000_phy_data_duration(struct _dw1000_dev_instance_t * inst, uint16_t nlen){ return 0; }
+
+static dw1000_dev_instance_t g_inst;
+static dw1000_ccp_instance_t g_ccp;
+static clkcal_instance_t g_clkcal;
+
+/**
+ * Timestamps scaled by the Q40 skew against time * skew in extended precision, for skews within +-100 ppm. A new
+ * skew is published every 1000 reads so the cached Q40 value is rederived as well.
+ */
+static void
+test_apply_skew(void){
+    long double max_err = 0;
+
+    g_inst.ccp = &g_ccp;
+    g_ccp.clkcal = &g_clkcal;
+    g_clkcal.status.valid = 1;
+
+    for (uint32_t i = 0; i < 1000000; i++){
+        if (i % 1000 == 0)
+            g_clkcal.skew = 1.0 + test_uniform(-100e-6, 100e-6);
+        g_reg = test_rand64() & 0x0FFFFFFFFFFULL;
+
+        long double ref = fmodl((long double) g_reg * g_clkcal.skew, (long double)(1ULL << 40));
+        long double err = fabsl((long double) dw1000_read_rxtime(&g_inst) - ref);
+        if (err > (1ULL << 39))
+            err = (long double)(1ULL << 40) - err;      // Either side of the 40-bit wrap
+        if (err > max_err)
+            max_err = err;
+    }
+    printf("apply_skew: max error %.3Lf dtu\n", max_err);
+    TEST_ASSERT(max_err < 1.0, "%.3Lf dtu", max_err);
+}
+
+/**
+ * Receive and first path power levels in Q8 against the libm formulas, 10 * log10(C * 2^17 / N^2) - A and
+ * 10 * log10((F1^2 + F2^2 + F3^2) / N^2) - A, over random diagnostic sets at both PRFs. Sets whose level is outside
+ * the int16_t range of the result are skipped, the Q8 functions saturate there.
+ */
+static void
+test_pwr_q8(void){
+    double max_err = 0;
+    uint32_t checked = 0;
+
+    g_inst.config.rxdiag_enable = 1;
+    for (uint32_t i = 0; i < 200000; i++){
+        dw1000_dev_rxdiag_t * diag = &g_inst.rxdiag;
+        g_inst.config.prf = (i & 1) ? DWT_PRF_64M : DWT_PRF_16M;
+        diag->cir_pwr = 1 + test_rand64() % UINT16_MAX;
+        diag->pacc_cnt = 1 + test_rand64() % 2047;
+        diag->fp_amp = test_rand64();
+        diag->fp_amp2 = test_rand64();
+        diag->fp_amp3 = test_rand64();
+
+        double A = (g_inst.config.prf == DWT_PRF_16M) ? 115.72 : 122.74;
+        double N2 = (double) diag->pacc_cnt * diag->pacc_cnt;
+        double F2 = (double) diag->fp_amp * diag->fp_amp + (double) diag->fp_amp2 * diag->fp_amp2
+                  + (double) diag->fp_amp3 * diag->fp_amp3;
+        double ref[2] = {
+            10 * log10(diag->cir_pwr * 131072.0 / N2) - A,
+            10 * log10(F2 / N2) - A
+        };
+        int16_t q8[2] = {dw1000_get_rssi_q8(&g_inst), dw1000_get_fppl_q8(&g_inst)};
+
+        for (int k = 0; k < 2; k++){
+            if (F2 == 0 || ref[k] <= INT16_MIN / 256.0 || ref[k] >= INT16_MAX / 256.0)
+                continue;
+            double err = fabs(q8[k] / 256.0 - ref[k]);
+            if (err > max_err)
+                max_err = err;
+            checked++;
+        }
+    }
+    printf("pwr_q8: max error %.4f dB over %u levels\n", max_err, checked);
+    TEST_ASSERT(max_err <= 0.035, "%.4f dB", max_err);
+
+    g_inst.config.rxdiag_enable = 0;
+    TEST_ASSERT(dw1000_get_rssi_q8(&g_inst) == INT16_MIN, "without diagnostics");
+    TEST_ASSERT(dw1000_get_fppl_q8(&g_inst) == INT16_MIN, "without diagnostics");
+}
+
+int
+main(void){
+    test_apply_skew();
+    test_pwr_q8();
+    return test_report("test_mac");
+}
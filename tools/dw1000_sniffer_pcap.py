@@ -0,0 +1,166 @@
+#!/usr/bin/env python3
+#
+# Copyright 2018, Decawave Limited, All Rights Reserved
+#
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#  http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+#
+
+"""
+Convert the record stream of the dw1000 sniffer role to pcap.
+
+The input is the byte stream written by the sniffer output callback, a
+sequence of dw1000_sniffer_record_t headers each followed by caplen bytes
+of frame, see dw1000/include/dw1000/dw1000_sniffer.h. The output uses
+LINKTYPE_IEEE802_15_4_TAP, so the FCS type, channel, receive level and
+RX timestamp travel with every frame and Wireshark checks the FCS.
+
+The RX timestamp is the 40-bit device time, it wraps every 17.2 s. The
+packet times are the timestamps unwrapped from the first record on,
+added to --epoch; a gap of more than one wrap between two frames cannot
+be seen in the stream and shortens the time line.
+
+    dw1000_sniffer_pcap.py capture.bin capture.pcap
+    cat /dev/ttyACM0 | dw1000_sniffer_pcap.py - - | wireshark -k -i -
+"""
+
+import argparse
+import math
+import struct
+import sys
+
+DW1000_SNIFFER_SYNC = 0xA55A
+RECORD = struct.Struct('<HHH5sBBBHHHHHHHH')     # dw1000_sniffer_record_t, packed, little endian
+
+DW1000_MAC_CB_RX_FLAG_RNG = 1 << 0
+DWT_PRF_16M = 1
+DWT_PRF_64M = 2
+
+LINKTYPE_IEEE802_15_4_TAP = 283
+TAP_FCS_TYPE = 0
+TAP_RSS = 1
+TAP_CHANNEL_ASSIGNMENT = 3
+TAP_SOF_TS = 5
+TAP_FCS_16BIT = 1
+TAP_CHANNEL_PAGE_UWB = 4
+
+DTU_PER_SEC = 499.2e6 * 128                     # 15.65 ps device time unit
+DTU_WRAP = 1 << 40
+
+
+def tlv(tlv_type, value):
+    """ One TAP TLV, the value padded to a multiple of 4 bytes. """
+    pad = (4 - len(value) % 4) % 4
+    return struct.pack('<HH', tlv_type, len(value)) + value + b'\x00' * pad
+
+
+def rx_level(cir_pwr, pacc_cnt, prf):
+    """ Estimated receive level in dBm, DW1000 User Manual 4.7.2, None without diagnostics. """
+    if cir_pwr == 0 or pacc_cnt == 0:
+        return None
+    a = 121.74 if prf == DWT_PRF_64M else 113.77
+    return 10 * math.log10(cir_pwr * (1 << 17) / (pacc_cnt * pacc_cnt)) - a
+
+
+def tap_header(channel, prf, rx_ns, cir_pwr, pacc_cnt):
+    tlvs = tlv(TAP_FCS_TYPE, struct.pack('<B', TAP_FCS_16BIT))
+    tlvs += tlv(TAP_CHANNEL_ASSIGNMENT, struct.pack('<HB', channel, TAP_CHANNEL_PAGE_UWB))
+    level = rx_level(cir_pwr, pacc_cnt, prf)
+    if level is not None:
+        tlvs += tlv(TAP_RSS, struct.pack('<f', level))
+    tlvs += tlv(TAP_SOF_TS, struct.pack('<Q', rx_ns))
+    return struct.pack('<BBH', 0, 0, 4 + len(tlvs)) + tlvs
+
+
+def records(stream):
+    """ Yield (header fields, frame) for every record, resynchronising on the sync word after a corrupt record. """
+    buf = b''
+    sync = struct.pack('<H', DW1000_SNIFFER_SYNC)
+    read = getattr(stream, 'read1', stream.read)
+    while True:
+        chunk = read(4096)
+        if chunk:
+            buf += chunk
+        while True:
+            i = buf.find(sync)
+            if i < 0:
+                buf = buf[-1:]
+                break
+            buf = buf[i:]
+            if len(buf) < RECORD.size:
+                break
+            fields = RECORD.unpack_from(buf)
+            caplen, length = fields[1], fields[2]
+            if caplen > length or length > 1023 + 2:
+                buf = buf[1:]           # Not a record header, search for the next sync word
+                continue
+            if len(buf) < RECORD.size + caplen:
+                break
+            yield fields, buf[RECORD.size:RECORD.size + caplen]
+            buf = buf[RECORD.size + caplen:]
+        if not chunk:
+            return
+
+
+def convert(src, dst, epoch, verbose):
+    # pcap global header, nanosecond resolution
+    dst.write(struct.pack('<IHHiIII', 0xA1B23C4D, 2, 4, 0, 0, 65535, LINKTYPE_IEEE802_15_4_TAP))
+    last = None
+    elapsed = 0
+    frames = overruns = 0
+    for fields, frame in records(src):
+        (_, caplen, length, ts, channel, prf, flags, lost,
+         fp_idx, fp_amp, fp_amp2, fp_amp3, rx_std, cir_pwr, pacc_cnt) = fields
+        dtu = int.from_bytes(ts, 'little')
+        if last is None:
+            last = dtu
+        elapsed += (dtu - last) % DTU_WRAP
+        last = dtu
+        rx_ns = int(round(dtu * 1e9 / DTU_PER_SEC))
+        t_ns = int(epoch * 1e9) + int(round(elapsed * 1e9 / DTU_PER_SEC))
+
+        tap = tap_header(channel, prf, rx_ns, cir_pwr, pacc_cnt)
+        dst.write(struct.pack('<IIII', t_ns // 1000000000, t_ns % 1000000000, len(tap) + caplen, len(tap) + length))
+        dst.write(tap)
+        dst.write(frame)
+
+        frames += 1
+        overruns += lost
+        if verbose:
+            sys.stderr.write('%10.6f ch%d %s len %4d%s fp_idx %7.2f rx_std %5d lost %d\n' % (
+                elapsed / DTU_PER_SEC, channel, '64M' if prf == DWT_PRF_64M else '16M', length,
+                ' rng' if flags & DW1000_MAC_CB_RX_FLAG_RNG else '    ', fp_idx / 64.0, rx_std, lost))
+    dst.flush()
+    return frames, overruns
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Convert a dw1000 sniffer record stream to pcap')
+    parser.add_argument('input', help="record stream, '-' for stdin")
+    parser.add_argument('output', help="pcap file, '-' for stdout")
+    parser.add_argument('--epoch', type=float, default=0.0, help='packet time of the first record, in seconds')
+    parser.add_argument('-v', '--verbose', action='store_true', help='print a line per record to stderr')
+    args = parser.parse_args()
+
+    src = sys.stdin.buffer if args.input == '-' else open(args.input, 'rb')
+    dst = sys.stdout.buffer if args.output == '-' else open(args.output, 'wb')
+    frames, overruns = convert(src, dst, args.epoch, args.verbose)
+    sys.stderr.write('%d frames, %d lost to overruns\n' % (frames, overruns))
+
+
+if __name__ == '__main__':
+    main()